@@ -0,0 +1,230 @@
+// The parts of the device OS the app relies on, for host builds: exceptions, NVRAM, key derivation and the
+// globals the SDK defines.
+
+#include "host.h"
+
+#include "os.h"
+#include "os_io_seproxyhal.h"
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/obj_mac.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+volatile io_apdu_media_t G_io_apdu_media = IO_APDU_MEDIA_USB_HID;
+
+unsigned int app_stack_canary;
+
+// Exceptions
+
+static try_context_t *current_try_context;
+
+try_context_t *try_context_get(void) {
+    return current_try_context;
+}
+
+try_context_t *try_context_set(try_context_t *const context) {
+    try_context_t *const previous = current_try_context;
+    current_try_context = context;
+    return previous;
+}
+
+void os_longjmp(unsigned int const exception) {
+    if (current_try_context == NULL) {
+        fprintf(stderr, "Uncaught exception 0x%04x\n", exception);
+        exit(EXIT_FAILURE);
+    }
+    longjmp(current_try_context->jmp_buf, exception);
+}
+
+// System
+
+void (*host_nvram_written)(void);
+
+void nvm_write(void *const dst_adr, void *const src_adr, unsigned int const src_len) {
+    if (src_adr == NULL) {
+        memset(dst_adr, 0, src_len);
+    } else {
+        memmove(dst_adr, src_adr, src_len);
+    }
+    if (host_nvram_written != NULL) host_nvram_written();
+}
+
+void os_sched_exit(unsigned int const exit_code) {
+    exit(exit_code == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+// Display and transport calls that the host build has no use for
+
+void io_seproxyhal_display_default(bagl_element_t *const element) {
+    (void)element;
+}
+
+unsigned int os_ux_blocking(bolos_ux_params_t *const params) {
+    (void)params;
+    return 0;
+}
+
+void io_seproxyhal_spi_send(const unsigned char *const buffer, unsigned short const length) {
+    (void)buffer;
+    (void)length;
+    THROW(INVALID_PARAMETER);
+}
+
+unsigned short io_seproxyhal_spi_recv(unsigned char *const buffer, unsigned short const maxlength, unsigned int const flags) {
+    (void)buffer;
+    (void)maxlength;
+    (void)flags;
+    THROW(INVALID_PARAMETER);
+}
+
+void reset(void) {
+    THROW(EXCEPTION_IO_RESET);
+}
+
+// Key derivation (SLIP-10, which is BIP-32 for secp256k1)
+
+#define HARDENED 0x80000000u
+#define SEED_SIZE 64
+
+static uint8_t seed[SEED_SIZE];
+static bool seed_set;
+
+void host_set_mnemonic(char const *const mnemonic) {
+    // BIP-39, without a passphrase
+    static char const salt[] = "mnemonic";
+    if (PKCS5_PBKDF2_HMAC(mnemonic, strlen(mnemonic), (unsigned char const *)salt, sizeof(salt) - 1, 2048,
+                          EVP_sha512(), sizeof(seed), seed) != 1) {
+        THROW(EXCEPTION);
+    }
+    seed_set = true;
+}
+
+struct node {
+    uint8_t key[32];
+    uint8_t chain_code[32];
+};
+
+static void hmac_sha512(uint8_t out[64], void const *const key, size_t const key_size, void const *const data, size_t const size) {
+    unsigned int out_size = 64;
+    if (HMAC(EVP_sha512(), key, key_size, data, size, out, &out_size) == NULL) THROW(EXCEPTION);
+}
+
+// Makes `key` the private key `tweak` + `parent` modulo the order of the curve, if that is a valid one.
+static bool add_private_keys(
+    cx_curve_t const curve, uint8_t key[32], uint8_t const tweak[32], uint8_t const *const parent
+) {
+    EC_GROUP *const group = EC_GROUP_new_by_curve_name(
+        curve == CX_CURVE_SECP256K1 ? NID_secp256k1 : NID_X9_62_prime256v1);
+    BN_CTX *const bn = BN_CTX_new();
+    if (group == NULL || bn == NULL) THROW(EXCEPTION);
+    BN_CTX_start(bn);
+    BIGNUM *const order = BN_CTX_get(bn);
+    BIGNUM *const sum = BN_CTX_get(bn);
+    BIGNUM *const addend = BN_CTX_get(bn);
+    if (addend == NULL || EC_GROUP_get_order(group, order, bn) != 1 || BN_bin2bn(tweak, 32, sum) == NULL) {
+        THROW(EXCEPTION);
+    }
+
+    bool valid = BN_cmp(sum, order) < 0;
+    if (valid && parent != NULL) {
+        if (BN_bin2bn(parent, 32, addend) == NULL || BN_mod_add(sum, sum, addend, order, bn) != 1) THROW(EXCEPTION);
+    }
+    valid = valid && !BN_is_zero(sum) && BN_bn2binpad(sum, key, 32) == 32;
+
+    BN_CTX_end(bn);
+    BN_CTX_free(bn);
+    EC_GROUP_free(group);
+    return valid;
+}
+
+static void master_node(struct node *const out, cx_curve_t const curve, char const *const seed_key) {
+    if (!seed_set) host_set_mnemonic(HOST_DEFAULT_MNEMONIC);
+
+    uint8_t i[64];
+    hmac_sha512(i, seed_key, strlen(seed_key), seed, sizeof(seed));
+    while (curve != CX_CURVE_Ed25519 && !add_private_keys(curve, out->key, i, NULL)) {
+        hmac_sha512(i, seed_key, strlen(seed_key), i, sizeof(i));
+    }
+    if (curve == CX_CURVE_Ed25519) memcpy(out->key, i, 32);
+    memcpy(out->chain_code, i + 32, 32);
+    explicit_bzero(i, sizeof(i));
+}
+
+static void child_node(struct node *const node, cx_curve_t const curve, uint32_t const index) {
+    uint8_t data[1 + 32 + 1 + 4];
+    size_t size;
+    if (index & HARDENED) {
+        data[0] = 0;
+        memcpy(data + 1, node->key, 32);
+        size = 33;
+    } else {
+        cx_ecfp_private_key_t private_key;
+        cx_ecfp_public_key_t public_key;
+        cx_ecfp_init_private_key(curve, node->key, sizeof(node->key), &private_key);
+        cx_ecfp_generate_pair(curve, &public_key, &private_key, 1);
+        explicit_bzero(&private_key, sizeof(private_key));
+        data[0] = 0x02 + (public_key.W[64] & 1);
+        memcpy(data + 1, public_key.W + 1, 32);
+        size = 33;
+    }
+    for (size_t b = 0; b < 4; b++) data[size++] = index >> (24 - 8 * b);
+
+    uint8_t i[64];
+    hmac_sha512(i, node->chain_code, sizeof(node->chain_code), data, size);
+    if (curve == CX_CURVE_Ed25519) {
+        memcpy(node->key, i, 32);
+    } else {
+        while (!add_private_keys(curve, node->key, i, node->key)) {
+            data[0] = 1;
+            memcpy(data + 1, i + 32, 32);
+            hmac_sha512(i, node->chain_code, sizeof(node->chain_code), data, 37);
+        }
+    }
+    memcpy(node->chain_code, i + 32, 32);
+    explicit_bzero(i, sizeof(i));
+    explicit_bzero(data, sizeof(data));
+}
+
+void os_perso_derive_node_bip32_seed_key(
+    unsigned int const mode, cx_curve_t const curve, const unsigned int *const path, unsigned int const pathLength,
+    unsigned char *const privateKey, unsigned char *const chain, unsigned char *const seed_key,
+    unsigned int const seed_key_length
+) {
+    char const *key;
+    if (seed_key != NULL) {
+        (void)seed_key_length;
+        THROW(INVALID_PARAMETER); // The app always uses the curve's own
+    } else if (curve == CX_CURVE_Ed25519 && mode == HDW_ED25519_SLIP10) {
+        key = "ed25519 seed";
+    } else if (curve == CX_CURVE_SECP256K1 && mode == HDW_NORMAL) {
+        key = "Bitcoin seed";
+    } else if (curve == CX_CURVE_SECP256R1 && mode == HDW_NORMAL) {
+        key = "Nist256p1 seed";
+    } else {
+        THROW(INVALID_PARAMETER);
+    }
+
+    struct node node;
+    master_node(&node, curve, key);
+    for (unsigned int i = 0; i < pathLength; i++) {
+        // SLIP-10 only has hardened Ed25519 keys, so the device hardens every component.
+        child_node(&node, curve, curve == CX_CURVE_Ed25519 ? path[i] | HARDENED : path[i]);
+    }
+
+    if (privateKey != NULL) memcpy(privateKey, node.key, sizeof(node.key));
+    if (chain != NULL) memcpy(chain, node.chain_code, sizeof(node.chain_code));
+    explicit_bzero(&node, sizeof(node));
+}
+
+void os_perso_derive_node_bip32(
+    cx_curve_t const curve, const unsigned int *const path, unsigned int const pathLength,
+    unsigned char *const privateKey, unsigned char *const chain
+) {
+    os_perso_derive_node_bip32_seed_key(HDW_NORMAL, curve, path, pathLength, privateKey, chain, NULL, 0);
+}
@@ -0,0 +1,356 @@
+// Software implementation of the SDK cryptography the app uses, for host builds. BLAKE2b is implemented here;
+// everything else is done with OpenSSL's libcrypto.
+
+#include "cx.h"
+
+#include "os.h"
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/obj_mac.h>
+#include <openssl/sha.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+// BLAKE2b (RFC 7693), unkeyed.
+
+static const uint64_t blake2b_iv[8] = {
+    0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+    0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
+};
+
+static const uint8_t blake2b_sigma[12][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+};
+
+static inline uint64_t rotate_right(uint64_t const x, unsigned const n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+static inline void blake2b_mix(uint64_t v[16], size_t a, size_t b, size_t c, size_t d, uint64_t x, uint64_t y) {
+    v[a] = v[a] + v[b] + x;
+    v[d] = rotate_right(v[d] ^ v[a], 32);
+    v[c] = v[c] + v[d];
+    v[b] = rotate_right(v[b] ^ v[c], 24);
+    v[a] = v[a] + v[b] + y;
+    v[d] = rotate_right(v[d] ^ v[a], 16);
+    v[c] = v[c] + v[d];
+    v[b] = rotate_right(v[b] ^ v[c], 63);
+}
+
+static void blake2b_compress(cx_blake2b_t *const state, bool const last) {
+    uint64_t m[16];
+    for (size_t i = 0; i < 16; i++) {
+        m[i] = 0;
+        for (size_t j = 8; j-- > 0;) m[i] = (m[i] << 8) | state->block[i * 8 + j];
+    }
+
+    uint64_t v[16];
+    for (size_t i = 0; i < 8; i++) {
+        v[i] = state->h[i];
+        v[i + 8] = blake2b_iv[i];
+    }
+    v[12] ^= state->t[0];
+    v[13] ^= state->t[1];
+    if (last) v[14] = ~v[14];
+
+    for (size_t round = 0; round < 12; round++) {
+        uint8_t const *const s = blake2b_sigma[round];
+        blake2b_mix(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        blake2b_mix(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        blake2b_mix(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        blake2b_mix(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        blake2b_mix(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        blake2b_mix(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        blake2b_mix(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        blake2b_mix(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (size_t i = 0; i < 8; i++) state->h[i] ^= v[i] ^ v[i + 8];
+}
+
+static void blake2b_count(cx_blake2b_t *const state, size_t const bytes) {
+    state->t[0] += bytes;
+    if (state->t[0] < bytes) state->t[1]++;
+}
+
+int cx_blake2b_init(cx_blake2b_t *const hash, unsigned int const size) {
+    if (size == 0 || size > 512 || size % 8 != 0) THROW(INVALID_PARAMETER);
+    memset(hash, 0, sizeof(*hash));
+    hash->header.algo = CX_BLAKE2B;
+    hash->output_size = size / 8;
+    memcpy(hash->h, blake2b_iv, sizeof(hash->h));
+    hash->h[0] ^= 0x01010000 ^ hash->output_size;
+    return CX_BLAKE2B;
+}
+
+int cx_hash(
+    cx_hash_t *const hash, int const mode, const unsigned char *in, unsigned int len,
+    unsigned char *const out, unsigned int const out_len
+) {
+    if (hash->algo != CX_BLAKE2B) THROW(INVALID_PARAMETER);
+    cx_blake2b_t *const state = (cx_blake2b_t *)hash;
+
+    while (len > 0) {
+        // The last block is only compressed once it's known not to be the final one.
+        if (state->block_length == sizeof(state->block)) {
+            blake2b_count(state, sizeof(state->block));
+            blake2b_compress(state, false);
+            state->block_length = 0;
+        }
+        size_t const n = len < sizeof(state->block) - state->block_length
+            ? len
+            : sizeof(state->block) - state->block_length;
+        memcpy(state->block + state->block_length, in, n);
+        state->block_length += n;
+        in += n;
+        len -= n;
+    }
+    hash->counter++;
+
+    if (!(mode & CX_LAST)) return 0;
+    if (out_len < state->output_size) THROW(INVALID_PARAMETER);
+    blake2b_count(state, state->block_length);
+    memset(state->block + state->block_length, 0, sizeof(state->block) - state->block_length);
+    blake2b_compress(state, true);
+    for (size_t i = 0; i < state->output_size; i++) out[i] = state->h[i / 8] >> (8 * (i % 8));
+    return state->output_size;
+}
+
+// SHA-2
+
+int cx_hash_sha256(const unsigned char *const in, unsigned int const len, unsigned char *const out, unsigned int const out_len) {
+    if (out_len < CX_SHA256_SIZE) THROW(INVALID_PARAMETER);
+    SHA256(in, len, out);
+    return CX_SHA256_SIZE;
+}
+
+int cx_hash_sha512(const unsigned char *const in, unsigned int const len, unsigned char *const out, unsigned int const out_len) {
+    if (out_len < CX_SHA512_SIZE) THROW(INVALID_PARAMETER);
+    SHA512(in, len, out);
+    return CX_SHA512_SIZE;
+}
+
+int cx_hmac_sha256(
+    const unsigned char *const key, unsigned int const key_len, const unsigned char *const in, unsigned int const len,
+    unsigned char *const mac, unsigned int const mac_len
+) {
+    if (mac_len < CX_SHA256_SIZE) THROW(INVALID_PARAMETER);
+    unsigned int size = mac_len;
+    if (HMAC(EVP_sha256(), key, key_len, in, len, mac, &size) == NULL) THROW(EXCEPTION);
+    return size;
+}
+
+// Elliptic curves
+
+static int curve_nid(cx_curve_t const curve) {
+    switch (curve) {
+        case CX_CURVE_SECP256K1: return NID_secp256k1;
+        case CX_CURVE_SECP256R1: return NID_X9_62_prime256v1;
+        default: THROW(INVALID_PARAMETER);
+    }
+}
+
+int cx_ecfp_init_private_key(
+    cx_curve_t const curve, const unsigned char *const rawkey, unsigned int const key_len,
+    cx_ecfp_private_key_t *const pvkey
+) {
+    if (key_len != sizeof(pvkey->d)) THROW(INVALID_PARAMETER);
+    pvkey->curve = curve;
+    pvkey->d_len = key_len;
+    memcpy(pvkey->d, rawkey, key_len);
+    return key_len;
+}
+
+static void ed25519_public_key(cx_ecfp_public_key_t *const pubkey, cx_ecfp_private_key_t const *const privkey) {
+    EVP_PKEY *const key = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, NULL, privkey->d, privkey->d_len);
+    size_t size = 32;
+    bool const ok = key != NULL && EVP_PKEY_get_raw_public_key(key, pubkey->W + 1, &size) == 1 && size == 32;
+    EVP_PKEY_free(key);
+    if (!ok) THROW(EXCEPTION);
+    pubkey->W[0] = 0x04;
+    pubkey->W_len = 33;
+}
+
+static void weierstrass_public_key(cx_ecfp_public_key_t *const pubkey, cx_ecfp_private_key_t const *const privkey) {
+    EC_GROUP *const group = EC_GROUP_new_by_curve_name(curve_nid(privkey->curve));
+    EC_POINT *const point = group != NULL ? EC_POINT_new(group) : NULL;
+    BIGNUM *const d = BN_bin2bn(privkey->d, privkey->d_len, NULL);
+    bool const ok = point != NULL && d != NULL
+        && EC_POINT_mul(group, point, d, NULL, NULL, NULL) == 1
+        && EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, pubkey->W, sizeof(pubkey->W), NULL) == 65;
+    BN_clear_free(d);
+    EC_POINT_free(point);
+    EC_GROUP_free(group);
+    if (!ok) THROW(EXCEPTION);
+    pubkey->W_len = 65;
+}
+
+int cx_ecfp_generate_pair(
+    cx_curve_t const curve, cx_ecfp_public_key_t *const pubkey, cx_ecfp_private_key_t *const privkey,
+    int const keepprivate
+) {
+    // The app always derives its keys, so there is never a private key to make up.
+    if (!keepprivate || privkey->curve != curve) THROW(INVALID_PARAMETER);
+    pubkey->curve = curve;
+    if (curve == CX_CURVE_Ed25519) {
+        ed25519_public_key(pubkey, privkey);
+    } else {
+        weierstrass_public_key(pubkey, privkey);
+    }
+    return 0;
+}
+
+void cx_edward_compress_point(cx_curve_t const curve, unsigned char *const P, unsigned int const P_len) {
+    if (curve != CX_CURVE_Ed25519 || P_len < 33 || P[0] != 0x04) THROW(INVALID_PARAMETER);
+    P[0] = 0x02;
+}
+
+int cx_eddsa_sign(
+    const cx_ecfp_private_key_t *const pvkey, int const mode, cx_md_t const hashID,
+    const unsigned char *const hash, unsigned int const hash_len,
+    const unsigned char *const ctx, unsigned int const ctx_len,
+    unsigned char *const sig, unsigned int const sig_len, unsigned int *const info
+) {
+    (void)mode;
+    (void)ctx;
+    if (pvkey->curve != CX_CURVE_Ed25519 || hashID != CX_SHA512 || ctx_len != 0 || sig_len < 64) {
+        THROW(INVALID_PARAMETER);
+    }
+
+    EVP_PKEY *const key = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, NULL, pvkey->d, pvkey->d_len);
+    EVP_MD_CTX *const md = EVP_MD_CTX_new();
+    size_t size = sig_len;
+    bool const ok = key != NULL && md != NULL
+        && EVP_DigestSignInit(md, NULL, NULL, NULL, key) == 1
+        && EVP_DigestSign(md, sig, &size, hash, hash_len) == 1;
+    EVP_MD_CTX_free(md);
+    EVP_PKEY_free(key);
+    if (!ok) THROW(EXCEPTION);
+    if (info != NULL) *info = 0;
+    return size;
+}
+
+// k for `hash`, as in RFC 6979 section 3.2 with HMAC-SHA256, for curves of 256-bit order.
+static BIGNUM *rfc6979_nonce(
+    BIGNUM const *const order, uint8_t const private_key[32], uint8_t const hash[32], BN_CTX *const bn
+) {
+    // bits2octets: the hash reduced modulo the order
+    uint8_t h1[32];
+    BIGNUM *const h = BN_bin2bn(hash, 32, NULL);
+    if (h == NULL || BN_nnmod(h, h, order, bn) != 1 || BN_bn2binpad(h, h1, sizeof(h1)) != sizeof(h1)) {
+        BN_free(h);
+        THROW(EXCEPTION);
+    }
+    BN_free(h);
+
+    uint8_t v[32], k[32];
+    memset(v, 0x01, sizeof(v));
+    memset(k, 0x00, sizeof(k));
+
+    uint8_t data[32 + 1 + 32 + 32];
+    for (uint8_t separator = 0; separator <= 1; separator++) {
+        memcpy(data, v, 32);
+        data[32] = separator;
+        memcpy(data + 33, private_key, 32);
+        memcpy(data + 65, h1, 32);
+        HMAC(EVP_sha256(), k, sizeof(k), data, sizeof(data), k, NULL);
+        HMAC(EVP_sha256(), k, sizeof(k), v, sizeof(v), v, NULL);
+    }
+
+    BIGNUM *const nonce = BN_new();
+    if (nonce == NULL) THROW(EXCEPTION);
+    while (true) {
+        HMAC(EVP_sha256(), k, sizeof(k), v, sizeof(v), v, NULL);
+        if (BN_bin2bn(v, sizeof(v), nonce) == NULL) THROW(EXCEPTION);
+        if (!BN_is_zero(nonce) && BN_cmp(nonce, order) < 0) break;
+
+        memcpy(data, v, 32);
+        data[32] = 0x00;
+        HMAC(EVP_sha256(), k, sizeof(k), data, 33, k, NULL);
+        HMAC(EVP_sha256(), k, sizeof(k), v, sizeof(v), v, NULL);
+    }
+    explicit_bzero(k, sizeof(k));
+    explicit_bzero(data, sizeof(data));
+    return nonce;
+}
+
+// Appends a DER INTEGER holding `n`, and returns the new offset.
+static size_t der_integer(uint8_t *const out, size_t offset, BIGNUM const *const n) {
+    uint8_t bytes[33];
+    size_t size = BN_bn2bin(n, bytes + 1);
+    uint8_t const *start = bytes + 1;
+    if (size == 0 || (start[0] & 0x80)) {
+        bytes[0] = 0;
+        start--;
+        size++;
+    }
+    out[offset++] = 0x02;
+    out[offset++] = size;
+    memcpy(out + offset, start, size);
+    return offset + size;
+}
+
+int cx_ecdsa_sign(
+    const cx_ecfp_private_key_t *const pvkey, int const mode, cx_md_t const hashID,
+    const unsigned char *const hash, unsigned int const hash_len,
+    unsigned char *const sig, unsigned int const sig_len, unsigned int *const info
+) {
+    (void)hashID;
+    if (!(mode & CX_RND_RFC6979) || hash_len != 32 || sig_len < 72) THROW(INVALID_PARAMETER);
+
+    EC_GROUP *const group = EC_GROUP_new_by_curve_name(curve_nid(pvkey->curve));
+    BN_CTX *const bn = BN_CTX_new();
+    if (group == NULL || bn == NULL) THROW(EXCEPTION);
+    BN_CTX_start(bn);
+    BIGNUM *const order = BN_CTX_get(bn);
+    BIGNUM *const d = BN_CTX_get(bn);
+    BIGNUM *const e = BN_CTX_get(bn);
+    BIGNUM *const x = BN_CTX_get(bn);
+    BIGNUM *const y = BN_CTX_get(bn);
+    BIGNUM *const r = BN_CTX_get(bn);
+    BIGNUM *const s = BN_CTX_get(bn);
+    EC_POINT *const point = EC_POINT_new(group);
+    if (s == NULL || point == NULL || EC_GROUP_get_order(group, order, bn) != 1) THROW(EXCEPTION);
+
+    BIGNUM *const k = rfc6979_nonce(order, pvkey->d, hash, bn);
+    bool const ok = BN_bin2bn(pvkey->d, pvkey->d_len, d) != NULL
+        && BN_bin2bn(hash, hash_len, e) != NULL
+        // R = kG, r = x(R) mod n
+        && EC_POINT_mul(group, point, k, NULL, NULL, bn) == 1
+        && EC_POINT_get_affine_coordinates(group, point, x, y, bn) == 1
+        && BN_nnmod(r, x, order, bn) == 1
+        // s = (e + r * d) / k mod n
+        && BN_mod_mul(s, r, d, order, bn) == 1
+        && BN_mod_add(s, s, e, order, bn) == 1
+        && BN_mod_inverse(k, k, order, bn) != NULL
+        && BN_mod_mul(s, s, k, order, bn) == 1;
+    if (!ok) THROW(EXCEPTION);
+
+    size_t size = 2;
+    size = der_integer(sig, size, r);
+    size = der_integer(sig, size, s);
+    sig[0] = 0x30;
+    sig[1] = size - 2;
+    if (info != NULL) *info = BN_is_odd(y) ? CX_ECCINFO_PARITY_ODD : 0;
+
+    BN_clear_free(k);
+    EC_POINT_free(point);
+    BN_CTX_end(bn);
+    BN_CTX_free(bn);
+    EC_GROUP_free(group);
+    return size;
+}
@@ -0,0 +1,94 @@
+# Host build, included by the Makefile for `make host`: the app without its device entry points and display code,
+# built for the development machine against the SDK stand-ins in host/. It is linked with the unit tests in
+# test/host, and with src/main.c and host/server into apdu-server, which serves APDUs over TCP. `make host` builds
+# both apps and runs their tests; `make host-server` only builds the servers. Needs a C compiler and OpenSSL's
+# libcrypto, and Python 3 for the server tests.
+#
+# The wallet's operation parser is also built with sanitizers into parse-fuzz, a fuzz target (test/fuzz). `make host`
+# runs it on mutants of its seeds for a moment, `make host-fuzz` for HOST_FUZZ_TIME seconds. It is driven by
+# test/fuzz/main.c, which AFL can run too, unless HOST_FUZZ_ENGINE=libfuzzer, which needs HOST_CC=clang.
+
+HOST_CC ?= cc
+HOST_BUILD_DIR ?= build/host
+HOST_APPS := tezos_wallet tezos_baking
+
+# boot.c and main.c are the device's entry point: boot.c starts the app and main.c's app_main sets up the handler
+# table and runs the main loop. Only apdu-server, whose own main does what boot.c does, links app_main.
+HOST_APP_SOURCES := $(filter-out src/boot.c src/main.c src/ui_nano_s.c src/ui_nano_x.c,$(wildcard src/*.c))
+HOST_SHIM_SOURCES := $(wildcard host/*.c)
+HOST_TEST_SOURCES := $(wildcard test/host/*.c)
+HOST_SERVER_SOURCES := $(wildcard host/server/*.c) src/main.c
+HOST_FUZZ_SOURCES := $(wildcard test/fuzz/*.c)
+HOST_SOURCES := $(HOST_APP_SOURCES) $(HOST_SHIM_SOURCES) $(HOST_TEST_SOURCES) $(HOST_SERVER_SOURCES) $(HOST_FUZZ_SOURCES)
+
+# char is unsigned on the device. The warnings turned off are GCC's, about code the device's compiler accepts.
+HOST_CFLAGS ?= -std=gnu11 -g -O1 -Wall -Wextra -funsigned-char
+HOST_CFLAGS += -Wno-pointer-to-int-cast -Wno-sign-compare -Wno-implicit-fallthrough -Wno-clobbered
+HOST_CPPFLAGS := -Ihost/include -Isrc -MMD -MP
+HOST_CPPFLAGS += -DIO_HID_EP_LENGTH=64 -DIO_SEPROXYHAL_BUFFER_SIZE_B=128 '-DPRINTF(...)='
+HOST_CPPFLAGS += -DVERSION=\"$(APPVERSION)\" -DCOMMIT=\"host\"
+HOST_CPPFLAGS += -DAPPVERSION_M=$(APPVERSION_M) -DAPPVERSION_N=$(APPVERSION_N) -DAPPVERSION_P=$(APPVERSION_P)
+HOST_LDLIBS := -lcrypto
+
+HOST_FUZZ_ENGINE ?= standalone
+HOST_FUZZ_TIME ?= 60
+HOST_FUZZ_SMOKE_RUNS ?= 100000
+HOST_FUZZ_CORPUS := $(HOST_BUILD_DIR)/fuzz-corpus
+HOST_FUZZ_TARGET := $(HOST_BUILD_DIR)/tezos_wallet-fuzz/parse-fuzz
+HOST_FUZZ_CFLAGS := -fsanitize=address,undefined -fno-sanitize-recover=undefined
+ifeq ($(HOST_FUZZ_ENGINE),libfuzzer)
+HOST_FUZZ_LDFLAGS := -fsanitize=fuzzer
+HOST_FUZZ_CFLAGS += -fsanitize=fuzzer-no-link
+HOST_FUZZ_TARGET_SOURCES := $(filter-out test/fuzz/main.c,$(HOST_FUZZ_SOURCES))
+else
+HOST_FUZZ_TARGET_SOURCES := $(HOST_FUZZ_SOURCES)
+endif
+
+# Objects of app $(1) for sources $(2)
+host_objects = $(patsubst %.c,$(HOST_BUILD_DIR)/$(1)/%.o,$(2))
+
+# Rules for one app: $(1) is its name and $(2) its flags.
+define host_app
+$(HOST_BUILD_DIR)/$(1)/%.o: %.c | src/delegates.h
+	@mkdir -p $$(@D)
+	$$(HOST_CC) $$(HOST_CFLAGS) $$(HOST_CPPFLAGS) $(2) -c $$< -o $$@
+
+$(HOST_BUILD_DIR)/$(1)/unit-tests: $(call host_objects,$(1),$(HOST_APP_SOURCES) $(HOST_SHIM_SOURCES) $(HOST_TEST_SOURCES))
+	$$(HOST_CC) $$(HOST_CFLAGS) $(2) $$^ $$(HOST_LDLIBS) -o $$@
+
+$(HOST_BUILD_DIR)/$(1)/apdu-server: $(call host_objects,$(1),$(HOST_APP_SOURCES) $(HOST_SHIM_SOURCES) $(HOST_SERVER_SOURCES))
+	$$(HOST_CC) $$(HOST_CFLAGS) $(2) $$^ $$(HOST_LDLIBS) -o $$@
+
+$(HOST_BUILD_DIR)/$(1)/parse-fuzz: $(call host_objects,$(1),$(HOST_APP_SOURCES) $(HOST_SHIM_SOURCES) $(HOST_FUZZ_TARGET_SOURCES))
+	$$(HOST_CC) $$(HOST_CFLAGS) $(2) $$(HOST_FUZZ_LDFLAGS) $$^ $$(HOST_LDLIBS) -o $$@
+
+-include $(patsubst %.o,%.d,$(call host_objects,$(1),$(HOST_SOURCES)))
+endef
+
+$(eval $(call host_app,tezos_wallet,))
+$(eval $(call host_app,tezos_baking,-DBAKING_APP))
+$(eval $(call host_app,tezos_wallet-fuzz,$(HOST_FUZZ_CFLAGS)))
+
+$(HOST_FUZZ_CORPUS)/.seeds: test/fuzz/seeds.py
+	python3 $< $(@D)
+	@touch $@
+
+.PHONY: host host-server host-fuzz host-fuzz-target host-clean
+host-server: $(foreach app,$(HOST_APPS),$(HOST_BUILD_DIR)/$(app)/apdu-server)
+
+host-fuzz-target: $(HOST_FUZZ_TARGET) $(HOST_FUZZ_CORPUS)/.seeds
+
+host: $(foreach app,$(HOST_APPS),$(HOST_BUILD_DIR)/$(app)/unit-tests) host-server host-fuzz-target
+	@set -e; for app in $(HOST_APPS); do \
+	    echo ">>>>> Testing $$app"; \
+	    $(HOST_BUILD_DIR)/$$app/unit-tests; \
+	    python3 test/host/apdu_server_test.py $$app $(HOST_BUILD_DIR)/$$app/apdu-server; \
+	done
+	@echo ">>>>> Fuzzing the operation parser"
+	$(HOST_FUZZ_TARGET) -runs=$(HOST_FUZZ_SMOKE_RUNS) -seed=1 $(HOST_FUZZ_CORPUS)
+
+host-fuzz: host-fuzz-target
+	$(HOST_FUZZ_TARGET) -max_total_time=$(HOST_FUZZ_TIME) $(HOST_FUZZ_CORPUS)
+
+host-clean:
+	rm -rf $(HOST_BUILD_DIR)
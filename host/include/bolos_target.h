@@ -0,0 +1,4 @@
+#pragma once
+
+// Host builds lay out memory like the Nano S.
+#define TARGET_NANOS 1
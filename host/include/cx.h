@@ -0,0 +1,85 @@
+#pragma once
+
+// Stand-in for the SDK's cryptography API in host builds (`make host`), with the SDK's names and behaviour.
+// Only what the app uses is here; host/cx.c implements it in software.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    CX_CURVE_NONE = 0,
+    CX_CURVE_SECP256K1 = 0x21,
+    CX_CURVE_SECP256R1 = 0x22,
+    CX_CURVE_Ed25519 = 0x41,
+} cx_curve_t;
+
+typedef enum {
+    CX_NONE = 0,
+    CX_SHA256 = 3,
+    CX_SHA512 = 5,
+    CX_BLAKE2B = 9,
+} cx_md_t;
+
+#define CX_LAST (1 << 0)
+#define CX_RND_RFC6979 (3 << 9)
+#define CX_ECCINFO_PARITY_ODD 1
+
+#define CX_SHA256_SIZE 32
+#define CX_SHA512_SIZE 64
+
+#define BLAKE2B_BLOCKBYTES 128
+
+typedef struct {
+    cx_md_t algo;
+    unsigned int counter;
+} cx_hash_t;
+
+typedef struct {
+    cx_hash_t header;
+    size_t output_size;
+    uint64_t h[8];
+    uint64_t t[2];
+    uint8_t block[BLAKE2B_BLOCKBYTES];
+    size_t block_length;
+} cx_blake2b_t;
+
+// `size` is in bits.
+int cx_blake2b_init(cx_blake2b_t *hash, unsigned int size);
+
+// Only BLAKE2b states are hashed incrementally by the app. Output is written with CX_LAST.
+int cx_hash(cx_hash_t *hash, int mode, const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len);
+
+int cx_hash_sha256(const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len);
+int cx_hash_sha512(const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len);
+int cx_hmac_sha256(
+    const unsigned char *key, unsigned int key_len, const unsigned char *in, unsigned int len,
+    unsigned char *mac, unsigned int mac_len);
+
+// Public keys are 0x04, X and Y. Ed25519 keys are the exception: the 32-byte encoding of the point follows the
+// 0x04 instead of its coordinates, and cx_edward_compress_point only changes that byte to 0x02. The app only ever
+// looks at compressed Ed25519 keys, which come out the same as on the device.
+typedef struct {
+    cx_curve_t curve;
+    unsigned int W_len;
+    unsigned char W[65];
+} cx_ecfp_public_key_t;
+
+typedef struct {
+    cx_curve_t curve;
+    unsigned int d_len;
+    unsigned char d[32];
+} cx_ecfp_private_key_t;
+
+int cx_ecfp_init_private_key(cx_curve_t curve, const unsigned char *rawkey, unsigned int key_len, cx_ecfp_private_key_t *pvkey);
+int cx_ecfp_generate_pair(cx_curve_t curve, cx_ecfp_public_key_t *pubkey, cx_ecfp_private_key_t *privkey, int keepprivate);
+void cx_edward_compress_point(cx_curve_t curve, unsigned char *P, unsigned int P_len);
+
+// Signs `hash` itself, which is what the app passes for both curves. Returns the size of the signature.
+int cx_eddsa_sign(
+    const cx_ecfp_private_key_t *pvkey, int mode, cx_md_t hashID, const unsigned char *hash, unsigned int hash_len,
+    const unsigned char *ctx, unsigned int ctx_len, unsigned char *sig, unsigned int sig_len, unsigned int *info);
+
+// Deterministic (RFC 6979) ECDSA, DER-encoded, with the parity of R in `info`.
+int cx_ecdsa_sign(
+    const cx_ecfp_private_key_t *pvkey, int mode, cx_md_t hashID, const unsigned char *hash, unsigned int hash_len,
+    unsigned char *sig, unsigned int sig_len, unsigned int *info);
@@ -0,0 +1,47 @@
+#pragma once
+
+// What host builds add to the SDK's API, for the tests and tools that drive the app on a development machine.
+
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Keys are derived from this mnemonic until another one is set. It is the one speculos uses by default, so that
+// keys match the emulator's.
+#define HOST_DEFAULT_MNEMONIC \
+    "glory promote mansion idle axis finger extra february uncover one trip resource " \
+    "lawn turtle enact monster seven myth punch hobby comfort wild raise skin"
+
+void host_set_mnemonic(char const *mnemonic);
+
+// Called after each nvm_write, so that NVRAM can be saved.
+extern void (*host_nvram_written)(void);
+
+// io_exchange sends responses through host_io_send, and gets APDUs from host_io_receive, which returns their size.
+// Sending throws if host_io_send isn't set. The process exits when there are no more APDUs: when
+// host_io_receive isn't set or returns 0.
+extern void (*host_io_send)(uint8_t const *data, size_t size);
+extern size_t (*host_io_receive)(uint8_t *buffer, size_t size);
+
+#define HOST_PROMPT_MAX_SCREENS 16
+
+// What the device would display, with every screen rendered.
+struct host_prompt {
+    bool shown; // Anything at all is displayed, rather than the idle screen
+    bool waiting; // A prompt waits for host_ui_respond; otherwise it's a preview
+    size_t screen_count;
+    struct {
+        char prompt[PROMPT_WIDTH + 1];
+        char value[VALUE_WIDTH + 1];
+    } screens[HOST_PROMPT_MAX_SCREENS];
+};
+extern struct host_prompt host_prompt;
+
+// Accepts or rejects the prompt that is waiting, like pressing a button would. Throws if no prompt is waiting.
+void host_ui_respond(bool accept);
+
+// When the app waits for a prompt to be answered, io_exchange answers it with what this returns, if it is set,
+// before it gets the next APDU.
+extern bool (*host_ui_decide)(void);
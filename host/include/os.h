@@ -0,0 +1,102 @@
+#pragma once
+
+// Stand-in for the SDK's os.h in host builds (`make host`): exceptions, PIC, NVRAM and key derivation, with the
+// SDK's names and behaviour. Only what the app uses is here.
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#define CX_APILEVEL 9
+
+// Exceptions, as in the SDK: TRY sets up a jump buffer, THROW jumps to the innermost one.
+typedef unsigned short exception_t;
+
+typedef struct try_context_s try_context_t;
+struct try_context_s {
+    jmp_buf jmp_buf;
+    try_context_t *previous;
+    exception_t ex;
+};
+
+try_context_t *try_context_get(void);
+try_context_t *try_context_set(try_context_t *context);
+
+// Jumps to the innermost TRY, or exits the process if there is none.
+__attribute__((noreturn)) void os_longjmp(unsigned int exception);
+
+#define BEGIN_TRY_L(L) { try_context_t __try##L;
+#define TRY_L(L) \
+    __try##L.ex = setjmp(__try##L.jmp_buf); \
+    if (__try##L.ex == 0) { \
+        __try##L.previous = try_context_set(&__try##L);
+#define CATCH_L(L, x) \
+        goto __FINALLY##L; \
+    } else if (__try##L.ex == x) { \
+        __try##L.ex = 0; \
+        try_context_set(__try##L.previous);
+#define CATCH_OTHER_L(L, e) \
+        goto __FINALLY##L; \
+    } else { \
+        exception_t e; \
+        e = __try##L.ex; \
+        __try##L.ex = 0; \
+        try_context_set(__try##L.previous);
+#define CATCH_ALL_L(L) \
+        goto __FINALLY##L; \
+    } else { \
+        __try##L.ex = 0; \
+        try_context_set(__try##L.previous);
+#define FINALLY_L(L) \
+        goto __FINALLY##L; \
+    } \
+    __FINALLY##L: \
+    if (try_context_get() == &__try##L) { \
+        try_context_set(__try##L.previous); \
+    }
+#define END_TRY_L(L) \
+    if (__try##L.ex != 0) { \
+        THROW_L(L, __try##L.ex); \
+    } \
+    }
+#define THROW_L(L, x) os_longjmp(x)
+
+#define BEGIN_TRY BEGIN_TRY_L(_)
+#define TRY TRY_L(_)
+#define CATCH(x) CATCH_L(_, x)
+#define CATCH_OTHER(e) CATCH_OTHER_L(_, e)
+#define CATCH_ALL CATCH_ALL_L(_)
+#define FINALLY FINALLY_L(_)
+#define END_TRY END_TRY_L(_)
+#define THROW(x) os_longjmp(x)
+
+#define EXCEPTION 1
+#define INVALID_PARAMETER 2
+#define EXCEPTION_IO_RESET 0x10
+
+// Nothing is relocated on the host.
+#define PIC(x) ((void *)(uintptr_t)(x))
+
+// NVRAM is ordinary memory on the host.
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len);
+
+// Exits the process with `exit_code`.
+__attribute__((noreturn)) void os_sched_exit(unsigned int exit_code);
+
+#include "cx.h"
+
+// Keys are derived from the seed of the mnemonic set with host_set_mnemonic (see host.h), with SLIP-10 for every
+// curve, like the device.
+#define HDW_NORMAL 0
+#define HDW_ED25519_SLIP10 1
+
+void os_perso_derive_node_bip32(
+    cx_curve_t curve, const unsigned int *path, unsigned int pathLength,
+    unsigned char *privateKey, unsigned char *chain);
+void os_perso_derive_node_bip32_seed_key(
+    unsigned int mode, cx_curve_t curve, const unsigned int *path, unsigned int pathLength,
+    unsigned char *privateKey, unsigned char *chain, unsigned char *seed_key, unsigned int seed_key_length);
+
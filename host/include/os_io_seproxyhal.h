@@ -0,0 +1,60 @@
+#pragma once
+
+// Stand-in for the SDK's I/O and display layer in host builds (`make host`). APDUs go through io_exchange, which
+// the host build implements; the display is not there at all.
+
+#include "os.h"
+
+#define IO_APDU_BUFFER_SIZE 260
+extern unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+
+typedef enum {
+    IO_APDU_MEDIA_NONE = 0,
+    IO_APDU_MEDIA_USB_HID = 1,
+    IO_APDU_MEDIA_BLE,
+    IO_APDU_MEDIA_NFC,
+    IO_APDU_MEDIA_USB_CCID,
+    IO_APDU_MEDIA_USB_WEBUSB,
+    IO_APDU_MEDIA_RAW,
+    IO_APDU_MEDIA_U2F,
+} io_apdu_media_t;
+extern volatile io_apdu_media_t G_io_apdu_media;
+
+#define CHANNEL_APDU 0
+#define CHANNEL_KEYBOARD 1
+#define CHANNEL_SPI 2
+
+#define IO_RESET_AFTER_REPLIED 0x80
+#define IO_RECEIVE_DATA 0x40
+#define IO_RETURN_AFTER_TX 0x20
+#define IO_ASYNCH_REPLY 0x10
+#define IO_FLAGS 0xF0
+
+// Sends the `tx_len` bytes of the response in G_io_apdu_buffer, if any, then waits for the next APDU and returns
+// its size, unless IO_RETURN_AFTER_TX is set.
+unsigned short io_exchange(unsigned char channel_and_flags, unsigned short tx_len);
+
+// Only there for io_exchange_al, which the host build never calls.
+void io_seproxyhal_spi_send(const unsigned char *buffer, unsigned short length);
+unsigned short io_seproxyhal_spi_recv(unsigned char *buffer, unsigned short maxlength, unsigned int flags);
+void reset(void);
+
+// Display types and calls that code shared with the device refers to. They do nothing on the host.
+typedef struct {
+    int unused;
+} ux_state_t;
+
+typedef struct {
+    unsigned int ux_id;
+} bolos_ux_params_t;
+
+#define BOLOS_UX_VALIDATE_PIN 10
+
+typedef struct bagl_element_s {
+    int unused;
+} bagl_element_t;
+
+#define UX_INIT() ((void)0)
+
+void io_seproxyhal_display_default(bagl_element_t *element);
+unsigned int os_ux_blocking(bolos_ux_params_t *params);
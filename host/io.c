@@ -0,0 +1,29 @@
+// APDU transport for host builds: io_exchange hands responses and requests to whatever drives the app.
+
+#include "host.h"
+
+#include "os_io_seproxyhal.h"
+
+void (*host_io_send)(uint8_t const *data, size_t size);
+size_t (*host_io_receive)(uint8_t *buffer, size_t size);
+bool (*host_ui_decide)(void);
+
+unsigned short io_exchange(unsigned char const channel_and_flags, unsigned short const tx_len) {
+    if ((channel_and_flags & ~IO_FLAGS) != CHANNEL_APDU) THROW(INVALID_PARAMETER);
+
+    if (tx_len > 0) {
+        if (host_io_send == NULL || tx_len > sizeof(G_io_apdu_buffer)) THROW(INVALID_PARAMETER);
+        host_io_send(G_io_apdu_buffer, tx_len);
+    }
+    if (channel_and_flags & IO_RETURN_AFTER_TX) return 0;
+
+    // The device would wait for a button here, and the prompt's callback sends the response.
+    if ((channel_and_flags & IO_ASYNCH_REPLY) && host_prompt.waiting && host_ui_decide != NULL) {
+        host_ui_respond(host_ui_decide());
+    }
+
+    size_t const rx = host_io_receive == NULL ? 0 : host_io_receive(G_io_apdu_buffer, sizeof(G_io_apdu_buffer));
+    if (rx == 0) os_sched_exit(0); // Nothing more to do
+    if (rx > sizeof(G_io_apdu_buffer)) THROW(INVALID_PARAMETER);
+    return rx;
+}
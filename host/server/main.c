@@ -0,0 +1,252 @@
+// apdu-server: the whole app as a process on the development machine, serving APDUs over TCP instead of USB.
+//
+// The framing is that of speculos and of ledgerblue's TCP transport (LEDGER_PROXY_ADDRESS and LEDGER_PROXY_PORT):
+// a request is the 4-byte big-endian length of the APDU, then the APDU; a response is the 4-byte length of its data,
+// then the data and the 2-byte status word. One client is served at a time, and the app keeps its state from one
+// connection to the next, as a device stays on between clients.
+
+#include "host.h"
+
+#include "globals.h"
+#include "ui.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+__attribute__((noreturn))
+void app_main(void);
+
+#define DEFAULT_PORT 9999
+#define FRAME_HEADER_SIZE 4
+#define STATUS_WORD_SIZE 2
+
+static struct {
+    char const *nvram_path;
+    char const *policy; // One letter for each prompt, the last one repeated: 'a' accepts and 'r' rejects
+    bool verbose;
+} options = {
+    .policy = "a",
+};
+
+__attribute__((noreturn, format(printf, 1, 2)))
+static void die(char const *const format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    exit(EXIT_FAILURE);
+}
+
+// Prompts
+
+static bool decide(void) {
+    bool const accept = *options.policy == 'a';
+    if (options.policy[1] != '\0') options.policy++;
+
+    if (options.verbose) {
+        for (size_t i = 0; i < host_prompt.screen_count; i++) {
+            fprintf(stderr, "  %s: %s\n", host_prompt.screens[i].prompt, host_prompt.screens[i].value);
+        }
+        fprintf(stderr, "%s\n", accept ? "Accepted" : "Rejected");
+    }
+    return accept;
+}
+
+// NVRAM
+
+#ifdef BAKING_APP
+
+static void load_nvram(void) {
+    FILE *const file = fopen(options.nvram_path, "rb");
+    if (file == NULL) {
+        if (errno == ENOENT) return; // A fresh install
+        die("Can't open %s: %s", options.nvram_path, strerror(errno));
+    }
+    bool const read = fread(&N_data_real, sizeof(N_data_real), 1, file) == 1 && fgetc(file) == EOF;
+    fclose(file);
+    if (!read) die("%s isn't the NVRAM of this version of the app", options.nvram_path);
+}
+
+static void save_nvram(void) {
+    int const fd = open(options.nvram_path, O_WRONLY | O_CREAT, 0600);
+    if (fd < 0 || pwrite(fd, &N_data_real, sizeof(N_data_real), 0) != (ssize_t)sizeof(N_data_real)) {
+        die("Can't write %s: %s", options.nvram_path, strerror(errno));
+    }
+    close(fd);
+}
+
+#endif
+
+// Transport
+
+static int listener = -1;
+static int client = -1;
+
+static void listen_on(uint16_t const port) {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) die("Can't create a socket: %s", strerror(errno));
+    int const yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 1) != 0) {
+        die("Can't listen on port %u: %s", port, strerror(errno));
+    }
+
+    // Port 0 picks a free one, which whoever started the server learns from this line.
+    socklen_t size = sizeof(address);
+    if (getsockname(listener, (struct sockaddr *)&address, &size) != 0) die("getsockname: %s", strerror(errno));
+    printf("Listening on 127.0.0.1:%u\n", ntohs(address.sin_port));
+    fflush(stdout);
+}
+
+static void accept_client(void) {
+    while (client < 0) {
+        client = accept(listener, NULL, NULL);
+        if (client < 0 && errno != EINTR) die("accept: %s", strerror(errno));
+    }
+    // Requests and responses are small and strictly alternate, so don't let them wait for more.
+    int const yes = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+}
+
+static void drop_client(void) {
+    close(client);
+    client = -1;
+}
+
+static bool read_all(uint8_t *const buffer, size_t const size) {
+    for (size_t done = 0; done < size; ) {
+        ssize_t const n = read(client, buffer + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+static size_t receive_apdu(uint8_t *const buffer, size_t const size) {
+    while (true) {
+        accept_client();
+        uint8_t header[FRAME_HEADER_SIZE];
+        if (read_all(header, sizeof(header))) {
+            size_t const length =
+                (size_t)header[0] << 24 | (size_t)header[1] << 16 | (size_t)header[2] << 8 | header[3];
+            if (length > 0 && length <= size && read_all(buffer, length)) return length;
+            if (options.verbose) fprintf(stderr, "Dropping a client that sent a %zu-byte APDU\n", length);
+        }
+        drop_client();
+    }
+}
+
+static void send_response(uint8_t const *const data, size_t const size) {
+    if (client < 0) return; // A response to a client that has gone away
+    if (size < STATUS_WORD_SIZE || size > IO_APDU_BUFFER_SIZE) THROW(INVALID_PARAMETER);
+
+    uint8_t frame[FRAME_HEADER_SIZE + IO_APDU_BUFFER_SIZE];
+    size_t const length = size - STATUS_WORD_SIZE;
+    frame[0] = length >> 24;
+    frame[1] = length >> 16;
+    frame[2] = length >> 8;
+    frame[3] = length;
+    memcpy(frame + FRAME_HEADER_SIZE, data, size);
+
+    for (size_t done = 0; done < FRAME_HEADER_SIZE + size; ) {
+        ssize_t const n = send(client, frame + done, FRAME_HEADER_SIZE + size - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            drop_client(); // The next receive waits for another one
+            return;
+        }
+        done += n;
+    }
+}
+
+__attribute__((noreturn))
+static void usage(char const *const program) {
+    fprintf(stderr,
+            "Usage: %s [-p PORT] [-n NVRAM_FILE] [-m MNEMONIC] [-u POLICY] [-v]\n"
+            "  -p PORT        Port to listen on, on 127.0.0.1 (default %u; 0 picks a free one)\n"
+            "  -n NVRAM_FILE  File that holds the baking app's NVRAM, created when it is first written\n"
+            "  -m MNEMONIC    Mnemonic to derive keys from (default: the one speculos uses)\n"
+            "  -u POLICY      How prompts are answered: a letter for each, 'a' to accept or 'r' to reject, the last\n"
+            "                 one repeated for the rest (default 'a')\n"
+            "  -v             Show prompts and dropped clients\n",
+            program, DEFAULT_PORT);
+    exit(EXIT_FAILURE);
+}
+
+int main(int const argc, char *const argv[]) {
+    unsigned long port = DEFAULT_PORT;
+    int option;
+    while ((option = getopt(argc, argv, "p:n:m:u:v")) != -1) {
+        switch (option) {
+            case 'p': {
+                char *end;
+                port = strtoul(optarg, &end, 10);
+                if (*end != '\0' || port > UINT16_MAX) usage(argv[0]);
+                break;
+            }
+            case 'n': options.nvram_path = optarg; break;
+            case 'm': host_set_mnemonic(optarg); break;
+            case 'u':
+                options.policy = optarg;
+                if (*optarg == '\0' || optarg[strspn(optarg, "ar")] != '\0') usage(argv[0]);
+                break;
+            case 'v': options.verbose = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc) usage(argv[0]);
+
+    // As boot.c does on the device
+    uint8_t tag;
+    init_globals();
+    global.stack_root = &tag;
+
+#   ifdef BAKING_APP
+        if (options.nvram_path != NULL) {
+            load_nvram();
+            host_nvram_written = save_nvram;
+        }
+#   else
+        if (options.nvram_path != NULL) die("The wallet app has no NVRAM");
+#   endif
+
+    listen_on(port);
+    host_io_send = send_response;
+    host_io_receive = receive_apdu;
+    host_ui_decide = decide;
+
+    while (true) {
+        BEGIN_TRY {
+            TRY {
+                ui_initial_screen();
+                app_main();
+            }
+            CATCH(EXCEPTION_IO_RESET) {
+                continue;
+            }
+            CATCH_OTHER(e) {
+                die("Uncaught exception 0x%04x", e);
+            }
+            FINALLY {
+            }
+        }
+        END_TRY;
+    }
+}
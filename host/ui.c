@@ -0,0 +1,77 @@
+// The device-specific UI (ui_nano_s.c and ui_nano_x.c) for host builds. Nothing is displayed: every screen of a
+// prompt is rendered into host_prompt, and prompts wait for host_ui_respond instead of a button.
+
+#include "host.h"
+
+#include "globals.h"
+#include "ui.h"
+
+#include <string.h>
+
+#define G global.ui
+
+struct host_prompt host_prompt;
+
+static void clear_ui_callbacks(void) {
+    for (size_t i = 0; i < MAX_SCREEN_COUNT; i++) {
+        G.prompt.callbacks[i] = NULL;
+    }
+    G.prompt.screen_count = 0;
+    G.ok_callback = NULL;
+    G.cxl_callback = NULL;
+    G.previewing = false;
+}
+
+void ui_refresh(void) {
+}
+
+void ui_initial_screen(void) {
+#   ifdef BAKING_APP
+        update_baking_idle_screens();
+#   endif
+    clear_ui_callbacks();
+    memset(&host_prompt, 0, sizeof(host_prompt));
+}
+
+// Renders every screen, as the device would when they are scrolled through.
+static void show_screens(size_t const screen_count, screen_generator const generate, bool const waiting) {
+    check_null(generate);
+    if (screen_count == 0 || screen_count > HOST_PROMPT_MAX_SCREENS) THROW(EXC_MEMORY_ERROR);
+    G.prompt.generate = generate;
+    G.prompt.screen_count = screen_count;
+
+    memset(&host_prompt, 0, sizeof(host_prompt));
+    for (size_t i = 0; i < screen_count; i++) {
+        generate(i,
+                 host_prompt.screens[i].prompt, sizeof(host_prompt.screens[i].prompt),
+                 host_prompt.screens[i].value, sizeof(host_prompt.screens[i].value));
+    }
+    host_prompt.screen_count = screen_count;
+    host_prompt.shown = true;
+    host_prompt.waiting = waiting;
+}
+
+__attribute__((noreturn))
+void ui_prompt_screens(size_t const screen_count, screen_generator const generate, ui_callback_t ok_c, ui_callback_t cxl_c) {
+    check_null(ok_c);
+    check_null(cxl_c);
+    show_screens(screen_count, generate, true);
+    G.ok_callback = ok_c;
+    G.cxl_callback = cxl_c;
+    G.previewing = false;
+    THROW(ASYNC_EXCEPTION);
+}
+
+void ui_preview_screens(size_t const screen_count, screen_generator const generate) {
+    show_screens(screen_count, generate, false);
+    G.ok_callback = NULL;
+    G.cxl_callback = NULL;
+    G.previewing = true;
+}
+
+void host_ui_respond(bool const accept) {
+    if (!host_prompt.waiting) THROW(EXC_MEMORY_ERROR);
+    ui_callback_t const callback = accept ? G.ok_callback : G.cxl_callback;
+    host_prompt.waiting = false;
+    if (callback()) ui_initial_screen();
+}
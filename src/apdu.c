@@ -34,6 +34,87 @@ size_t handle_apdu_git(uint8_t __attribute__((unused)) instruction) {
     return finalize_successful_send(tx);
 }
 
+_Static_assert(OFFSET_CDATA + MAX_APDU_SIZE <= sizeof(G_io_apdu_buffer), "The APDU buffer can't hold the largest payload");
+
+// APDUs are cut into frames with a header in front of each; the first header also carries the APDU length.
+#define HID_FRAME_SIZE IO_HID_EP_LENGTH
+#define HID_FIRST_HEADER_SIZE 7 // Channel, tag, sequence number, length
+#define HID_NEXT_HEADER_SIZE 5 // Channel, tag, sequence number
+
+#define BLE_FRAME_SIZE 20 // Payload of the default ATT MTU, which every central supports
+#define BLE_FIRST_HEADER_SIZE 5 // Tag, sequence number, length
+#define BLE_NEXT_HEADER_SIZE 3 // Tag, sequence number
+
+// Largest payload whose APDU exactly fills the frames it is sent in, so none of them go out partly empty.
+static uint8_t frame_filling_payload_size(size_t const frame_size, size_t const first_header_size, size_t const next_header_size) {
+    size_t apdu_size = frame_size - first_header_size;
+    while (apdu_size + frame_size - next_header_size <= OFFSET_CDATA + MAX_APDU_SIZE) {
+        apdu_size += frame_size - next_header_size;
+    }
+    return apdu_size - OFFSET_CDATA;
+}
+
+size_t handle_apdu_chunk_size(uint8_t __attribute__((unused)) instruction) {
+    uint8_t chunk_size;
+    switch (G_io_apdu_media) {
+        case IO_APDU_MEDIA_USB_HID:
+            chunk_size = frame_filling_payload_size(HID_FRAME_SIZE, HID_FIRST_HEADER_SIZE, HID_NEXT_HEADER_SIZE);
+            break;
+#       ifdef HAVE_BLE
+        case IO_APDU_MEDIA_BLE:
+            chunk_size = frame_filling_payload_size(BLE_FRAME_SIZE, BLE_FIRST_HEADER_SIZE, BLE_NEXT_HEADER_SIZE);
+            break;
+#       endif
+        default:
+            chunk_size = MAX_APDU_SIZE;
+            break;
+    }
+
+    size_t tx = 0;
+    G_io_apdu_buffer[tx++] = MAX_APDU_SIZE;
+    G_io_apdu_buffer[tx++] = chunk_size;
+    return finalize_successful_send(tx);
+}
+
+static size_t write_word_big_endian(size_t tx, uint32_t const word) {
+    for (size_t i = sizeof(word); i > 0; i--) {
+        G_io_apdu_buffer[tx++] = (word >> ((i - 1) * 8)) & 0xFF;
+    }
+    return tx;
+}
+
+size_t handle_apdu_key_cache_stats(uint8_t __attribute__((unused)) instruction) {
+    size_t tx = 0;
+    G_io_apdu_buffer[tx++] = KEY_CACHE_SIZE;
+    G_io_apdu_buffer[tx++] = global.key_cache.count;
+    tx = write_word_big_endian(tx, global.key_cache.hits);
+    tx = write_word_big_endian(tx, global.key_cache.misses);
+    return finalize_successful_send(tx);
+}
+
+size_t send_response_part(void) {
+    response_producer_t const producer = global.apdu.response_producer;
+    if (producer == NULL) THROW(EXC_REFERENCED_DATA_NOT_FOUND);
+
+    bool more = false;
+    size_t tx = producer(G_io_apdu_buffer, MAX_RESPONSE_PART_SIZE, &more);
+    if (tx > MAX_RESPONSE_PART_SIZE) THROW(EXC_MEMORY_ERROR);
+
+    if (!more) {
+        global.apdu.response_producer = NULL;
+        return finalize_successful_send(tx);
+    }
+    G_io_apdu_buffer[tx++] = SW_MORE_DATA >> 8;
+    G_io_apdu_buffer[tx++] = SW_MORE_DATA & 0xFF;
+    return tx;
+}
+
+size_t send_chained_response(response_producer_t const producer) {
+    check_null(producer);
+    global.apdu.response_producer = producer;
+    return send_response_part();
+}
+
 #define CLA 0x80
 
 __attribute__((noreturn))
@@ -62,11 +143,18 @@ void main_loop(apdu_handler const *const handlers, size_t const handlers_size) {
                 }
 
                 uint8_t const instruction = G_io_apdu_buffer[OFFSET_INS];
-                apdu_handler const cb = instruction >= handlers_size
-                    ? handle_apdu_error
-                    : handlers[instruction];
-
-                size_t const tx = cb(instruction);
+                size_t tx;
+                if (instruction == INS_GET_RESPONSE) {
+                    tx = send_response_part();
+                } else {
+                    // Any other instruction ends a chained response, as it may reuse the producer's state.
+                    global.apdu.response_producer = NULL;
+
+                    apdu_handler const cb = instruction >= handlers_size
+                        ? handle_apdu_error
+                        : handlers[instruction];
+                    tx = cb(instruction);
+                }
                 rx = io_exchange(CHANNEL_APDU, tx);
             }
             CATCH(ASYNC_EXCEPTION) {
@@ -77,6 +165,7 @@ void main_loop(apdu_handler const *const handlers, size_t const handlers_size) {
             }
             CATCH_OTHER(e) {
                 clear_apdu_globals(); // IMPORTANT: Application state must not persist through errors
+                ui_cancel_preview();
 
                 uint16_t sw = e;
 		PRINTF("Error caught at top level, number: %x\n", sw);
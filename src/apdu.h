@@ -38,6 +38,17 @@
 #define INS_QUERY_AUTH_KEY_WITH_CURVE 0x0D
 #define INS_HMAC 0x0E
 #define INS_SIGN_WITH_HASH 0x0F
+#define INS_PREVIEW_OPERATION 0x10
+#define INS_QUERY_CHUNK_SIZE 0x11
+#define INS_GET_PUBLIC_KEYS 0x12
+#define INS_GET_EXTENDED_PUBLIC_KEY 0x13
+#define INS_QUERY_KEY_CACHE_STATS 0x14
+#define INS_GET_RESPONSE 0xC0 // ISO 7816 code; handled by main_loop rather than a handler
+
+// Status word of a response part with more to follow; the rest is fetched with INS_GET_RESPONSE.
+#define SW_MORE_DATA 0x6100
+
+#define MAX_RESPONSE_PART_SIZE (IO_APDU_BUFFER_SIZE - 2) // Leaves room for the status word
 
 __attribute__((noreturn))
 void main_loop(apdu_handler const *const handlers, size_t const handlers_size);
@@ -48,6 +59,14 @@ static inline size_t finalize_successful_send(size_t tx) {
     return tx;
 }
 
+// Starts a response that may not fit in one APDU. `producer` is called to fill in each part as the host asks
+// for it, so the response is never held in memory as a whole. Its state must live in `global.apdu.u`.
+// Returns the size of the first part, like `finalize_successful_send`.
+size_t send_chained_response(response_producer_t const producer);
+
+// Sends the next part of the chained response; main_loop answers INS_GET_RESPONSE with it.
+size_t send_response_part(void);
+
 // Send back response; do not restart the event loop
 static inline void delayed_send(size_t tx) {
     io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, tx);
@@ -72,3 +91,5 @@ size_t provide_pubkey(uint8_t *const io_buffer, cx_ecfp_public_key_t const *cons
 size_t handle_apdu_error(uint8_t instruction);
 size_t handle_apdu_version(uint8_t instruction);
 size_t handle_apdu_git(uint8_t instruction);
+size_t handle_apdu_chunk_size(uint8_t instruction);
+size_t handle_apdu_key_cache_stats(uint8_t instruction);
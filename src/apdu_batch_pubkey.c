@@ -0,0 +1,109 @@
+#include "apdu_batch_pubkey.h"
+
+#include "apdu.h"
+#include "globals.h"
+#include "keys.h"
+#include "protocol.h"
+
+#include <string.h>
+
+#define G global.apdu.u.batch_pubkey
+
+#define P1_HASHES 0x01 // Send 20-byte key hashes instead of public keys
+#define P1_RANGE 0x02 // Data is a path and a count rather than a list of paths
+
+#define ED25519_COMPRESSED_PUBLIC_KEY_SIZE 32
+
+static size_t entry_size(void) {
+    if (G.hashes) return HASH_SIZE;
+    return derivation_type_to_signature_type(G.derivation_type) == SIGNATURE_TYPE_ED25519
+        ? ED25519_COMPRESSED_PUBLIC_KEY_SIZE
+        : MAX_COMPRESSED_PUBLIC_KEY_SIZE;
+}
+
+// In list mode, reads the next requested path into G.path. In range mode, G.path already holds it.
+static bip32_path_t const *next_path(void) {
+    if (G.list) {
+        G.paths_offset += read_bip32_path(&G.path, G.paths + G.paths_offset, G.paths_size - G.paths_offset);
+    }
+    return &G.path;
+}
+
+// Writes the key or key hash for `path` and returns its size.
+static size_t write_entry(uint8_t *const out, bip32_path_t const *const path) {
+    cx_ecfp_public_key_t const *const pubkey = generate_public_key_return_global(G.derivation_type, path);
+
+    uint8_t hash[HASH_SIZE];
+    cx_ecfp_public_key_t const *const compressed =
+        public_key_hash_return_global(hash, sizeof(hash), G.derivation_type, pubkey);
+
+    if (G.hashes) {
+        memcpy(out, hash, sizeof(hash));
+        return sizeof(hash);
+    }
+    memcpy(out, compressed->W, compressed->W_len);
+    return compressed->W_len;
+}
+
+static size_t send_entries(uint8_t *const out, size_t const out_size, bool *const more) {
+    check_null(out);
+    check_null(more);
+
+    size_t const size = entry_size();
+    size_t tx = 0;
+    while (G.remaining > 0 && out_size - tx >= size) {
+        tx += write_entry(out + tx, next_path());
+        if (!G.list) G.path.components[G.path.length - 1]++;
+        G.remaining--;
+    }
+    *more = G.remaining > 0;
+    return tx;
+}
+
+static void read_range(uint8_t const *const in, size_t const in_size) {
+    size_t const ix = read_bip32_path(&G.path, in, in_size);
+    if (in_size - ix != sizeof(G.remaining)) THROW(EXC_WRONG_LENGTH_FOR_INS);
+    G.remaining = in[ix];
+    if (G.remaining == 0) THROW(EXC_WRONG_VALUES);
+
+    // The range may not run from unhardened into hardened indices, or wrap around
+    uint32_t const first = G.path.components[G.path.length - 1] & ~BIP32_HARDENED_BIT;
+    if (first > ~BIP32_HARDENED_BIT - (G.remaining - 1)) THROW(EXC_WRONG_VALUES);
+}
+
+static void read_list(uint8_t const *const in, size_t const in_size) {
+    if (in_size == 0) THROW(EXC_WRONG_LENGTH_FOR_INS);
+    memcpy(G.paths, in, in_size);
+    G.paths_size = in_size;
+    G.paths_offset = 0;
+
+    // Check every path now, so the response can't fail halfway through
+    G.remaining = 0;
+    for (size_t ix = 0; ix < in_size; G.remaining++) {
+        ix += read_bip32_path(&G.path, in + ix, in_size - ix);
+    }
+}
+
+size_t handle_apdu_get_public_keys(__attribute__((unused)) uint8_t instruction) {
+    uint8_t const *const buff = &G_io_apdu_buffer[OFFSET_CDATA];
+    uint8_t const p1 = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_P1]);
+    uint8_t const buff_size = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_LC]);
+
+    // Like INS_GET_PUBLIC_KEY, this shows no prompt, so it is not offered over U2F
+    require_hid();
+
+    if ((p1 & ~(P1_HASHES | P1_RANGE)) != 0) THROW(EXC_WRONG_PARAM);
+
+    memset(&G, 0, sizeof(G));
+    G.derivation_type = parse_derivation_type(READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_CURVE]));
+    G.hashes = (p1 & P1_HASHES) != 0;
+    G.list = (p1 & P1_RANGE) == 0;
+
+    if (G.list) {
+        read_list(buff, buff_size);
+    } else {
+        read_range(buff, buff_size);
+    }
+
+    return send_chained_response(send_entries);
+}
@@ -51,7 +51,6 @@ size_t handle_apdu_hmac(__attribute__((unused)) uint8_t instruction) {
 
     uint8_t const *const buff = &G_io_apdu_buffer[OFFSET_CDATA];
     uint8_t const buff_size = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_LC]);
-    if (buff_size > MAX_APDU_SIZE) THROW(EXC_WRONG_LENGTH_FOR_INS);
 
     memset(&G, 0, sizeof(G));
 
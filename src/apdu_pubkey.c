@@ -20,6 +20,19 @@ static bool pubkey_ok(void) {
     return true;
 }
 
+#ifndef BAKING_APP
+static bool extended_pubkey_ok(void) {
+    size_t tx = 0;
+    G_io_apdu_buffer[tx++] = G.public_key.W_len;
+    memmove(G_io_apdu_buffer + tx, G.public_key.W, G.public_key.W_len);
+    tx += G.public_key.W_len;
+    memcpy(G_io_apdu_buffer + tx, G.chain_code, sizeof(G.chain_code));
+    tx += sizeof(G.chain_code);
+    delayed_send(finalize_successful_send(tx));
+    return true;
+}
+#endif
+
 #ifdef BAKING_APP
 static bool baking_ok(void) {
     authorize_baking(G.key.derivation_type, &G.key.bip32_path);
@@ -116,3 +129,50 @@ size_t handle_apdu_get_public_key(uint8_t instruction) {
         prompt_address(bake, cb, delay_reject);
     }
 }
+
+#ifndef BAKING_APP
+size_t handle_apdu_get_extended_public_key(__attribute__((unused)) uint8_t instruction) {
+    static size_t const TYPE_INDEX = 0;
+    static size_t const PATH_INDEX = 1;
+    static size_t const ADDRESS_INDEX = 2;
+
+    if (READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_P1]) != 0) THROW(EXC_WRONG_PARAM);
+
+    G.key.derivation_type = parse_derivation_type(READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_CURVE]));
+    // SLIP-10 Ed25519 only has hardened derivation, so its chain codes are of no use to the host. BIP32-Ed25519
+    // keys are not the scalar of the extended private key times the base point, so hosts would derive them wrong.
+    if (G.key.derivation_type == DERIVATION_TYPE_ED25519 || G.key.derivation_type == DERIVATION_TYPE_BIP32_ED25519) {
+        THROW(EXC_WRONG_PARAM);
+    }
+
+    size_t const cdata_size = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_LC]);
+    if (read_bip32_path(&G.key.bip32_path, G_io_apdu_buffer + OFFSET_CDATA, cdata_size) != cdata_size) {
+        THROW(EXC_WRONG_LENGTH_FOR_INS);
+    }
+
+    // Only whole hardened branches are exported. Their chain code can't be combined with the private key
+    // of an unhardened child to recover the key of a parent.
+    for (size_t i = 0; i < G.key.bip32_path.length; i++) {
+        if ((G.key.bip32_path.components[i] & BIP32_HARDENED_BIT) == 0) THROW(EXC_WRONG_VALUES);
+    }
+
+    // Fail now rather than while the prompt is on screen if the path is too long to show.
+    char path_text[VALUE_WIDTH + 1];
+    bip32_path_to_string(path_text, sizeof(path_text), &G.key.bip32_path);
+
+    cx_ecfp_public_key_t const *const public_key = generate_extended_public_key_return_global(
+        G.chain_code, G.key.derivation_type, &G.key.bip32_path);
+    memcpy(&G.public_key, public_key, sizeof(G.public_key));
+
+    static const char *const extended_pubkey_labels[] = {
+        PROMPT("Export"),
+        PROMPT("Path"),
+        PROMPT("Public Key Hash"),
+        NULL,
+    };
+    REGISTER_STATIC_UI_VALUE(TYPE_INDEX, "Extended Key");
+    register_ui_callback(PATH_INDEX, bip32_path_to_string, &G.key.bip32_path);
+    register_ui_callback(ADDRESS_INDEX, bip32_path_with_curve_to_pkh_string, &G.key);
+    ui_prompt(extended_pubkey_labels, extended_pubkey_ok, delay_reject);
+}
+#endif
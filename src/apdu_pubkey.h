@@ -3,3 +3,6 @@
 #include "apdu.h"
 
 size_t handle_apdu_get_public_key(uint8_t instruction);
+#ifndef BAKING_APP
+size_t handle_apdu_get_extended_public_key(uint8_t instruction);
+#endif
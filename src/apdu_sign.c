@@ -19,8 +19,6 @@
 
 #define PARSE_ERROR() THROW(EXC_PARSE_ERROR)
 
-#define B2B_BLOCKBYTES 128
-
 static inline void conditional_init_hash_state(blake2b_hash_state_t *const state) {
     check_null(state);
     if (!state->initialized) {
@@ -29,46 +27,33 @@ static inline void conditional_init_hash_state(blake2b_hash_state_t *const state
     }
 }
 
+// The hash keeps its own partial block, so packets are hashed in place without being copied.
 static void blake2b_incremental_hash(
-    /*in/out*/ uint8_t *const out, size_t const out_size,
-    /*in/out*/ size_t *const out_length,
+    uint8_t const *const in, size_t const in_length,
     /*in/out*/ blake2b_hash_state_t *const state
 ) {
-    check_null(out);
-    check_null(out_length);
+    check_null(in);
     check_null(state);
 
-    uint8_t *current = out;
-    while (*out_length > B2B_BLOCKBYTES) {
-        if (current - out > (int)out_size) THROW(EXC_MEMORY_ERROR);
-        conditional_init_hash_state(state);
-        cx_hash((cx_hash_t *) &state->state, 0, current, B2B_BLOCKBYTES, NULL, 0);
-        *out_length -= B2B_BLOCKBYTES;
-        current += B2B_BLOCKBYTES;
-    }
-    // TODO use circular buffer at some point
-    memmove(out, current, *out_length);
+    conditional_init_hash_state(state);
+    cx_hash((cx_hash_t *) &state->state, 0, in, in_length, NULL, 0);
 }
 
 static void blake2b_finish_hash(
     /*out*/ uint8_t *const out, size_t const out_size,
-    /*in/out*/ uint8_t *const buff, size_t const buff_size,
-    /*in/out*/ size_t *const buff_length,
     /*in/out*/ blake2b_hash_state_t *const state
 ) {
     check_null(out);
-    check_null(buff);
-    check_null(buff_length);
     check_null(state);
 
     conditional_init_hash_state(state);
-    blake2b_incremental_hash(buff, buff_size, buff_length, state);
-    cx_hash((cx_hash_t *) &state->state, CX_LAST, buff, *buff_length, out, out_size);
+    cx_hash((cx_hash_t *) &state->state, CX_LAST, NULL, 0, out, out_size);
 }
 
 static int perform_signature(bool const on_hash, bool const send_hash);
 
 static inline void clear_data(void) {
+    ui_cancel_preview(); // It may show data that is about to go away
     memset(&G, 0, sizeof(G));
 }
 
@@ -88,22 +73,12 @@ static bool sign_reject(void) {
     return true; // Return to idle
 }
 
-static bool is_operation_allowed(enum operation_tag tag) {
-    switch (tag) {
-        case OPERATION_TAG_ATHENS_DELEGATION: return true;
-        case OPERATION_TAG_ATHENS_REVEAL: return true;
-        case OPERATION_TAG_BABYLON_DELEGATION: return true;
-        case OPERATION_TAG_BABYLON_REVEAL: return true;
-#       ifndef BAKING_APP
-            case OPERATION_TAG_PROPOSAL: return true;
-            case OPERATION_TAG_BALLOT: return true;
-            case OPERATION_TAG_ATHENS_ORIGINATION: return true;
-            case OPERATION_TAG_ATHENS_TRANSACTION: return true;
-            case OPERATION_TAG_BABYLON_ORIGINATION: return true;
-            case OPERATION_TAG_BABYLON_TRANSACTION: return true;
-#       endif
-        default: return false;
-    }
+static bool is_operation_allowed(enum operation_kind kind) {
+#   ifdef BAKING_APP
+        return kind == OPERATION_KIND_DELEGATION || kind == OPERATION_KIND_REVEAL;
+#   else
+        return kind != OPERATION_KIND_NONE;
+#   endif
 }
 
 #ifdef BAKING_APP
@@ -148,7 +123,8 @@ __attribute__((noreturn)) static void prompt_register_delegate(
     if (!G.maybe_ops.is_valid) THROW(EXC_MEMORY_ERROR);
 
     REGISTER_STATIC_UI_VALUE(TYPE_INDEX, "as delegate?");
-    register_ui_callback(ADDRESS_INDEX, bip32_path_with_curve_to_pkh_string, &G.key);
+    // Already derived while checking the operation in `baking_sign_complete`.
+    register_ui_callback(ADDRESS_INDEX, parsed_contract_to_string, &G.maybe_ops.v.signing);
     register_ui_callback(FEE_INDEX, microtez_to_string_indirect, &G.maybe_ops.v.total_fee);
 
     ui_prompt(prompts, ok_cb, cxl_cb);
@@ -167,12 +143,14 @@ size_t baking_sign_complete(bool const send_hash) {
                 if (!G.maybe_ops.is_valid) PARSE_ERROR();
 
                 // Must be self-delegation signed by the *authorized* baking key
-                if (bip32_path_with_curve_eq(&G.key, &N_data.baking_key) &&
+                if (bip32_path_with_curve_eq(&G.key, &N_data.baking_key)) {
+                    // The signer is generated from G.bip32_path and G.curve, if parsing hasn't already
+                    parsed_contract_t const *const signing = parsed_operations_signer(&G.parse_state, &G.maybe_ops.v);
+                    if (COMPARE(&G.maybe_ops.v.operation.source, signing) != 0 ||
+                        COMPARE(&G.maybe_ops.v.operation.destination, signing) != 0) {
+                        THROW(EXC_SECURITY);
+                    }
 
-                    // ops->signing is generated from G.bip32_path and G.curve
-                    COMPARE(&G.maybe_ops.v.operation.source, &G.maybe_ops.v.signing) == 0 &&
-                    COMPARE(&G.maybe_ops.v.operation.destination, &G.maybe_ops.v.signing) == 0
-                ) {
                     ui_callback_t const ok_c = send_hash ? sign_with_hash_ok : sign_without_hash_ok;
                     prompt_register_delegate(ok_c, sign_reject);
                 }
@@ -193,8 +171,152 @@ static bool sign_unsafe_ok(void) {
     return true;
 }
 
+// Copies a single screen's worth of a longer string.
+static void string_page_to_string(char *const out, size_t const out_size, char const *const page) {
+    check_null(out);
+    check_null(page);
+    size_t const length = MIN(strlen(page), (size_t)VALUE_WIDTH);
+    if (length >= out_size) THROW(EXC_WRONG_LENGTH);
+    memcpy(out, page, length);
+    out[length] = '\0';
+}
+
+// Number of screens `text` is shown on.
+static size_t page_count(char const *const text) {
+    return (strlen(text) + VALUE_WIDTH - 1) / VALUE_WIDTH;
+}
+
+// Screen `page` of `pages` showing text under `name`: "Name", or "Name (page/pages)" if there are several.
+static void page_screen(
+    char const *const name, char const *const text, size_t const page, size_t const pages,
+    char *const prompt, size_t const prompt_size,
+    char *const value, size_t const value_size
+) {
+    if (page == 0 || page > pages) THROW(EXC_MEMORY_ERROR);
+    if (pages == 1) {
+        copy_string(prompt, prompt_size, name);
+    } else {
+        char label[PROMPT_WIDTH + sizeof(" (/)") + 2 * MAX_INT_DIGITS];
+        copy_string(label, PROMPT_WIDTH + 1, name);
+        size_t length = strlen(strcat(label, " ("));
+        length += number_to_string(&label[length], page);
+        label[length++] = '/';
+        length += number_to_string(&label[length], pages);
+        strcpy(&label[length], ")");
+        copy_string(prompt, prompt_size, label);
+    }
+    string_page_to_string(value, value_size, &text[(page - 1) * VALUE_WIDTH]);
+}
+
 #define MAX_NUMBER_CHARS (MAX_INT_DIGITS + 2) // include decimal point and terminating null
 
+#define ALL_FIELDS_READY 0xFFFF
+
+// Registers the screens of operations that are fully described by their schema. Fields missing from
+// `ready_fields` are shown as pending. Returns NULL if the schema doesn't describe any screens.
+static struct operation_schema const *register_operation_fields(
+    struct parsed_operation_group const *const ops,
+    uint16_t const ready_fields
+) {
+    static const uint32_t TYPE_INDEX = 0;
+
+    struct operation_schema const *const schema = find_operation_schema(ops->operation.tag);
+    if (schema == NULL || schema->prompts == NULL) return NULL;
+
+    register_ui_callback(TYPE_INDEX, copy_string, schema->type_label);
+
+    for (size_t i = 0; schema->fields[i].type != OPERATION_FIELD_END; i++) {
+        struct operation_field const *const field = &schema->fields[i];
+        if (field->screen == 0) continue;
+        if (field->screen >= MAX_SCREEN_COUNT) THROW(EXC_MEMORY_ERROR);
+
+        if (!(ready_fields & (1 << i))) {
+            REGISTER_STATIC_UI_VALUE(field->screen, "...");
+            continue;
+        }
+
+        if (ops->operation.absent_fields & (1 << i)) {
+            REGISTER_STATIC_UI_VALUE(field->screen, "None");
+            continue;
+        }
+
+        void const *const value = (uint8_t const *)ops + field->target;
+        switch (field->type) {
+            case OPERATION_FIELD_IMPLICIT:
+            case OPERATION_FIELD_CONTRACT:
+                register_ui_callback(field->screen, parsed_contract_to_string, value);
+                break;
+            case OPERATION_FIELD_ZARITH:
+                if (field->flags & OPERATION_FIELD_FLAG_TEZ) {
+                    register_ui_callback(field->screen, microtez_to_string_indirect, value);
+                } else {
+                    register_ui_callback(field->screen, number_to_string_indirect64, value);
+                }
+                break;
+            case OPERATION_FIELD_INT32:
+                register_ui_callback(field->screen, number_to_string_indirect32, value);
+                break;
+            case OPERATION_FIELD_PROTOCOL_HASH:
+            case OPERATION_FIELD_PROTOCOL_HASHES:
+                register_ui_callback(field->screen, protocol_hash_to_string, value);
+                break;
+            case OPERATION_FIELD_SCRIPT:
+                register_ui_callback(field->screen, script_hash_to_string, value);
+                break;
+            default:
+                THROW(EXC_MEMORY_ERROR);
+        }
+    }
+    return schema;
+}
+
+// Prompts for operations whose screens are fully described by their schema.
+// Returns false if the schema doesn't describe any screens.
+static bool prompt_operation_fields(
+    struct parsed_operation_group const *const ops,
+    ui_callback_t ok, ui_callback_t cxl
+) {
+    struct operation_schema const *const schema = register_operation_fields(ops, ALL_FIELDS_READY);
+    if (schema == NULL) return false;
+
+    ui_prompt((char const *const *)PIC(schema->prompts), ok, cxl);
+}
+
+// Shows the fields of an operation that are final while its later packets are still arriving, so the
+// user can start reviewing it. Nothing can be accepted until the whole operation has been received.
+static void preview_operation_fields(struct parsed_operation_group const *const ops) {
+    if (ops->operation.kind == OPERATION_KIND_NONE) return;
+    if (G.progress_shown && G.progress_fields == ops->operation.ready_fields) return;
+
+    struct operation_schema const *const schema = register_operation_fields(ops, ops->operation.ready_fields);
+    if (schema == NULL) return;
+
+    G.progress_shown = true;
+    G.progress_fields = ops->operation.ready_fields;
+    ui_preview((char const *const *)PIC(schema->prompts));
+}
+
+// The registered screens of a contract call, with the pages of its parameter before the last one. Generators
+// take no context, so the call is read from the operation being signed.
+static void contract_call_screen(
+    size_t const which,
+    char *const prompt, size_t const prompt_size,
+    char *const value, size_t const value_size
+) {
+    static const size_t PARAMETERS_INDEX = 6;
+
+    char const *const parameters = G.maybe_ops.v.operation.parameters;
+    size_t const pages = page_count(parameters);
+    if (which < PARAMETERS_INDEX) {
+        registered_screen(which, prompt, prompt_size, value, value_size);
+    } else if (which < PARAMETERS_INDEX + pages) {
+        page_screen(PROMPT("Parameter"), parameters, which - PARAMETERS_INDEX + 1, pages,
+                    prompt, prompt_size, value, value_size);
+    } else {
+        registered_screen(which - pages, prompt, prompt_size, value, value_size);
+    }
+}
+
 bool prompt_transaction(
     struct parsed_operation_group const *const ops,
     bip32_path_with_curve_t const *const key,
@@ -203,34 +325,50 @@ bool prompt_transaction(
     check_null(ops);
     check_null(key);
 
-    switch (ops->operation.tag) {
+    switch (ops->operation.kind) {
         default:
-            PARSE_ERROR();
+            return prompt_operation_fields(ops, ok, cxl);
 
-        case OPERATION_TAG_PROPOSAL:
+        case OPERATION_KIND_TRANSACTION:
             {
+                if (ops->operation.entrypoint[0] == '\0') return prompt_operation_fields(ops, ok, cxl);
+
+                // Parameters that couldn't be rendered can't be shown; fall back to signing the hash.
+                if (ops->operation.parameters[0] == '\0') return false;
+
                 static const uint32_t TYPE_INDEX = 0;
-                static const uint32_t SOURCE_INDEX = 1;
-                static const uint32_t PERIOD_INDEX = 2;
-                static const uint32_t PROTOCOL_HASH_INDEX = 3;
+                static const uint32_t AMOUNT_INDEX = 1;
+                static const uint32_t FEE_INDEX = 2;
+                static const uint32_t SOURCE_INDEX = 3;
+                static const uint32_t DESTINATION_INDEX = 4;
+                static const uint32_t ENTRYPOINT_INDEX = 5;
+                static const uint32_t STORAGE_INDEX = 6;
 
-                static const char *const proposal_prompts[] = {
+                // The parameter's pages go between the entrypoint and the storage limit.
+                static const char *const contract_call_prompts[] = {
                     PROMPT("Confirm"),
+                    PROMPT("Amount"),
+                    PROMPT("Fee"),
                     PROMPT("Source"),
-                    PROMPT("Period"),
-                    PROMPT("Protocol"),
+                    PROMPT("Destination"),
+                    PROMPT("Entrypoint"),
+                    PROMPT("Storage Limit"),
                     NULL,
                 };
 
+                REGISTER_STATIC_UI_VALUE(TYPE_INDEX, "Contract Call");
+                register_ui_callback(AMOUNT_INDEX, microtez_to_string_indirect, &ops->operation.amount);
+                register_ui_callback(FEE_INDEX, microtez_to_string_indirect, &ops->total_fee);
                 register_ui_callback(SOURCE_INDEX, parsed_contract_to_string, &ops->operation.source);
-                register_ui_callback(PERIOD_INDEX, number_to_string_indirect32, &ops->operation.proposal.voting_period);
-                register_ui_callback(PROTOCOL_HASH_INDEX, protocol_hash_to_string, ops->operation.proposal.protocol_hash);
+                register_ui_callback(DESTINATION_INDEX, parsed_contract_to_string, &ops->operation.destination);
+                register_ui_callback(ENTRYPOINT_INDEX, copy_string, ops->operation.entrypoint);
+                register_ui_callback(STORAGE_INDEX, number_to_string_indirect64, &ops->total_storage_limit);
 
-                REGISTER_STATIC_UI_VALUE(TYPE_INDEX, "Proposal");
-                ui_prompt(proposal_prompts, ok, cxl);
+                size_t const screens = set_registered_screens(contract_call_prompts);
+                ui_prompt_screens(screens + page_count(ops->operation.parameters), contract_call_screen, ok, cxl);
             }
 
-        case OPERATION_TAG_BALLOT:
+        case OPERATION_KIND_BALLOT:
             {
                 static const uint32_t TYPE_INDEX = 0;
                 static const uint32_t SOURCE_INDEX = 1;
@@ -265,83 +403,7 @@ bool prompt_transaction(
                 ui_prompt(ballot_prompts, ok, cxl);
             }
 
-        case OPERATION_TAG_ATHENS_ORIGINATION:
-        case OPERATION_TAG_BABYLON_ORIGINATION:
-            {
-                static const uint32_t TYPE_INDEX = 0;
-                static const uint32_t AMOUNT_INDEX = 1;
-                static const uint32_t FEE_INDEX = 2;
-                static const uint32_t SOURCE_INDEX = 3;
-                static const uint32_t DESTINATION_INDEX = 4;
-                static const uint32_t DELEGATE_INDEX = 5;
-                static const uint32_t STORAGE_INDEX = 6;
-
-                register_ui_callback(SOURCE_INDEX, parsed_contract_to_string, &ops->operation.source);
-                register_ui_callback(DESTINATION_INDEX, parsed_contract_to_string,
-                                     &ops->operation.destination);
-                register_ui_callback(FEE_INDEX, microtez_to_string_indirect, &ops->total_fee);
-                register_ui_callback(STORAGE_INDEX, number_to_string_indirect64,
-                                     &ops->total_storage_limit);
-
-                static const char *const origination_prompts_fixed[] = {
-                    PROMPT("Confirm"),
-                    PROMPT("Amount"),
-                    PROMPT("Fee"),
-                    PROMPT("Source"),
-                    PROMPT("Manager"),
-                    PROMPT("Fixed Delegate"),
-                    PROMPT("Storage Limit"),
-                    NULL,
-                };
-                static const char *const origination_prompts_delegatable[] = {
-                    PROMPT("Confirm"),
-                    PROMPT("Amount"),
-                    PROMPT("Fee"),
-                    PROMPT("Source"),
-                    PROMPT("Manager"),
-                    PROMPT("Delegate"),
-                    PROMPT("Storage Limit"),
-                    NULL,
-                };
-                static const char *const origination_prompts_undelegatable[] = {
-                    PROMPT("Confirm"),
-                    PROMPT("Amount"),
-                    PROMPT("Fee"),
-                    PROMPT("Source"),
-                    PROMPT("Manager"),
-                    PROMPT("Delegation"),
-                    PROMPT("Storage Limit"),
-                    NULL,
-                };
-
-                if (!(ops->operation.flags & ORIGINATION_FLAG_SPENDABLE)) return false;
-
-                REGISTER_STATIC_UI_VALUE(TYPE_INDEX, "Origination");
-                register_ui_callback(AMOUNT_INDEX, microtez_to_string_indirect, &ops->operation.amount);
-
-                char const *const *prompts;
-                bool const delegatable = ops->operation.flags & ORIGINATION_FLAG_DELEGATABLE;
-                bool const has_delegate = ops->operation.delegate.signature_type != SIGNATURE_TYPE_UNSET;
-                if (delegatable && has_delegate) {
-                    prompts = origination_prompts_delegatable;
-                    register_ui_callback(DELEGATE_INDEX, parsed_contract_to_string,
-                                         &ops->operation.delegate);
-                } else if (delegatable && !has_delegate) {
-                    prompts = origination_prompts_delegatable;
-                    REGISTER_STATIC_UI_VALUE(DELEGATE_INDEX, "Any");
-                } else if (!delegatable && has_delegate) {
-                    prompts = origination_prompts_fixed;
-                    register_ui_callback(DELEGATE_INDEX, parsed_contract_to_string,
-                                         &ops->operation.delegate);
-                } else if (!delegatable && !has_delegate) {
-                    prompts = origination_prompts_undelegatable;
-                    REGISTER_STATIC_UI_VALUE(DELEGATE_INDEX, "Disabled");
-                }
-
-                ui_prompt(prompts, ok, cxl);
-            }
-        case OPERATION_TAG_ATHENS_DELEGATION:
-        case OPERATION_TAG_BABYLON_DELEGATION:
+        case OPERATION_KIND_DELEGATION:
             {
                 static const uint32_t TYPE_INDEX = 0;
                 static const uint32_t FEE_INDEX = 1;
@@ -387,39 +449,7 @@ bool prompt_transaction(
                 ui_prompt(withdrawal ? withdrawal_prompts : delegation_prompts, ok, cxl);
             }
 
-        case OPERATION_TAG_ATHENS_TRANSACTION:
-        case OPERATION_TAG_BABYLON_TRANSACTION:
-            {
-                static const uint32_t TYPE_INDEX = 0;
-                static const uint32_t AMOUNT_INDEX = 1;
-                static const uint32_t FEE_INDEX = 2;
-                static const uint32_t SOURCE_INDEX = 3;
-                static const uint32_t DESTINATION_INDEX = 4;
-                static const uint32_t STORAGE_INDEX = 5;
-
-                static const char *const transaction_prompts[] = {
-                    PROMPT("Confirm"),
-                    PROMPT("Amount"),
-                    PROMPT("Fee"),
-                    PROMPT("Source"),
-                    PROMPT("Destination"),
-                    PROMPT("Storage Limit"),
-                    NULL,
-                };
-
-                register_ui_callback(SOURCE_INDEX, parsed_contract_to_string, &ops->operation.source);
-                register_ui_callback(DESTINATION_INDEX, parsed_contract_to_string,
-                                     &ops->operation.destination);
-                register_ui_callback(FEE_INDEX, microtez_to_string_indirect, &ops->total_fee);
-                register_ui_callback(STORAGE_INDEX, number_to_string_indirect64,
-                                     &ops->total_storage_limit);
-                register_ui_callback(AMOUNT_INDEX, microtez_to_string_indirect, &ops->operation.amount);
-
-                REGISTER_STATIC_UI_VALUE(TYPE_INDEX, "Transaction");
-
-                ui_prompt(transaction_prompts, ok, cxl);
-            }
-        case OPERATION_TAG_NONE:
+        case OPERATION_KIND_NONE:
             {
                 static const uint32_t TYPE_INDEX = 0;
                 static const uint32_t SOURCE_INDEX = 1;
@@ -448,6 +478,31 @@ bool prompt_transaction(
     }
 }
 
+// A type screen, then one screen per page of the text.
+static void packed_data_screen(
+    size_t const which,
+    char *const prompt, size_t const prompt_size,
+    char *const value, size_t const value_size
+) {
+    if (which == 0) {
+        copy_string(prompt, prompt_size, PROMPT("Confirm"));
+        copy_string(value, value_size, STATIC_UI_VALUE("Michelson"));
+        return;
+    }
+    page_screen(PROMPT("Data"), G.packed_data.text, which, page_count(G.packed_data.text),
+                prompt, prompt_size, value, value_size);
+}
+
+// Shows packed Michelson data, which was rendered as it streamed in.
+// Returns false if it couldn't be rendered.
+static bool prompt_packed_data(ui_callback_t ok, ui_callback_t cxl) {
+    if (!micheline_printer_done(&G.packed_data.printer)) return false;
+
+    size_t const pages = page_count(G.packed_data.text);
+    if (pages == 0) return false;
+    ui_prompt_screens(1 + pages, packed_data_screen, ok, cxl);
+}
+
 static size_t wallet_sign_complete(uint8_t instruction, uint8_t magic_byte) {
     static size_t const TYPE_INDEX = 0;
     static size_t const HASH_INDEX = 1;
@@ -486,14 +541,18 @@ static size_t wallet_sign_complete(uint8_t instruction, uint8_t magic_byte) {
             case MAGIC_BYTE_BAKING_OP:
             default:
                 PARSE_ERROR();
-            case MAGIC_BYTE_UNSAFE_OP:
-                if (!G.maybe_ops.is_valid || !prompt_transaction(&G.maybe_ops.v, &G.key, ok_c, sign_reject)) {
+            case MAGIC_BYTE_UNSAFE_OP3:
+                if (!prompt_packed_data(ok_c, sign_reject)) {
                     goto unsafe;
                 }
 
             case MAGIC_BYTE_UNSAFE_OP2:
-            case MAGIC_BYTE_UNSAFE_OP3:
                 goto unsafe;
+
+            case MAGIC_BYTE_UNSAFE_OP:
+                if (!G.maybe_ops.is_valid || !prompt_transaction(&G.maybe_ops.v, &G.key, ok_c, sign_reject)) {
+                    goto unsafe;
+                }
         }
 unsafe:
         G.message_data_as_buffer.bytes = (uint8_t *)&G.final_hash;
@@ -510,8 +569,34 @@ unsafe:
 #define P1_FIRST 0x00
 #define P1_NEXT 0x01
 #define P1_HASH_ONLY_NEXT 0x03 // You only need it once
+#define P1_FIRST_FAIL_FAST 0x04 // Like P1_FIRST, but stop at the first parse error
 #define P1_LAST_MARKER 0x80
 
+#ifndef BAKING_APP
+static size_t write_big_endian(uint8_t *const out, size_t tx, uint64_t const value, size_t const size) {
+    for (size_t i = size; i > 0; i--) {
+        out[tx++] = (value >> ((i - 1) * 8)) & 0xFF;
+    }
+    return tx;
+}
+
+// Step of the parser that failed, then offset of the failing byte in the message.
+static size_t write_parse_failure(uint8_t *const out, size_t tx) {
+    tx = write_big_endian(out, tx, (uint16_t)G.parse_state.failed_step, sizeof(uint16_t));
+    return write_big_endian(out, tx, G.parse_state.offset, sizeof(uint32_t));
+}
+
+// Ends the signing session, telling the host which step failed and at which byte of the message.
+static size_t reject_parse_failure(void) {
+    size_t tx = write_parse_failure(G_io_apdu_buffer, 0);
+    clear_data();
+
+    G_io_apdu_buffer[tx++] = EXC_PARSE_ERROR >> 8;
+    G_io_apdu_buffer[tx++] = EXC_PARSE_ERROR & 0xFF;
+    return tx;
+}
+#endif
+
 static uint8_t get_magic_byte_or_throw(uint8_t const *const buff, size_t const buff_size) {
     uint8_t const magic_byte = get_magic_byte(buff, buff_size);
     switch (magic_byte) {
@@ -534,23 +619,30 @@ static size_t handle_apdu(bool const enable_hashing, bool const enable_parsing,
     uint8_t *const buff = &G_io_apdu_buffer[OFFSET_CDATA];
     uint8_t const p1 = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_P1]);
     uint8_t const buff_size = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_LC]);
-    if (buff_size > MAX_APDU_SIZE) THROW(EXC_WRONG_LENGTH_FOR_INS);
 
     bool last = (p1 & P1_LAST_MARKER) != 0;
     switch (p1 & ~P1_LAST_MARKER) {
     case P1_FIRST:
+#ifndef BAKING_APP
+    case P1_FIRST_FAIL_FAST:
+#endif
         clear_data();
+        G.instruction = instruction;
         read_bip32_path(&G.key.bip32_path, buff, buff_size);
         G.key.derivation_type = parse_derivation_type(READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_CURVE]));
+#ifndef BAKING_APP
+        G.fail_fast = (p1 & ~P1_LAST_MARKER) == P1_FIRST_FAIL_FAST;
+#endif
         return finalize_successful_send(0);
 #ifndef BAKING_APP
-    case P1_HASH_ONLY_NEXT:
-        // This is a debugging Easter egg
-        G.hash_only = true;
-        // FALL THROUGH
+    case P1_HASH_ONLY_NEXT: // This is a debugging Easter egg
 #endif
     case P1_NEXT:
         if (G.key.bip32_path.length == 0) THROW(EXC_WRONG_LENGTH_FOR_INS);
+        if (G.instruction != instruction) THROW(EXC_WRONG_LENGTH_FOR_INS); // Not this instruction's session
+#ifndef BAKING_APP
+        if ((p1 & ~P1_LAST_MARKER) == P1_HASH_ONLY_NEXT) G.hash_only = true;
+#endif
 
         // Guard against overflow
         if (G.packet_index >= 0xFF) PARSE_ERROR();
@@ -580,52 +672,59 @@ static size_t handle_apdu(bool const enable_hashing, bool const enable_parsing,
           G.magic_byte = get_magic_byte_or_throw(buff, buff_size);
 
           // If it is an "operation" (starting with the 0x03 magic byte), set up parsing
-          // If it is arbitrary Michelson (starting with 0x05), dont bother parsing and show the "Sign Hash" prompt
+          // If it is arbitrary Michelson (starting with 0x05), set up rendering it
           if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
             parse_operations_init(&G.maybe_ops.v, G.key.derivation_type, &G.key.bip32_path, &G.parse_state);
           }
+          else if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP3) {
+            micheline_printer_init(&G.packed_data.printer, G.packed_data.text, sizeof(G.packed_data.text));
+          }
           // If magic byte is not 0x03 or 0x05, fail
-          else if (G.magic_byte != MAGIC_BYTE_UNSAFE_OP3) {
+          else {
             PARSE_ERROR();
           }
 	    }
 
-      // Only parse if the message is an "Operation"
       if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
-        parse_allowed_operation_packet(&G.maybe_ops.v, buff, buff_size);
+        if (parse_allowed_operation_packet(&G.maybe_ops.v, buff, buff_size)) {
+          if (!last) preview_operation_fields(&G.maybe_ops.v);
+        } else if (G.fail_fast) {
+          return reject_parse_failure();
+        }
+      } else {
+        // Packed data too large or too deep to show is signed as a hash, so stop rendering it once that's known.
+        for (size_t i = G.packet_index == 1 ? 1 /* magic byte */ : 0;
+             i < buff_size && !micheline_printer_failed(&G.packed_data.printer); i++) {
+          micheline_printer_byte(&G.packed_data.printer, buff[i]);
+        }
       }
 
 #       endif
     }
 
     if (enable_hashing) {
-        // Hash contents of *previous* message (which may be empty).
-        blake2b_incremental_hash(
-            G.message_data, sizeof(G.message_data),
-            &G.message_data_length,
-            &G.hash_state);
-    }
-
-    if (G.message_data_length + buff_size > sizeof(G.message_data)) PARSE_ERROR();
+        blake2b_incremental_hash(buff, buff_size, &G.hash_state);
+    } else {
+        if (G.message_data_length + buff_size > sizeof(G.message_data)) PARSE_ERROR();
 
-    memmove(G.message_data + G.message_data_length, buff, buff_size);
-    G.message_data_length += buff_size;
+        memcpy(G.message_data + G.message_data_length, buff, buff_size);
+        G.message_data_length += buff_size;
+    }
 
     if (last) {
         if (enable_hashing) {
-            // Hash contents of *this* message and then get the final hash value.
-            blake2b_incremental_hash(
-                G.message_data, sizeof(G.message_data),
-                &G.message_data_length,
-                &G.hash_state);
-            blake2b_finish_hash(
-                G.final_hash, sizeof(G.final_hash),
-                G.message_data, sizeof(G.message_data),
-                &G.message_data_length,
-                &G.hash_state);
+            blake2b_finish_hash(G.final_hash, sizeof(G.final_hash), &G.hash_state);
         }
 
-	G.maybe_ops.is_valid = parse_operations_final(&G.parse_state, &G.maybe_ops.v);
+        if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
+            G.maybe_ops.is_valid = parse_operations_final(&G.parse_state, &G.maybe_ops.v);
+#           ifndef BAKING_APP
+                if (!G.maybe_ops.is_valid && G.fail_fast) {
+                    G.parse_state.failed_step = G.parse_state.op_step;
+                    return reject_parse_failure();
+                }
+#           endif
+        }
 
         return
 #           ifdef BAKING_APP
@@ -676,3 +775,112 @@ static int perform_signature(bool const on_hash, bool const send_hash) {
     clear_data();
     return finalize_successful_send(tx);
 }
+
+#ifndef BAKING_APP // ----------------------------------------------------------
+
+#define PREVIEW_SUMMARY_VERSION 1
+
+#define PREVIEW_STATUS_PARSED 0
+#define PREVIEW_STATUS_FAILED 1
+
+#define PREVIEW_FLAG_HAS_REVEAL 0x01
+#define PREVIEW_FLAG_MANAGER_TZ 0x02
+
+#define PREVIEW_NO_TAG 0xFF
+
+// The public key is sent as INS_GET_PUBLIC_KEY returns it: a length byte, then the uncompressed key.
+static void read_public_key(
+    cx_ecfp_public_key_t *const out,
+    derivation_type_t const derivation_type,
+    uint8_t const *const in,
+    size_t const in_size
+) {
+    check_null(out);
+    check_null(in);
+    if (in_size < 1) THROW(EXC_WRONG_LENGTH_FOR_INS);
+
+    signature_type_t const signature_type = derivation_type_to_signature_type(derivation_type);
+    size_t const expected_length = signature_type == SIGNATURE_TYPE_ED25519 ? 33 : 65;
+    if (in[0] != expected_length || in_size != 1 + expected_length) THROW(EXC_WRONG_LENGTH_FOR_INS);
+
+    memset(out, 0, sizeof(*out));
+    out->curve = signature_type_to_cx_curve(signature_type);
+    out->W_len = expected_length;
+    memcpy(out->W, in + 1, expected_length);
+}
+
+static size_t write_preview_contract(uint8_t *const out, size_t tx, parsed_contract_t const *const contract) {
+    out[tx++] = contract->originated;
+    out[tx++] = contract->signature_type;
+    memcpy(out + tx, contract->hash, sizeof(contract->hash));
+    return tx + sizeof(contract->hash);
+}
+
+static size_t send_preview_summary(bool const parsed) {
+    struct parsed_operation_group const *const ops = &G.maybe_ops.v;
+    uint8_t *const out = G_io_apdu_buffer;
+
+    size_t tx = 0;
+    out[tx++] = PREVIEW_SUMMARY_VERSION;
+    if (parsed) {
+        out[tx++] = PREVIEW_STATUS_PARSED;
+        out[tx++] = ops->operation.kind;
+        out[tx++] = ops->operation.tag == OPERATION_TAG_NONE ? PREVIEW_NO_TAG : ops->operation.tag;
+        out[tx++] = (ops->has_reveal ? PREVIEW_FLAG_HAS_REVEAL : 0)
+            | (ops->operation.is_manager_tz_operation ? PREVIEW_FLAG_MANAGER_TZ : 0);
+        tx = write_preview_contract(out, tx, &ops->operation.source);
+        tx = write_preview_contract(out, tx, &ops->operation.destination);
+        tx = write_big_endian(out, tx, ops->operation.amount, sizeof(uint64_t));
+        tx = write_big_endian(out, tx, ops->total_fee, sizeof(uint64_t));
+        tx = write_big_endian(out, tx, ops->total_storage_limit, sizeof(uint64_t));
+    } else {
+        out[tx++] = PREVIEW_STATUS_FAILED;
+        tx = write_parse_failure(out, tx);
+    }
+
+    clear_data();
+    return finalize_successful_send(tx);
+}
+
+// Runs an operation through the same parser as INS_SIGN, but nothing is hashed, shown or signed,
+// and the signer is identified by its public key so no key is ever derived.
+size_t handle_apdu_preview_operation(uint8_t __attribute__((unused)) instruction) {
+    uint8_t *const buff = &G_io_apdu_buffer[OFFSET_CDATA];
+    uint8_t const p1 = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_P1]);
+    uint8_t const buff_size = READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_LC]);
+
+    bool const last = (p1 & P1_LAST_MARKER) != 0;
+    switch (p1 & ~P1_LAST_MARKER) {
+    case P1_FIRST: {
+        clear_data();
+        derivation_type_t const derivation_type =
+            parse_derivation_type(READ_UNALIGNED_BIG_ENDIAN(uint8_t, &G_io_apdu_buffer[OFFSET_CURVE]));
+        cx_ecfp_public_key_t public_key;
+        read_public_key(&public_key, derivation_type, buff, buff_size);
+        parse_operations_init_with_public_key(&G.maybe_ops.v, derivation_type, &public_key, &G.parse_state);
+        G.parse_only = true;
+        return finalize_successful_send(0);
+    }
+    case P1_NEXT:
+        if (!G.parse_only) THROW(EXC_WRONG_LENGTH_FOR_INS);
+
+        // Guard against overflow
+        if (G.packet_index >= 0xFF) PARSE_ERROR();
+        G.packet_index++;
+        break;
+    default:
+        THROW(EXC_WRONG_PARAM);
+    }
+
+    if (!parse_allowed_operation_packet(&G.maybe_ops.v, buff, buff_size)) {
+        return send_preview_summary(false);
+    }
+
+    if (!last) return finalize_successful_send(0);
+
+    bool const parsed = parse_operations_final(&G.parse_state, &G.maybe_ops.v);
+    if (!parsed) G.parse_state.failed_step = G.parse_state.op_step;
+    return send_preview_summary(parsed);
+}
+
+#endif // ifndef BAKING_APP ---------------------------------------------------
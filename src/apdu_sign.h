@@ -4,3 +4,6 @@
 
 size_t handle_apdu_sign(uint8_t instruction);
 size_t handle_apdu_sign_with_hash(uint8_t instruction);
+#ifndef BAKING_APP
+size_t handle_apdu_preview_operation(uint8_t instruction);
+#endif
@@ -9,50 +9,141 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
-#include <sys/types.h>
 
 #include "base58.h"
 
 static const char b58digits_ordered[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
-bool b58enc(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *data, size_t binsz)
-{
-    const uint8_t *bin = data;
-    int carry;
-    size_t i, j, high, zcount = 0;
-    size_t size;
+// The number is converted in limbs of 5 base-58 digits, the most that fit in 32 bits. Input is read 32 bits at a
+// time, so each step does one 64-bit division per limb instead of one division per digit and input byte.
+#define LIMB_DIGITS 5
+#define LIMB_BASE ((uint32_t)58 * 58 * 58 * 58 * 58)
+
+// log(256) / log(58^5) is just under 0.2732, so this is an upper bound on the limbs of `size` bytes.
+#define LIMB_COUNT(size) ((size) * 2732 / 10000 + 1)
 
+static inline __attribute__((always_inline)) bool encode(
+    /* out */ char *b58, /* in/out */ size_t *b58sz,
+    const uint8_t *bin, size_t binsz,
+    uint32_t *limbs, size_t max_limbs)
+{
+    size_t zcount = 0;
     while (zcount < binsz && !bin[zcount])
         ++zcount;
 
-    size = (binsz - zcount) * 138 / 100 + 1;
-    uint8_t buf[size];
-    memset(buf, 0, size);
-
-    for (i = zcount, high = size - 1; i < binsz; ++i, high = j)
+    // Input is read in 32-bit words, but the first word takes whatever doesn't divide evenly.
+    size_t limb_count = 0;
+    size_t i = zcount;
+    size_t word_size = (binsz - zcount) % 4 ? (binsz - zcount) % 4 : 4;
+    for (; i < binsz; i += word_size, word_size = 4)
     {
-        for (carry = bin[i], j = size - 1; ((int)j >= 0) && ((j > high) || carry); --j)
+        uint64_t carry = 0;
+        for (size_t k = 0; k < word_size; ++k)
+            carry = (carry << 8) | bin[i + k];
+
+        for (size_t j = 0; j < limb_count; ++j)
+        {
+            uint64_t const t = ((uint64_t)limbs[j] << (8 * word_size)) + carry;
+            limbs[j] = t % LIMB_BASE;
+            carry = t / LIMB_BASE;
+        }
+        while (carry)
         {
-            carry += 256 * buf[j];
-            buf[j] = carry % 58;
-            carry /= 58;
+            if (limb_count == max_limbs)
+                return false;
+            limbs[limb_count++] = carry % LIMB_BASE;
+            carry /= LIMB_BASE;
         }
     }
 
-    for (j = 0; j < size && !buf[j]; ++j);
+    // Digits of the most significant limb, without leading zeros
+    char top[LIMB_DIGITS];
+    size_t top_digits = 0;
+    if (limb_count)
+    {
+        for (uint32_t v = limbs[limb_count - 1]; v; v /= 58)
+            top[top_digits++] = b58digits_ordered[v % 58];
+    }
 
-    if (*b58sz <= zcount + size - j)
+    size_t const length = zcount + top_digits + (limb_count ? (limb_count - 1) * LIMB_DIGITS : 0);
+    if (*b58sz <= length)
     {
-        *b58sz = zcount + size - j + 1;
+        *b58sz = length + 1;
         return false;
     }
 
-    if (zcount)
-        memset(b58, '1', zcount);
-    for (i = zcount; j < size; ++i, ++j)
-        b58[i] = b58digits_ordered[buf[j]];
-    b58[i] = '\0';
-    *b58sz = i + 1;
+    memset(b58, '1', zcount);
+    size_t ix = zcount;
+    while (top_digits)
+        b58[ix++] = top[--top_digits];
+    for (size_t j = limb_count; j > 1; --j)
+    {
+        uint32_t v = limbs[j - 2];
+        for (size_t k = LIMB_DIGITS; k-- > 0;)
+        {
+            b58[ix + k] = b58digits_ordered[v % 58];
+            v /= 58;
+        }
+        ix += LIMB_DIGITS;
+    }
+    b58[ix] = '\0';
+    *b58sz = ix + 1;
 
     return true;
 }
+
+bool b58enc(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *data, size_t binsz)
+{
+    uint32_t limbs[LIMB_COUNT(B58ENC_MAX_SIZE)];
+    return encode(b58, b58sz, data, binsz, limbs, sizeof(limbs) / sizeof(limbs[0]));
+}
+
+#define DEFINE_FIXED_SIZE_ENCODER(size) \
+    bool b58enc_##size(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *data) \
+    { \
+        uint32_t limbs[LIMB_COUNT(size)]; \
+        return encode(b58, b58sz, data, size, limbs, sizeof(limbs) / sizeof(limbs[0])); \
+    }
+
+DEFINE_FIXED_SIZE_ENCODER(27)
+DEFINE_FIXED_SIZE_ENCODER(32)
+DEFINE_FIXED_SIZE_ENCODER(38)
+
+bool b58dec_char(/* in/out */ void *bin, size_t binsz, char c)
+{
+    const char *const digit = memchr(b58digits_ordered, c, sizeof(b58digits_ordered) - 1);
+    if (!digit)
+        return false;
+
+    uint8_t *const out = bin;
+    uint32_t carry = digit - b58digits_ordered;
+    for (size_t j = binsz; j-- > 0;)
+    {
+        carry += (uint32_t)out[j] * 58;
+        out[j] = carry & 0xff;
+        carry >>= 8;
+    }
+    return carry == 0;
+}
+
+bool b58dec(/* out */ void *bin, size_t binsz, const char *b58, size_t b58sz)
+{
+    const uint8_t *const out = bin;
+    memset(bin, 0, binsz);
+
+    size_t ones = 0;
+    while (ones < b58sz && b58[ones] == '1')
+        ++ones;
+
+    for (size_t i = 0; i < b58sz; ++i)
+    {
+        if (!b58dec_char(bin, binsz, b58[i]))
+            return false;
+    }
+
+    // Each leading '1' stands for one leading zero byte, so any other count means another encoding of the number.
+    size_t zcount = 0;
+    while (zcount < binsz && !out[zcount])
+        ++zcount;
+    return zcount == ones;
+}
@@ -1,5 +1,21 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+// Most bytes `b58enc` encodes, not counting leading zero bytes.
+#define B58ENC_MAX_SIZE 64
+
 /* Return true IFF successful, false otherwise. */
 bool b58enc(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *bin, size_t binsz);
+
+// Like `b58enc` for the sizes that are encoded all the time, with the work sized at compile time.
+bool b58enc_27(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *bin); // Key hashes
+bool b58enc_32(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *bin); // Bare hashes
+bool b58enc_38(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *bin); // Protocol hashes
+
+// Decodes `b58sz` characters into exactly `binsz` bytes, big-endian. Fails on characters outside the alphabet,
+// numbers that don't fit and leading '1's that don't match the leading zero bytes.
+bool b58dec(/* out */ void *bin, size_t binsz, const char *b58, size_t b58sz);
+
+// Appends one character to the number `b58dec` is building in `bin`, for text that arrives a character at a time.
+// Start from `binsz` zero bytes, and check leading '1's separately. Fails like `b58dec`.
+bool b58dec_char(/* in/out */ void *bin, size_t binsz, char c);
@@ -0,0 +1,85 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "decimal.h"
+
+// Numbers are split into chunks of 9 digits, the most that fit in 32 bits, and digits are taken from the chunks
+// with a multiplication instead of a division. The device has no divide instruction, so each division is a library
+// call; this way numbers that fit in 32 bits need none and larger ones need one or two.
+#define CHUNK_DIGITS 9
+#define CHUNK_BASE 1000000000u
+#define MAX_CHUNKS 3 // UINT64_MAX has 20 digits
+
+// x / 10 for every 32-bit x: 0xCCCCCCCD is 2^35 / 10 rounded up, and the rounding error is too small to reach
+// the next integer.
+static inline uint32_t divide_by_10(uint32_t const x) {
+    return (uint32_t)(((uint64_t)x * 0xCCCCCCCDu) >> 35);
+}
+
+// Divides `number` by CHUNK_BASE and returns the remainder.
+static uint32_t take_chunk(/* in/out */ uint64_t *const number) {
+    if (*number <= UINT32_MAX) {
+        // The quotient is at most 4, so subtracting beats dividing.
+        uint32_t remainder = (uint32_t)*number;
+        uint32_t quotient = 0;
+        while (remainder >= CHUNK_BASE) {
+            remainder -= CHUNK_BASE;
+            quotient++;
+        }
+        *number = quotient;
+        return remainder;
+    }
+    uint64_t const quotient = *number / CHUNK_BASE;
+    uint32_t const remainder = (uint32_t)(*number - quotient * CHUNK_BASE);
+    *number = quotient;
+    return remainder;
+}
+
+// Writes the digits of `chunk` backwards from `end`, at least `min_digits` of them, and returns where they start.
+static char *chunk_to_digits(char *end, uint32_t chunk, size_t const min_digits) {
+    for (size_t i = 0; i < min_digits || chunk != 0; i++) {
+        uint32_t const quotient = divide_by_10(chunk);
+        *--end = '0' + (chunk - quotient * 10);
+        chunk = quotient;
+    }
+    return end;
+}
+
+size_t decimal_to_string(/* out */ char *const dest, uint64_t number, size_t const fraction_digits) {
+    uint32_t chunks[MAX_CHUNKS];
+    size_t chunk_count = 0;
+    do {
+        chunks[chunk_count++] = take_chunk(&number);
+    } while (number != 0);
+
+    // All digits, right-aligned, with enough leading zeroes for one integer digit.
+    char digits[MAX_CHUNKS * CHUNK_DIGITS];
+    _Static_assert(sizeof(digits) > DECIMAL_MAX_FRACTION_DIGITS, "No room for the integer digit");
+    char *const end = digits + sizeof(digits);
+    char *start = end;
+    for (size_t i = 0; i < chunk_count; i++) {
+        start = chunk_to_digits(start, chunks[i], i + 1 < chunk_count ? CHUNK_DIGITS : 1);
+    }
+    while ((size_t)(end - start) <= fraction_digits) {
+        *--start = '0';
+    }
+
+    size_t const integer_digits = end - start - fraction_digits;
+    memcpy(dest, start, integer_digits);
+    size_t length = integer_digits;
+
+    char const *const fraction = start + integer_digits;
+    size_t fraction_length = fraction_digits;
+    while (fraction_length > 0 && fraction[fraction_length - 1] == '0') {
+        fraction_length--;
+    }
+    if (fraction_length > 0) {
+        dest[length++] = '.';
+        memcpy(dest + length, fraction, fraction_length);
+        length += fraction_length;
+    }
+
+    dest[length] = '\0';
+    return length;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Most characters `decimal_to_string` outputs, not counting the terminating null byte: the 20 digits of
+// UINT64_MAX and a decimal point.
+#define DECIMAL_MAX_LENGTH 21
+
+// Most fraction digits `decimal_to_string` can split off.
+#define DECIMAL_MAX_FRACTION_DIGITS 19
+
+// Writes `number` / 10^`fraction_digits` in decimal, with a null byte, and returns the length without it.
+// The fraction is left out when it is zero, and otherwise has no trailing zeroes.
+// dest must hold DECIMAL_MAX_LENGTH + 1 bytes, or one less when `fraction_digits` is 0.
+size_t decimal_to_string(/* out */ char *dest, uint64_t number, size_t fraction_digits);
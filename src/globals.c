@@ -77,12 +77,9 @@ void calculate_baking_idle_screens_data(void) {
     if (N_data.baking_key.bip32_path.length == 0) {
         STRCPY(global.ui.baking_idle_screens.pkh, "No Key Authorized");
     } else {
-        cx_ecfp_public_key_t const *const pubkey = generate_public_key_return_global(
-            (derivation_type_t const)N_data.baking_key.derivation_type,
-            (bip32_path_t const *const)&N_data.baking_key.bip32_path);
-        pubkey_to_pkh_string(
+        bip32_path_with_curve_to_pkh_string(
             global.ui.baking_idle_screens.pkh, sizeof(global.ui.baking_idle_screens.pkh),
-            (derivation_type_t const)N_data.baking_key.derivation_type, pubkey);
+            (bip32_path_with_curve_t const *const)&N_data.baking_key);
     }
 
 #   ifdef TARGET_NANOX
@@ -4,6 +4,7 @@
 
 #include "bolos_target.h"
 
+#include "micheline.h"
 #include "operations.h"
 
 // Zeros out all globals that can keep track of APDU instruction state.
@@ -13,9 +14,9 @@ void clear_apdu_globals(void);
 // Zeros out all application-specific globals and SDK-specific UI/exchange buffers.
 void init_globals(void);
 
-#define MAX_APDU_SIZE 230  // Maximum number of bytes in a single APDU
+#define MAX_APDU_SIZE 255  // Maximum number of bytes in a single APDU payload, the most LC can declare
 
-// Our buffer must accommodate any remainder from hashing and the next message at once.
+// Largest message INS_SIGN_UNSAFE accepts.
 #define TEZOS_BUFSIZE (BLAKE2B_BLOCKBYTES + MAX_APDU_SIZE)
 
 #define PRIVATE_KEY_DATA_SIZE 32
@@ -41,32 +42,132 @@ typedef struct {
     bool initialized;
 } blake2b_hash_state_t;
 
+#define PACKED_DATA_PAGES 4 // Screens of packed Michelson that can be shown
+
+// Packed Michelson (MAGIC_BYTE_UNSAFE_OP3), rendered as it streams in.
+struct packed_data_state {
+    struct micheline_printer printer;
+    char text[PACKED_DATA_PAGES * VALUE_WIDTH + 1];
+};
+
 typedef struct {
     bip32_path_with_curve_t key;
 
+    // Instruction that started the signing session. The instructions keep different state in the union below,
+    // so the rest of the session has to come from the same one.
+    uint8_t instruction;
+
     uint8_t packet_index; // 0-index is the initial setup packet, 1 is first packet to hash, etc.
 
 #   ifdef BAKING_APP
     parsed_baking_data_t parsed_baking_data;
 #   endif
 
-    struct {
-      bool is_valid;
-      struct parsed_operation_group v;
-    } maybe_ops;
-
-    uint8_t message_data[TEZOS_BUFSIZE];
-    uint32_t message_data_length;
+    union {
+        // Hashed messages are hashed straight out of the APDU buffer and never stored.
+        struct {
+            blake2b_hash_state_t hash_state;
+
+            // Only one kind of payload is parsed per signature.
+            union {
+                struct {
+                    struct {
+                      bool is_valid;
+                      struct parsed_operation_group v;
+                    } maybe_ops;
+                    struct parse_state parse_state;
+                };
+#               ifndef BAKING_APP
+                struct packed_data_state packed_data;
+#               endif
+            };
+        };
+
+        // INS_SIGN_UNSAFE signs the message itself, which is neither hashed nor parsed.
+        struct {
+            uint8_t message_data[TEZOS_BUFSIZE];
+            uint32_t message_data_length;
+        };
+    };
     buffer_t message_data_as_buffer;
 
-    blake2b_hash_state_t hash_state;
     uint8_t final_hash[SIGN_HASH_SIZE];
 
     uint8_t magic_byte;
     bool hash_only;
-    struct parse_state parse_state;
+    bool fail_fast; // Reject as soon as an operation fails to parse
+    bool parse_only; // INS_PREVIEW_OPERATION session: the operation is parsed, never hashed or signed
+
+    // Fields last shown while the operation was still arriving
+    bool progress_shown;
+    uint16_t progress_fields;
 } apdu_sign_state_t;
 
+#define KEY_CACHE_MAX_PATH 5 // Keys of longer paths are not cached
+#ifdef TARGET_NANOX
+#   define KEY_CACHE_SIZE 8
+#else
+#   define KEY_CACHE_SIZE 2
+#endif
+
+// Public key and key hash of a path. There is no private material in here.
+struct key_cache_entry {
+    uint8_t derivation_type; // derivation_type_t, or 0 for a key that is not cached
+    uint8_t path_length;
+    uint32_t path_components[KEY_CACHE_MAX_PATH];
+    struct compressed_public_key public_key;
+    uint8_t hash[HASH_SIZE];
+};
+
+struct key_cache {
+    struct key_cache_entry entries[KEY_CACHE_SIZE]; // Most recently used first
+    uint8_t count;
+
+    // Lookups since the app started, for tuning KEY_CACHE_SIZE
+    uint32_t hits;
+    uint32_t misses;
+};
+
+// INS_GET_PUBLIC_KEYS: keys are derived one at a time as the response is sent.
+typedef struct {
+    derivation_type_t derivation_type;
+    bool hashes; // Send key hashes rather than keys
+
+    bip32_path_t path; // Next path in range mode; scratch space in list mode
+    uint8_t remaining; // Entries left to send
+
+    // List mode: the requested paths, in the format read by read_bip32_path
+    bool list;
+    uint8_t paths[MAX_APDU_SIZE];
+    uint8_t paths_size;
+    uint8_t paths_offset;
+} apdu_batch_pubkey_state_t;
+
+struct prompt_screen {
+    char prompt[PROMPT_WIDTH + 1];
+    char value[VALUE_WIDTH + 1];
+};
+
+#ifdef TARGET_NANOX
+#   define PROMPT_WINDOW_SIZE 3 // The screen on display and the ones next to it
+#   define PROMPT_NO_SCREEN SIZE_MAX
+
+struct prompt_window_entry {
+    size_t index; // PROMPT_NO_SCREEN if none
+    struct prompt_screen screen;
+};
+#else
+// Screens of a prompt rendered ahead of time (see ui_nano_s.c)
+#   define PROMPT_CACHED_SCREENS MAX_SCREEN_COUNT
+#   ifdef BAKING_APP
+#       define PROMPT_SCREENS_SIZE (2 * (VALUE_WIDTH + 1))
+#   else
+#       define PROMPT_SCREENS_SIZE (4 * (VALUE_WIDTH + 1))
+#   endif
+#   define PROMPT_SCREEN_NOT_CACHED 0xFF
+_Static_assert(PROMPT_SCREENS_SIZE <= PROMPT_SCREEN_NOT_CACHED, "Prompt screen offsets don't fit in a byte");
+#endif
+
 typedef struct {
   void *stack_root;
   apdu_handler handlers[INS_MAX + 1];
@@ -91,33 +192,53 @@ typedef struct {
 #   endif
 
     struct {
+      // Screens of prompts made with ui_prompt and ui_preview
       string_generation_callback callbacks[MAX_SCREEN_COUNT];
       const void *callback_data[MAX_SCREEN_COUNT];
+      // This will and must always be static memory full of constants
+      const char *const *labels;
+
+      // Screens are rendered by this when they are shown, so a prompt can have any number of them.
+      screen_generator generate;
+      size_t screen_count;
 
 #     ifdef TARGET_NANOX
-      struct {
-        char prompt[PROMPT_WIDTH + 1];
-        char value[VALUE_WIDTH + 1];
-      } screen[MAX_SCREEN_COUNT];
+      size_t current_screen;
+      bool on_screens; // The flow is on the screens rather than on the steps after them
+      struct prompt_screen shown; // Displayed by the screen step of the prompt flows
+
+      // Screen i, when it is still rendered, is window[i % PROMPT_WINDOW_SIZE].
+      struct prompt_window_entry window[PROMPT_WINDOW_SIZE];
 #     else
       char active_prompt[PROMPT_WIDTH + 1];
       char active_value[VALUE_WIDTH + 1];
 
-      // This will and must always be static memory full of constants
-      const char *const *prompts;
+      // The first screens are rendered once when the prompt is shown, and kept here one after the other as
+      // their label and value with null bytes, so that rotating through them only copies them. Screens that
+      // didn't fit have PROMPT_SCREEN_NOT_CACHED and are rendered each time they are shown.
+      char screens[PROMPT_SCREENS_SIZE];
+      uint8_t screen_offsets[PROMPT_CACHED_SCREENS];
 #     endif
     } prompt;
+
+    bool previewing; // A ui_preview is on screen
   } ui;
 
+  // Unlike `apdu`, this is kept between APDUs and through errors.
+  struct key_cache key_cache;
+
   struct {
       union {
           struct {
               bip32_path_with_curve_t key;
               cx_ecfp_public_key_t public_key;
+              uint8_t chain_code[CHAIN_CODE_SIZE]; // INS_GET_EXTENDED_PUBLIC_KEY only
           } pubkey;
 
           apdu_sign_state_t sign;
 
+          apdu_batch_pubkey_state_t batch_pubkey;
+
 #         ifdef BAKING_APP
           struct {
             level_t reset_level;
@@ -144,12 +265,18 @@ typedef struct {
       } baking_auth;
 #     endif
 
+      // Set while a chained response has parts left to send.
+      response_producer_t response_producer;
+
       struct {
           struct priv_generate_key_pair generate_key_pair;
 
           struct {
               cx_ecfp_public_key_t compressed;
           } public_key_hash;
+
+          // Key of a path too long for `key_cache`
+          struct key_cache_entry uncached_key;
       } priv;
     } apdu;
 } globals_t;
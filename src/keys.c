@@ -44,9 +44,11 @@ size_t read_bip32_path(bip32_path_t *const out, uint8_t const *const in, size_t
     return ix;
 }
 
-key_pair_t *generate_key_pair_return_global(
+// `chain_code_out` may be NULL when the chain code is not wanted.
+static key_pair_t *derive_key_pair_return_global(
     derivation_type_t const derivation_type,
-    bip32_path_t const *const bip32_path
+    bip32_path_t const *const bip32_path,
+    uint8_t *const chain_code_out
 ) {
     check_null(bip32_path);
     struct priv_generate_key_pair *const priv = &global.apdu.priv.generate_key_pair;
@@ -57,11 +59,11 @@ key_pair_t *generate_key_pair_return_global(
         // Old, non BIP32_Ed25519 way...
         os_perso_derive_node_bip32_seed_key(
             HDW_ED25519_SLIP10, CX_CURVE_Ed25519, bip32_path->components, bip32_path->length,
-            priv->private_key_data, NULL, NULL, 0);
+            priv->private_key_data, chain_code_out, NULL, 0);
     } else {
         os_perso_derive_node_bip32(
             cx_curve, bip32_path->components, bip32_path->length,
-            priv->private_key_data, NULL);
+            priv->private_key_data, chain_code_out);
     }
 
     BEGIN_TRY {
@@ -84,6 +86,13 @@ key_pair_t *generate_key_pair_return_global(
     return &priv->res;
 }
 
+key_pair_t *generate_key_pair_return_global(
+    derivation_type_t const derivation_type,
+    bip32_path_t const *const bip32_path
+) {
+    return derive_key_pair_return_global(derivation_type, bip32_path, NULL);
+}
+
 cx_ecfp_public_key_t const *generate_public_key_return_global(
     derivation_type_t const curve,
     bip32_path_t const *const bip32_path
@@ -94,6 +103,18 @@ cx_ecfp_public_key_t const *generate_public_key_return_global(
     return &pair->public_key;
 }
 
+cx_ecfp_public_key_t const *generate_extended_public_key_return_global(
+    uint8_t chain_code_out[CHAIN_CODE_SIZE],
+    derivation_type_t const derivation_type,
+    bip32_path_t const *const bip32_path
+) {
+    check_null(chain_code_out);
+    check_null(bip32_path);
+    key_pair_t *const pair = derive_key_pair_return_global(derivation_type, bip32_path, chain_code_out);
+    explicit_bzero(&pair->private_key, sizeof(pair->private_key));
+    return &pair->public_key;
+}
+
 cx_ecfp_public_key_t const *public_key_hash_return_global(
     uint8_t *const out, size_t const out_size,
     derivation_type_t const curve,
@@ -129,6 +150,63 @@ cx_ecfp_public_key_t const *public_key_hash_return_global(
     return compressed;
 }
 
+static bool key_cache_entry_matches(
+    struct key_cache_entry const *const entry,
+    derivation_type_t const derivation_type,
+    bip32_path_t const *const bip32_path
+) {
+    return entry->derivation_type == derivation_type
+        && entry->path_length == bip32_path->length
+        && memcmp(entry->path_components, bip32_path->components,
+                  bip32_path->length * sizeof(bip32_path->components[0])) == 0;
+}
+
+struct key_cache_entry const *public_key_hash_of_path_return_global(
+    derivation_type_t const derivation_type,
+    bip32_path_t const *const bip32_path
+) {
+    check_null(bip32_path);
+    struct key_cache *const cache = &global.key_cache;
+    bool const cacheable = bip32_path->length <= KEY_CACHE_MAX_PATH;
+
+    if (cacheable) {
+        for (size_t i = 0; i < cache->count; i++) {
+            if (key_cache_entry_matches(&cache->entries[i], derivation_type, bip32_path)) {
+                cache->hits++;
+                struct key_cache_entry const hit = cache->entries[i];
+                memmove(&cache->entries[1], &cache->entries[0], i * sizeof(cache->entries[0]));
+                cache->entries[0] = hit;
+                return &cache->entries[0];
+            }
+        }
+    }
+    cache->misses++;
+
+    // Derive before touching the cache, so that a failure leaves it as it was.
+    uint8_t hash[HASH_SIZE];
+    cx_ecfp_public_key_t const *const compressed = public_key_hash_return_global(
+        hash, sizeof(hash), derivation_type, generate_public_key_return_global(derivation_type, bip32_path));
+
+    if (compressed->W_len > MAX_COMPRESSED_PUBLIC_KEY_SIZE) THROW(EXC_MEMORY_ERROR);
+
+    // Keys of paths too long to cache are returned from scratch space, so that they evict nothing. Others take
+    // the place of the least recently used entry.
+    struct key_cache_entry *entry = &global.apdu.priv.uncached_key;
+    entry->derivation_type = 0;
+    if (cacheable) {
+        if (cache->count < KEY_CACHE_SIZE) cache->count++;
+        memmove(&cache->entries[1], &cache->entries[0], (cache->count - 1) * sizeof(cache->entries[0]));
+        entry = &cache->entries[0];
+        memcpy(entry->path_components, bip32_path->components, bip32_path->length * sizeof(bip32_path->components[0]));
+        entry->path_length = bip32_path->length;
+        entry->derivation_type = derivation_type;
+    }
+    entry->public_key.length = compressed->W_len;
+    memcpy(entry->public_key.bytes, compressed->W, compressed->W_len);
+    memcpy(entry->hash, hash, sizeof(entry->hash));
+    return entry;
+}
+
 size_t sign(
     uint8_t *const out, size_t const out_size,
     derivation_type_t const derivation_type,
@@ -55,12 +55,29 @@ static inline void generate_public_key(
     memcpy(out, result, sizeof(*out));
 }
 
+// Non-reentrant
+// Like `generate_public_key_return_global`, and also writes the chain code of the node, which lets the
+// public keys of its unhardened children be derived without the device.
+cx_ecfp_public_key_t const *generate_extended_public_key_return_global(
+    uint8_t chain_code_out[CHAIN_CODE_SIZE],
+    derivation_type_t const derivation_type,
+    bip32_path_t const *const bip32_path);
+
 // Non-reentrant
 cx_ecfp_public_key_t const *public_key_hash_return_global(
     uint8_t *const out, size_t const out_size,
     derivation_type_t const derivation_type,
     cx_ecfp_public_key_t const *const restrict public_key);
 
+struct key_cache_entry;
+
+// Non-reentrant
+// Compressed public key and key hash of a path. Recently used paths are answered from `global.key_cache`
+// without deriving anything. The result is only valid until the next call.
+struct key_cache_entry const *public_key_hash_of_path_return_global(
+    derivation_type_t const derivation_type,
+    bip32_path_t const *const bip32_path);
+
 // Non-reentrant
 static inline void public_key_hash(
     uint8_t *const hash_out, size_t const hash_out_size,
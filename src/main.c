@@ -1,4 +1,5 @@
 #include "apdu_baking.h"
+#include "apdu_batch_pubkey.h"
 #include "apdu_hmac.h"
 #include "apdu_pubkey.h"
 #include "apdu_setup.h"
@@ -19,6 +20,9 @@ void app_main(void) {
     global.handlers[APDU_INS(INS_SIGN)] = handle_apdu_sign;
     global.handlers[APDU_INS(INS_GIT)] = handle_apdu_git;
     global.handlers[APDU_INS(INS_SIGN_WITH_HASH)] = handle_apdu_sign_with_hash;
+    global.handlers[APDU_INS(INS_QUERY_CHUNK_SIZE)] = handle_apdu_chunk_size;
+    global.handlers[APDU_INS(INS_GET_PUBLIC_KEYS)] = handle_apdu_get_public_keys;
+    global.handlers[APDU_INS(INS_QUERY_KEY_CACHE_STATS)] = handle_apdu_key_cache_stats;
 #ifdef BAKING_APP
     global.handlers[APDU_INS(INS_AUTHORIZE_BAKING)] = handle_apdu_get_public_key;
     global.handlers[APDU_INS(INS_RESET)] = handle_apdu_reset;
@@ -31,6 +35,8 @@ void app_main(void) {
     global.handlers[APDU_INS(INS_HMAC)] = handle_apdu_hmac;
 #else
     global.handlers[APDU_INS(INS_SIGN_UNSAFE)] = handle_apdu_sign;
+    global.handlers[APDU_INS(INS_PREVIEW_OPERATION)] = handle_apdu_preview_operation;
+    global.handlers[APDU_INS(INS_GET_EXTENDED_PUBLIC_KEY)] = handle_apdu_get_extended_public_key;
 #endif
-    main_loop(global.handlers, sizeof(global.handlers));
+    main_loop(global.handlers, NUM_ELEMENTS(global.handlers));
 }
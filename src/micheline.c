@@ -0,0 +1,352 @@
+#include "micheline.h"
+
+#include "to_string.h"
+#include "types.h"
+
+#include <string.h>
+
+enum micheline_tag {
+    MICHELINE_TAG_INT = 0x00,
+    MICHELINE_TAG_STRING = 0x01,
+    MICHELINE_TAG_SEQUENCE = 0x02,
+    MICHELINE_TAG_PRIM = 0x03, // No arguments, no annotations
+    MICHELINE_TAG_PRIM_ANNOTS = 0x04,
+    MICHELINE_TAG_PRIM_1 = 0x05,
+    MICHELINE_TAG_PRIM_1_ANNOTS = 0x06,
+    MICHELINE_TAG_PRIM_2 = 0x07,
+    MICHELINE_TAG_PRIM_2_ANNOTS = 0x08,
+    MICHELINE_TAG_PRIM_GENERIC = 0x09, // Length-prefixed arguments, then annotations
+    MICHELINE_TAG_BYTES = 0x0A,
+};
+
+enum micheline_step {
+    MICHELINE_STEP_NODE,
+    MICHELINE_STEP_PRIM,
+    MICHELINE_STEP_LENGTH,
+    MICHELINE_STEP_INT,
+    MICHELINE_STEP_STRING,
+    MICHELINE_STEP_BYTES,
+    MICHELINE_STEP_ANNOTS,
+    MICHELINE_STEP_DONE,
+    MICHELINE_STEP_FAILED,
+};
+
+#define MICHELINE_FRAME_FLAG_PARENS 0x01 // Node is an argument and needs a closing parenthesis
+#define MICHELINE_FRAME_FLAG_NOT_EMPTY 0x02 // Sequence has had at least one element
+
+// Primitive names, in opcode order, separated by null bytes.
+static const char primitive_names[] =
+    "parameter\0storage\0code\0False\0Elt\0Left\0None\0Pair\0Right\0Some\0True\0Unit\0"
+    "PACK\0UNPACK\0BLAKE2B\0SHA256\0SHA512\0ABS\0ADD\0AMOUNT\0AND\0BALANCE\0CAR\0CDR\0"
+    "CHECK_SIGNATURE\0COMPARE\0CONCAT\0CONS\0CREATE_ACCOUNT\0CREATE_CONTRACT\0IMPLICIT_ACCOUNT\0DIP\0"
+    "DROP\0DUP\0EDIV\0EMPTY_MAP\0EMPTY_SET\0EQ\0EXEC\0FAILWITH\0GE\0GET\0GT\0HASH_KEY\0IF\0IF_CONS\0"
+    "IF_LEFT\0IF_NONE\0INT\0LAMBDA\0LE\0LEFT\0LOOP\0LSL\0LSR\0LT\0MAP\0MEM\0MUL\0NEG\0NEQ\0NIL\0NONE\0"
+    "NOT\0NOW\0OR\0PAIR\0PUSH\0RIGHT\0SIZE\0SOME\0SOURCE\0SENDER\0SELF\0STEPS_TO_QUOTA\0SUB\0SWAP\0"
+    "TRANSFER_TOKENS\0SET_DELEGATE\0UNIT\0UPDATE\0XOR\0ITER\0LOOP_LEFT\0ADDRESS\0CONTRACT\0ISNAT\0"
+    "CAST\0RENAME\0bool\0contract\0int\0key\0key_hash\0lambda\0list\0map\0big_map\0nat\0option\0or\0"
+    "pair\0set\0signature\0string\0bytes\0mutez\0timestamp\0unit\0operation\0address\0SLICE\0DIG\0"
+    "DUG\0EMPTY_BIG_MAP\0APPLY\0chain_id\0CHAIN_ID\0LEVEL\0SELF_ADDRESS\0never\0NEVER\0UNPAIR\0"
+    "VOTING_POWER\0TOTAL_VOTING_POWER\0KECCAK\0SHA3\0PAIRING_CHECK\0bls12_381_g1\0bls12_381_g2\0"
+    "bls12_381_fr\0sapling_state\0sapling_transaction_deprecated\0SAPLING_EMPTY_STATE\0"
+    "SAPLING_VERIFY_UPDATE\0ticket\0TICKET_DEPRECATED\0READ_TICKET\0SPLIT_TICKET\0JOIN_TICKETS\0"
+    "GET_AND_UPDATE\0chest\0chest_key\0OPEN_CHEST\0VIEW\0view\0constant\0SUB_MUTEZ\0"
+    "tx_rollup_l2_address\0MIN_BLOCK_TIME\0sapling_transaction\0EMIT\0Lambda_rec\0LAMBDA_REC\0"
+    "TICKET\0BYTES\0NAT\0";
+
+// Returns NULL for unknown primitives.
+static char const *primitive_name(uint8_t const prim) {
+    char const *name = primitive_names;
+    for (uint8_t i = 0; i < prim; i++) {
+        name += strlen(name) + 1;
+        if (name >= primitive_names + sizeof(primitive_names) - 1) return NULL;
+    }
+    return name;
+}
+
+static inline void fail(struct micheline_printer *const printer) {
+    printer->step = MICHELINE_STEP_FAILED;
+}
+
+static void print(struct micheline_printer *const printer, char const *const str) {
+    size_t const length = strlen(str);
+    if (printer->out_length + length >= printer->out_size) {
+        fail(printer);
+        return;
+    }
+    memcpy(printer->out + printer->out_length, str, length + 1);
+    printer->out_length += length;
+}
+
+static inline void print_char(struct micheline_printer *const printer, char const c) {
+    char const str[] = {c, '\0'};
+    print(printer, str);
+}
+
+// Strings are shown verbatim between quotes, so anything that would need escaping is refused.
+static inline bool is_displayable_char(uint8_t const c) {
+    return c >= 0x20 && c < 0x7F && c != '"' && c != '\\';
+}
+
+static inline struct micheline_frame *top(struct micheline_printer *const printer) {
+    return &printer->stack[printer->depth - 1];
+}
+
+static inline void read_length(struct micheline_printer *const printer, uint8_t const length_for) {
+    printer->length_for = length_for;
+    printer->length_bytes = 0;
+    printer->remaining = 0;
+    printer->step = MICHELINE_STEP_LENGTH;
+}
+
+// Called whenever a node ends; works out what the enclosing frames expect next.
+static void node_done(struct micheline_printer *const printer) {
+    while (printer->step != MICHELINE_STEP_FAILED) {
+        if (printer->depth == 0) {
+            printer->step = MICHELINE_STEP_DONE;
+            return;
+        }
+
+        struct micheline_frame *const frame = top(printer);
+        switch (frame->tag) {
+            case MICHELINE_TAG_SEQUENCE:
+            case MICHELINE_TAG_PRIM_GENERIC:
+                if (printer->offset > frame->end) {
+                    fail(printer);
+                    return;
+                }
+                if (printer->offset < frame->end) {
+                    printer->step = MICHELINE_STEP_NODE;
+                    return;
+                }
+                if (frame->tag == MICHELINE_TAG_PRIM_GENERIC) {
+                    read_length(printer, MICHELINE_STEP_ANNOTS);
+                    return;
+                }
+                print(printer, (frame->flags & MICHELINE_FRAME_FLAG_NOT_EMPTY) ? " }" : "}");
+                break;
+
+            default:
+                if (frame->args_left > 0) {
+                    printer->step = MICHELINE_STEP_NODE;
+                    return;
+                }
+                if (frame->tag == MICHELINE_TAG_PRIM_ANNOTS ||
+                    frame->tag == MICHELINE_TAG_PRIM_1_ANNOTS ||
+                    frame->tag == MICHELINE_TAG_PRIM_2_ANNOTS) {
+                    read_length(printer, MICHELINE_STEP_ANNOTS);
+                    return;
+                }
+                if (frame->flags & MICHELINE_FRAME_FLAG_PARENS) print(printer, ")");
+                break;
+        }
+
+        // The frame's own node is complete; its parent sees the end of a child.
+        printer->depth--;
+    }
+}
+
+// Closes a primitive once its annotations have been read.
+static void prim_done(struct micheline_printer *const printer) {
+    struct micheline_frame *const frame = top(printer);
+    if (frame->flags & MICHELINE_FRAME_FLAG_PARENS) print(printer, ")");
+    printer->depth--;
+    node_done(printer);
+}
+
+static void begin_node(struct micheline_printer *const printer, uint8_t const tag) {
+    bool in_arguments = false;
+    if (printer->depth > 0) {
+        struct micheline_frame *const parent = top(printer);
+        if (parent->tag == MICHELINE_TAG_SEQUENCE) {
+            print(printer, (parent->flags & MICHELINE_FRAME_FLAG_NOT_EMPTY) ? " ; " : " ");
+            parent->flags |= MICHELINE_FRAME_FLAG_NOT_EMPTY;
+        } else {
+            print(printer, " ");
+            in_arguments = true;
+            if (parent->args_left > 0) parent->args_left--;
+        }
+    }
+
+    switch (tag) {
+        case MICHELINE_TAG_INT:
+            printer->int_value = 0;
+            printer->int_shift = 0;
+            printer->step = MICHELINE_STEP_INT;
+            return;
+        case MICHELINE_TAG_STRING:
+            print(printer, "\"");
+            read_length(printer, MICHELINE_STEP_STRING);
+            return;
+        case MICHELINE_TAG_BYTES:
+            print(printer, "0x");
+            read_length(printer, MICHELINE_STEP_BYTES);
+            return;
+        case MICHELINE_TAG_SEQUENCE:
+        case MICHELINE_TAG_PRIM:
+        case MICHELINE_TAG_PRIM_ANNOTS:
+        case MICHELINE_TAG_PRIM_1:
+        case MICHELINE_TAG_PRIM_1_ANNOTS:
+        case MICHELINE_TAG_PRIM_2:
+        case MICHELINE_TAG_PRIM_2_ANNOTS:
+        case MICHELINE_TAG_PRIM_GENERIC:
+            break;
+        default:
+            fail(printer);
+            return;
+    }
+
+    if (printer->depth >= MICHELINE_MAX_DEPTH) {
+        fail(printer);
+        return;
+    }
+    struct micheline_frame *const frame = &printer->stack[printer->depth++];
+    frame->tag = tag;
+    frame->flags = 0;
+    frame->end = 0;
+    frame->args_left = 0;
+
+    if (tag == MICHELINE_TAG_SEQUENCE) {
+        print(printer, "{");
+        read_length(printer, MICHELINE_STEP_NODE);
+        return;
+    }
+
+    if (tag >= MICHELINE_TAG_PRIM_1 && tag <= MICHELINE_TAG_PRIM_2_ANNOTS) {
+        frame->args_left = (tag - MICHELINE_TAG_PRIM_ANNOTS + 1) / 2;
+    }
+    if (in_arguments && tag != MICHELINE_TAG_PRIM) {
+        frame->flags |= MICHELINE_FRAME_FLAG_PARENS;
+        print(printer, "(");
+    }
+    printer->step = MICHELINE_STEP_PRIM;
+}
+
+// A 4-byte length has been read into `remaining`.
+static void length_done(struct micheline_printer *const printer) {
+    switch (printer->length_for) {
+        case MICHELINE_STEP_STRING:
+        case MICHELINE_STEP_BYTES:
+            if (printer->remaining == 0) {
+                if (printer->length_for == MICHELINE_STEP_STRING) print(printer, "\"");
+                node_done(printer);
+            } else {
+                printer->step = printer->length_for;
+            }
+            return;
+
+        case MICHELINE_STEP_ANNOTS:
+            if (printer->remaining == 0) {
+                prim_done(printer);
+            } else {
+                print(printer, " ");
+                printer->step = MICHELINE_STEP_ANNOTS;
+            }
+            return;
+
+        default: // Sequence elements or generic primitive arguments
+            top(printer)->end = printer->offset + printer->remaining;
+            node_done(printer);
+            return;
+    }
+}
+
+void micheline_printer_init(struct micheline_printer *const printer, char *const out, size_t const out_size) {
+    memset(printer, 0, sizeof(*printer));
+    printer->step = MICHELINE_STEP_NODE;
+    printer->out = out;
+    printer->out_size = out_size;
+    if (out_size == 0) {
+        fail(printer);
+        return;
+    }
+    out[0] = '\0';
+}
+
+void micheline_printer_byte(struct micheline_printer *const printer, uint8_t const byte) {
+    printer->offset++;
+
+    switch (printer->step) {
+        case MICHELINE_STEP_NODE:
+            begin_node(printer, byte);
+            return;
+
+        case MICHELINE_STEP_PRIM: {
+            char const *const name = primitive_name(byte);
+            if (name == NULL) {
+                fail(printer);
+                return;
+            }
+            print(printer, name);
+
+            struct micheline_frame *const frame = top(printer);
+            if (frame->tag == MICHELINE_TAG_PRIM_GENERIC) {
+                read_length(printer, MICHELINE_STEP_NODE);
+            } else {
+                node_done(printer);
+            }
+            return;
+        }
+
+        case MICHELINE_STEP_LENGTH:
+            printer->remaining = (printer->remaining << 8) | byte;
+            if (++printer->length_bytes == sizeof(uint32_t)) length_done(printer);
+            return;
+
+        case MICHELINE_STEP_INT: {
+            // Zarith: the first byte has a sign bit and 6 bits of magnitude, the others 7 bits.
+            uint8_t const bits = printer->int_shift == 0 ? 6 : 7;
+            uint64_t const chunk = byte & ((1 << bits) - 1);
+            if (printer->int_shift == 0) printer->int_negative = byte & 0x40;
+            if (printer->int_shift >= 64 || (printer->int_shift > 64 - bits && (chunk >> (64 - printer->int_shift)) != 0)) {
+                fail(printer); // Doesn't fit in 64 bits
+                return;
+            }
+            printer->int_value |= chunk << printer->int_shift;
+            printer->int_shift += bits;
+            if (byte & 0x80) return;
+
+            char digits[MAX_INT_DIGITS + 1];
+            number_to_string(digits, printer->int_value);
+            if (printer->int_negative) print(printer, "-");
+            print(printer, digits);
+            node_done(printer);
+            return;
+        }
+
+        case MICHELINE_STEP_STRING:
+        case MICHELINE_STEP_ANNOTS:
+            if (!is_displayable_char(byte)) {
+                fail(printer);
+                return;
+            }
+            print_char(printer, byte);
+            if (--printer->remaining > 0) return;
+            if (printer->step == MICHELINE_STEP_STRING) {
+                print(printer, "\"");
+                node_done(printer);
+            } else {
+                prim_done(printer);
+            }
+            return;
+
+        case MICHELINE_STEP_BYTES: {
+            static const char hex_digits[] = "0123456789abcdef";
+            print_char(printer, hex_digits[byte >> 4]);
+            print_char(printer, hex_digits[byte & 0x0F]);
+            if (--printer->remaining == 0) node_done(printer);
+            return;
+        }
+
+        default: // Trailing bytes after a complete expression, or already failed.
+            fail(printer);
+            return;
+    }
+}
+
+bool micheline_printer_done(struct micheline_printer const *const printer) {
+    return printer->step == MICHELINE_STEP_DONE;
+}
+
+bool micheline_printer_failed(struct micheline_printer const *const printer) {
+    return printer->step == MICHELINE_STEP_FAILED;
+}
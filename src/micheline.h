@@ -0,0 +1,53 @@
+// Streaming printer for binary-encoded Micheline expressions.
+//
+// Bytes are fed one at a time and rendered straight into a caller-provided text
+// window, so an expression never has to be held in RAM. The printer gives up,
+// rather than failing the caller, when the expression is nested too deeply,
+// doesn't fit in the window, or isn't something it can render faithfully; the
+// caller decides what to do in that case.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MICHELINE_MAX_DEPTH 12
+
+struct micheline_frame {
+    uint32_t end; // Offset at which a sequence or the arguments of a generic primitive end
+    uint8_t tag; // Micheline node tag
+    uint8_t args_left; // For primitives with a fixed number of arguments
+    uint8_t flags; // MICHELINE_FRAME_FLAG_*
+};
+
+struct micheline_printer {
+    uint32_t offset; // Bytes fed so far
+    uint8_t step;
+    uint8_t depth;
+    struct micheline_frame stack[MICHELINE_MAX_DEPTH];
+
+    // Scalar being decoded
+    uint8_t length_for; // What the 4-byte length being read belongs to
+    uint8_t length_bytes;
+    uint32_t remaining; // Length, then bytes left in a string, byte sequence or annotation
+    uint64_t int_value;
+    uint8_t int_shift;
+    bool int_negative;
+
+    char *out;
+    size_t out_size;
+    size_t out_length;
+};
+
+// `out` receives a null-terminated rendering of the expression.
+void micheline_printer_init(struct micheline_printer *const printer, char *const out, size_t const out_size);
+
+// Feeds the next byte of the expression.
+void micheline_printer_byte(struct micheline_printer *const printer, uint8_t const byte);
+
+// True once exactly one complete expression has been fed and rendered.
+bool micheline_printer_done(struct micheline_printer const *const printer);
+
+// True if the expression can't be rendered; later bytes are ignored.
+bool micheline_printer_failed(struct micheline_printer const *const printer);
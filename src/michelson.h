@@ -42,7 +42,6 @@ enum michelson_params_tag {
 
 #define MAX_MICHELSON_SEQUENCE_LENGTH 200
 
-#define MAX_ENTRYPOINT_LENGTH 31
 enum entrypoint_tag {
     ENTRYPOINT_DEFAULT = 0,
     ENTRYPOINT_ROOT = 1,
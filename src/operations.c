@@ -1,12 +1,15 @@
 #include "operations.h"
 
+#include "base58.h"
 #include "apdu.h"
 #include "globals.h"
 #include "memory.h"
 #include "to_string.h"
 #include "ui.h"
 #include "michelson.h"
+#include "micheline.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -20,7 +23,10 @@ static void parse_error(
 #endif
     uint32_t lineno) {
 
-    global.apdu.u.sign.parse_state.op_step=STEP_HARD_FAIL;
+    struct parse_state *const state = &global.apdu.u.sign.parse_state;
+    if (state->op_step != STEP_HARD_FAIL) state->failed_step = state->op_step;
+    state->op_step=STEP_HARD_FAIL;
+    state->next_type_size = 0;
 #ifdef TEZOS_DEBUG
     THROW(0x9000 + lineno);
 #else
@@ -44,23 +50,42 @@ static inline signature_type_t parse_raw_tezos_header_signature_type(
     }
 }
 
+static inline void set_signer_type(parsed_contract_t *const contract_out, derivation_type_t const derivation_type) {
+    contract_out->signature_type = derivation_type_to_signature_type(derivation_type);
+    if (contract_out->signature_type == SIGNATURE_TYPE_UNSET) THROW(EXC_MEMORY_ERROR);
+    contract_out->originated = 0;
+}
+
+static inline void set_signer(
+    struct compressed_public_key *const compressed_pubkey_out,
+    parsed_contract_t *const contract_out,
+    derivation_type_t const derivation_type,
+    cx_ecfp_public_key_t const *const pubkey
+) {
+    check_null(compressed_pubkey_out);
+    check_null(contract_out);
+    check_null(pubkey);
+    cx_ecfp_public_key_t const *const compressed = public_key_hash_return_global(
+        contract_out->hash, sizeof(contract_out->hash), derivation_type, pubkey);
+    if (compressed->W_len > sizeof(compressed_pubkey_out->bytes)) THROW(EXC_MEMORY_ERROR);
+    compressed_pubkey_out->length = compressed->W_len;
+    memcpy(compressed_pubkey_out->bytes, compressed->W, compressed->W_len);
+    set_signer_type(contract_out, derivation_type);
+}
+
 static inline void compute_pkh(
-    cx_ecfp_public_key_t *const compressed_pubkey_out,
+    struct compressed_public_key *const compressed_pubkey_out,
     parsed_contract_t *const contract_out,
     derivation_type_t const derivation_type,
     bip32_path_t const *const bip32_path
 ) {
-    check_null(bip32_path);
     check_null(compressed_pubkey_out);
     check_null(contract_out);
-    cx_ecfp_public_key_t const *const pubkey = generate_public_key_return_global(derivation_type, bip32_path);
-    public_key_hash(
-        contract_out->hash, sizeof(contract_out->hash),
-        compressed_pubkey_out,
-        derivation_type, pubkey);
-    contract_out->signature_type = derivation_type_to_signature_type(derivation_type);
-    if (contract_out->signature_type == SIGNATURE_TYPE_UNSET) THROW(EXC_MEMORY_ERROR);
-    contract_out->originated = 0;
+    check_null(bip32_path);
+    struct key_cache_entry const *const key = public_key_hash_of_path_return_global(derivation_type, bip32_path);
+    memcpy(compressed_pubkey_out, &key->public_key, sizeof(*compressed_pubkey_out));
+    memcpy(contract_out->hash, key->hash, sizeof(contract_out->hash));
+    set_signer_type(contract_out, derivation_type);
 }
 
 static inline void parse_implicit(
@@ -79,9 +104,11 @@ static inline void parse_contract(parsed_contract_t *const out, struct contract
     if (out->originated == 0) { // implicit
         out->signature_type = parse_raw_tezos_header_signature_type(&in->u.implicit.signature_type);
         memcpy(out->hash, in->u.implicit.pkh, sizeof(out->hash));
-    } else { // originated
+    } else if (out->originated == 1 && in->u.originated.padding == 0) { // originated
         out->signature_type = SIGNATURE_TYPE_UNSET;
         memcpy(out->hash, in->u.originated.pkh, sizeof(out->hash));
+    } else {
+        PARSE_ERROR();
     }
 }
 
@@ -96,59 +123,84 @@ static inline void parse_contract(parsed_contract_t *const out, struct contract
 
 #define NEXT_BYTE (byte)
 
+// Adds a 7-bit group after the first to a variable-length integer; not a subparser itself, but part of the two
+// below. Numbers that don't fit in 64 bits and encodings that end in a zero byte, which the protocol rejects, are
+// parse errors.
+static inline bool parse_z_group(uint8_t current_byte, struct int_subparser_state *state) {
+  uint64_t const bits = current_byte & 0x7F;
+  if (state->shift >= 64 || (bits << state->shift) >> state->shift != bits) PARSE_ERROR();
+  if (current_byte == 0) PARSE_ERROR();
+  state->value |= bits << state->shift;
+  state->shift += 7;
+  return current_byte & 0x80; // Return true if we need more bytes.
+}
+
 static inline bool parse_z(uint8_t current_byte, struct int_subparser_state *state, uint32_t lineno) {
   if(state->lineno != lineno) {
       // New call; initialize.
       state->lineno = lineno;
-      state->value = 0;
-      state->shift = 0;
+      state->value = current_byte & 0x7F;
+      state->shift = 7;
+      return current_byte & 0x80; // Return true if we need more bytes.
   }
-  state->value |= ((uint64_t)current_byte & 0x7F) << state->shift;
-  state->shift += 7;
-  return current_byte & 0x80; // Return true if we need more bytes.
+  return parse_z_group(current_byte, state);
 }
 
 #define PARSE_Z ({CALL_SUBPARSER(parse_z, (byte), &(state)->subparser_state.integer); (state)->subparser_state.integer.value;})
 
+// Micheline integers are signed: their first byte has a sign bit and 6 bits of the number. Only amounts of mutez
+// are read, which are never negative.
 // Only used through the macro
 static inline bool parse_z_michelson(uint8_t current_byte, struct int_subparser_state *state, uint32_t lineno) {
   if(state->lineno != lineno) {
       // New call; initialize.
       state->lineno = lineno;
-      state->value = 0;
-      state->shift = 0;
-  }
-  state->value |= ((uint64_t)current_byte & 0x7F) << state->shift;
-  // For some reason we are getting numbers shifted 1 bit to the
-  // left. TODO: figure out why this happens
-  if (state->shift == 0) {
-      state->shift += 6;
-  } else {
-      state->shift += 7;
+      if (current_byte & 0x40) PARSE_ERROR();
+      state->value = current_byte & 0x3F;
+      state->shift = 6;
+      return current_byte & 0x80; // Return true if we need more bytes.
   }
-  return current_byte & 0x80; // Return true if we need more bytes.
+  return parse_z_group(current_byte, state);
 }
 
 #define PARSE_Z_MICHELSON ({CALL_SUBPARSER(parse_z_michelson, (byte), (&state->subparser_state.integer)); state->subparser_state.integer.value;})
 
 static inline bool parse_next_type(uint8_t current_byte, struct nexttype_subparser_state *state, uint32_t sizeof_type, uint32_t lineno) {
-    #ifdef DEBUG
-    if(sizeof_type > sizeof(state->body)) PARSE_ERROR(); // Shouldn't happen, but error if it does and we're debugging. Neither side is dynamic.
-    #endif
+    // The body is only as large as the largest type read through it; lengths taken from the message must fit.
+    if(sizeof_type > sizeof(state->body)) PARSE_ERROR();
 
     if(state->lineno != lineno) {
         state->lineno = lineno;
         state->fill_idx = 0;
     }
 
-    state->body.raw[state->fill_idx]=current_byte;
+    ((uint8_t *)&state->body)[state->fill_idx]=current_byte; // Through the whole union, not just raw[0]
     state->fill_idx++;
 
     return state->fill_idx < sizeof_type; // Return true if we need more bytes.
 }
 
 // do _NOT_ keep pointers to this data around.
-#define NEXT_TYPE(type) ({CALL_SUBPARSER(parse_next_type, byte, &(state->subparser_state.nexttype), sizeof(type)); (const type *) &(state->subparser_state.nexttype.body);})
+// While the value is incomplete, next_type_size lets the packet loop copy its bytes without going through parse_byte.
+#define NEXT_TYPE(type) ({ \
+    state->next_type_size = sizeof(type); \
+    CALL_SUBPARSER(parse_next_type, byte, &(state->subparser_state.nexttype), sizeof(type)); \
+    state->next_type_size = 0; \
+    (const type *) &(state->subparser_state.nexttype.body);})
+
+// Copies bytes of the value NEXT_TYPE is reading straight into it, all but its last byte, which parse_byte has to
+// see to finish the value. Fixed-size values are most of an operation, and none of their bytes needs checking
+// before the value is complete. Returns the number of bytes copied.
+static inline size_t copy_next_type_bytes(struct parse_state *const state, uint8_t const *const data, size_t const length) {
+    if (state->next_type_size == 0) return 0;
+
+    struct nexttype_subparser_state *const nexttype = &state->subparser_state.nexttype;
+    size_t const count = MIN((size_t)(state->next_type_size - nexttype->fill_idx - 1), length - 1);
+    memcpy((uint8_t *)&nexttype->body + nexttype->fill_idx, data, count);
+    nexttype->fill_idx += count;
+    state->offset += count;
+    return count;
+}
 
 
 static inline bool michelson_read_length(uint8_t current_byte, struct nexttype_subparser_state *state, uint32_t lineno) {
@@ -172,7 +224,6 @@ static inline bool michelson_read_short(uint8_t current_byte, struct nexttype_su
 static inline bool michelson_read_address(
     uint8_t byte,
     parsed_contract_t *const out,
-    char* base58_address_buffer,
     struct michelson_address_subparser_state *state,
     uint32_t lineno) {
 
@@ -196,50 +247,251 @@ static inline bool michelson_read_address(
         default: {
             switch (state->micheline_type) {
                 case MICHELSON_TYPE_BYTE_SEQUENCE: {
-                    switch (state->address_step) {
-                        case 2:
-
-                            // Need 1 byte for signature, plus the rest of the hash.
-                            if (state->addr_length != HASH_SIZE + 1) {
-                                PARSE_ERROR();
-                            }
-
-                            CALL_SUBPARSER(parse_next_type, byte, &(state->subsub_state), sizeof(state->signature_type));
-                            memcpy(&(state->signature_type), &(state->subsub_state.body), sizeof(state->signature_type));
-
-                        case 3:
-
-                            CALL_SUBPARSER(parse_next_type, byte, &(state->subsub_state), sizeof(state->key_hash));
-                            memcpy(&(state->key_hash), &(state->subsub_state.body), sizeof(state->key_hash));
+                    // A key hash is an implicit contract; an address may also be originated.
+                    if (state->addr_length != sizeof(struct implicit_contract) &&
+                        state->addr_length != sizeof(struct contract)) {
+                        PARSE_ERROR();
+                    }
 
-                            parse_implicit(out, &state->signature_type, (const uint8_t *)&state->key_hash);
+                    CALL_SUBPARSER(parse_next_type, byte, &(state->subsub_state), state->addr_length);
 
-                            return false;
+                    if (state->addr_length == sizeof(struct implicit_contract)) {
+                        struct implicit_contract const *const implicit = (struct implicit_contract const *)&state->subsub_state.body;
+                        parse_implicit(out, &implicit->signature_type, implicit->pkh);
+                    } else {
+                        parse_contract(out, (struct contract const *)&state->subsub_state.body);
+                    }
+                    return false;
+                }
+                case MICHELSON_TYPE_STRING: {
+                    if (state->addr_length != HASH_SIZE_B58) {
+                        PARSE_ERROR();
                     }
-                    case MICHELSON_TYPE_STRING: {
-                        if (state->addr_length != HASH_SIZE_B58) {
-                            PARSE_ERROR();
-                        }
 
-			CALL_SUBPARSER(parse_next_type, byte, &(state->subsub_state), sizeof(state->subsub_state.body.text_pkh));
+                    // No prefix starts with a zero byte, so a leading '1' could only be another encoding.
+                    if (state->base58_chars == 0 && byte == '1') PARSE_ERROR();
+                    if (!b58dec_char(state->base58_data, sizeof(state->base58_data), byte)) PARSE_ERROR();
+                    if (++state->base58_chars < HASH_SIZE_B58) return true;
 
-                        memcpy(base58_address_buffer, state->subsub_state.body.text_pkh, sizeof(state->subsub_state.body.text_pkh));
-			out->hash_ptr = base58_address_buffer;
-			out->originated = false;
-			out->signature_type = SIGNATURE_TYPE_UNSET;
-			return false;
-                    }
-                    default: PARSE_ERROR();
+                    signature_type_t signature_type;
+                    if (!pkh_from_base58_data(&signature_type, out->hash, state->base58_data)) PARSE_ERROR();
+                    out->originated = signature_type == SIGNATURE_TYPE_UNSET;
+                    out->signature_type = signature_type;
+                    return false;
                 }
+                default: PARSE_ERROR();
             }
         }
     }
 }
 
-#define MICHELSON_READ_ADDRESS(out, buffer) CALL_SUBPARSER(michelson_read_address, byte, (out), buffer, &state->subparser_state.michelson_address)
+#define MICHELSON_READ_ADDRESS(out) CALL_SUBPARSER(michelson_read_address, byte, (out), &state->subparser_state.michelson_address)
 
 // End of subparsers.
 
+// Operation schemas
+
+#define FIELD(type_, target_, flags_, screen_) { \
+    .type = OPERATION_FIELD_##type_, \
+    .flags = (flags_), \
+    .screen = (screen_), \
+    .target = (target_), \
+}
+#define TARGET(member) offsetof(struct parsed_operation_group, member)
+#define NO_TARGET OPERATION_FIELD_NO_TARGET
+
+// Fields shared by all manager operations; they follow the source.
+#define MANAGER_FIELDS(fee_screen, storage_screen) \
+    FIELD(ZARITH, TARGET(total_fee), OPERATION_FIELD_FLAG_ACCUMULATE | OPERATION_FIELD_FLAG_TEZ, fee_screen), \
+    FIELD(ZARITH, NO_TARGET, 0, 0), /* counter */ \
+    FIELD(ZARITH, NO_TARGET, 0, 0), /* gas limit */ \
+    FIELD(ZARITH, TARGET(total_storage_limit), OPERATION_FIELD_FLAG_ACCUMULATE, storage_screen)
+
+// Athens sources are contracts, Babylon only allows implicit accounts.
+#define SOURCE(type, screen) FIELD(type, TARGET(operation.source), OPERATION_FIELD_FLAG_SIGNER, screen)
+
+// Reveals may come before or after the operation that is displayed, so their source is only checked, never stored.
+#define REVEAL_SOURCE(type) FIELD(type, NO_TARGET, OPERATION_FIELD_FLAG_SIGNER, 0)
+
+static const char *const proposal_prompts[] = {
+    CONST_PROMPT("Confirm"),
+    CONST_PROMPT("Source"),
+    CONST_PROMPT("Period"),
+    CONST_PROMPT("Protocol"),
+    NULL,
+};
+
+static const char *const transaction_prompts[] = {
+    CONST_PROMPT("Confirm"),
+    CONST_PROMPT("Amount"),
+    CONST_PROMPT("Fee"),
+    CONST_PROMPT("Source"),
+    CONST_PROMPT("Destination"),
+    CONST_PROMPT("Storage Limit"),
+    NULL,
+};
+
+static const char *const origination_prompts[] = {
+    CONST_PROMPT("Confirm"),
+    CONST_PROMPT("Amount"),
+    CONST_PROMPT("Fee"),
+    CONST_PROMPT("Source"),
+    CONST_PROMPT("Delegate"),
+    CONST_PROMPT("Storage Limit"),
+    CONST_PROMPT("Script"),
+    NULL,
+};
+
+static const char *const set_deposits_limit_prompts[] = {
+    CONST_PROMPT("Confirm"),
+    CONST_PROMPT("Deposits Limit"),
+    CONST_PROMPT("Fee"),
+    CONST_PROMPT("Source"),
+    CONST_PROMPT("Storage Limit"),
+    NULL,
+};
+
+#define REVEAL_FIELDS(source_type) { \
+    REVEAL_SOURCE(source_type), \
+    MANAGER_FIELDS(0, 0), \
+    FIELD(SIGNER_PUBLIC_KEY, NO_TARGET, 0, 0), \
+}
+
+#define TRANSACTION_FIELDS(source_type) { \
+    SOURCE(source_type, 3), \
+    MANAGER_FIELDS(2, 5), \
+    FIELD(ZARITH, TARGET(operation.amount), OPERATION_FIELD_FLAG_TEZ, 1), \
+    FIELD(CONTRACT, TARGET(operation.destination), 0, 4), \
+    FIELD(PARAMETERS, NO_TARGET, OPERATION_FIELD_FLAG_OPTIONAL, 0), \
+}
+
+#define DELEGATION_FIELDS(source_type) { \
+    SOURCE(source_type, 0), \
+    MANAGER_FIELDS(0, 0), \
+    FIELD(IMPLICIT, TARGET(operation.destination), OPERATION_FIELD_FLAG_OPTIONAL, 0), \
+}
+
+static const struct operation_schema operation_schemas[] = {
+    {
+        .kind = OPERATION_KIND_PROPOSAL,
+        .ends_group = true,
+        .type_label = "Proposal",
+        .prompts = proposal_prompts,
+        .fields = {
+            SOURCE(IMPLICIT, 1),
+            FIELD(INT32, TARGET(operation.proposal.voting_period), 0, 2),
+            FIELD(PROTOCOL_HASHES, TARGET(operation.proposal.protocol_hash), 0, 3),
+        },
+    },
+    {
+        .kind = OPERATION_KIND_BALLOT,
+        .ends_group = true,
+        .fields = {
+            SOURCE(IMPLICIT, 0),
+            FIELD(INT32, TARGET(operation.ballot.voting_period), 0, 0),
+            FIELD(PROTOCOL_HASH, TARGET(operation.ballot.protocol_hash), 0, 0),
+            FIELD(BALLOT, TARGET(operation.ballot.vote), 0, 0),
+        },
+    },
+    {
+        .kind = OPERATION_KIND_REVEAL,
+        .fields = REVEAL_FIELDS(CONTRACT),
+    },
+    {
+        .kind = OPERATION_KIND_TRANSACTION,
+        .type_label = "Transaction",
+        .prompts = transaction_prompts,
+        .fields = TRANSACTION_FIELDS(CONTRACT),
+    },
+    {
+        .kind = OPERATION_KIND_DELEGATION,
+        .fields = DELEGATION_FIELDS(CONTRACT),
+    },
+    {
+        .kind = OPERATION_KIND_REVEAL,
+        .fields = REVEAL_FIELDS(IMPLICIT),
+    },
+    {
+        .kind = OPERATION_KIND_TRANSACTION,
+        .type_label = "Transaction",
+        .prompts = transaction_prompts,
+        .fields = TRANSACTION_FIELDS(IMPLICIT),
+    },
+    {
+        .kind = OPERATION_KIND_ORIGINATION,
+        .type_label = "Origination",
+        .prompts = origination_prompts,
+        .fields = {
+            SOURCE(IMPLICIT, 3),
+            MANAGER_FIELDS(2, 5),
+            FIELD(ZARITH, TARGET(operation.amount), OPERATION_FIELD_FLAG_TEZ, 1), // balance
+            FIELD(IMPLICIT, TARGET(operation.delegate), OPERATION_FIELD_FLAG_OPTIONAL, 4),
+            FIELD(SCRIPT, TARGET(operation.script_hash), 0, 6),
+        },
+    },
+    {
+        .kind = OPERATION_KIND_DELEGATION,
+        .fields = DELEGATION_FIELDS(IMPLICIT),
+    },
+    {
+        .kind = OPERATION_KIND_SET_DEPOSITS_LIMIT,
+        .type_label = "Set Limit",
+        .prompts = set_deposits_limit_prompts,
+        .fields = {
+            SOURCE(IMPLICIT, 3),
+            MANAGER_FIELDS(2, 4),
+            FIELD(ZARITH, TARGET(operation.amount), OPERATION_FIELD_FLAG_OPTIONAL | OPERATION_FIELD_FLAG_TEZ, 1),
+        },
+    },
+};
+
+// Index into `operation_schemas`, plus one, by tag; 0 for unsupported tags.
+static const uint8_t operation_schema_index[256] = {
+    [OPERATION_TAG_PROPOSAL] = 1,
+    [OPERATION_TAG_BALLOT] = 2,
+    [OPERATION_TAG_ATHENS_REVEAL] = 3,
+    [OPERATION_TAG_ATHENS_TRANSACTION] = 4,
+    [OPERATION_TAG_ATHENS_DELEGATION] = 5,
+    [OPERATION_TAG_BABYLON_REVEAL] = 6,
+    [OPERATION_TAG_BABYLON_TRANSACTION] = 7,
+    [OPERATION_TAG_BABYLON_ORIGINATION] = 8,
+    [OPERATION_TAG_BABYLON_DELEGATION] = 9,
+    [OPERATION_TAG_ITHACA_SET_DEPOSITS_LIMIT] = 10,
+};
+
+_Static_assert(NUM_ELEMENTS(operation_schemas) < 0xFF, "Too many operation schemas for the index table");
+_Static_assert(MAX_OPERATION_FIELDS <= sizeof(((struct parsed_operation *)0)->absent_fields) * 8,
+               "absent_fields can't track every schema field");
+_Static_assert(MAX_OPERATION_FIELDS <= sizeof(((struct parsed_operation *)0)->ready_fields) * 8,
+               "ready_fields can't track every schema field");
+
+struct operation_schema const *find_operation_schema(enum operation_tag tag) {
+    if (tag < 0 || (size_t)tag >= NUM_ELEMENTS(operation_schema_index)) return NULL;
+    uint8_t const index = operation_schema_index[tag];
+    if (index == 0 || index > NUM_ELEMENTS(operation_schemas)) return NULL;
+    return &operation_schemas[index - 1];
+}
+
+static void reset_parse_state(struct parsed_operation_group *const out, struct parse_state *const state) {
+    check_null(out);
+    check_null(state);
+    memset(out, 0, sizeof(*out));
+
+    out->operation.tag = OPERATION_TAG_NONE;
+    out->operation.kind = OPERATION_KIND_NONE;
+
+    state->op_step=0;
+    state->failed_step=0;
+    state->offset=0;
+    state->subparser_state.integer.lineno=-1;
+    state->tag=OPERATION_TAG_NONE; // This and the rest shouldn't be required.
+    state->schema=NULL;
+    state->field_index=0;
+    state->next_type_size=0;
+    state->argument_length=0;
+    state->michelson_op=-1;
+}
+
 void parse_operations_init(
     struct parsed_operation_group *const out,
     derivation_type_t derivation_type,
@@ -247,30 +499,37 @@ void parse_operations_init(
     struct parse_state *const state
     ) {
 
-    check_null(out);
     check_null(bip32_path);
-    memset(out, 0, sizeof(*out));
+    reset_parse_state(out, state);
 
-    out->operation.tag = OPERATION_TAG_NONE;
+    // Deriving the key is expensive, and many payloads (unparseable ones, packed Michelson)
+    // never get far enough to compare against it. `out->signing` stays unset until then.
+    state->derivation_type = derivation_type;
+    state->bip32_path = bip32_path;
+}
 
-    compute_pkh(&out->public_key, &out->signing, derivation_type, bip32_path);
+void parse_operations_init_with_public_key(
+    struct parsed_operation_group *const out,
+    derivation_type_t derivation_type,
+    cx_ecfp_public_key_t const *const public_key,
+    struct parse_state *const state
+    ) {
 
-    // Start out with source = signing, for reveals
-    // TODO: This is slightly hackish
-    memcpy(&out->operation.source, &out->signing, sizeof(out->signing));
+    check_null(public_key);
+    reset_parse_state(out, state);
 
-    state->op_step=0;
-    state->subparser_state.integer.lineno=-1;
-    state->tag=OPERATION_TAG_NONE; // This and the rest shouldn't be required.
-    state->argument_length=0;
-    state->michelson_op=-1;
+    state->derivation_type = derivation_type;
+    state->bip32_path = NULL; // Never needed, the signer is already known.
+    set_signer(&out->public_key, &out->signing, derivation_type, public_key);
 }
 
 // Named steps in the top-level state machine
 #define STEP_END_OF_MESSAGE -1
-#define STEP_OP_TYPE_DISPATCH 10001
-#define STEP_AFTER_MANAGER_FIELDS 10002
-#define STEP_HAS_DELEGATE 10003
+#define STEP_OPERATION_TAG 1
+#define STEP_FIELD 10001
+#define STEP_OPTIONAL_FIELD 10002
+#define STEP_SCRIPT_PART 10003
+#define STEP_SCRIPT_PART_BYTES 10004
 #define STEP_MICHELSON_FIRST_IS_PUSH 10010
 #define STEP_MICHELSON_FIRST_IS_NONE 10011
 #define STEP_MICHELSON_SECOND_IS_KEY_HASH 10012
@@ -280,12 +539,104 @@ void parse_operations_init(
 #define STEP_MICHELSON_CONTRACT_END 10016
 #define STEP_MICHELSON_CHECKING_CONTRACT_ENTRYPOINT 10017
 #define STEP_MICHELSON_CONTRACT_TO_CONTRACT_CHAIN_2 10018
+#define STEP_MICHELSON_CONTRACT_ENTRYPOINT_NAME 10019
+#define STEP_ENTRYPOINT_NAME_LENGTH 10020
+#define STEP_ENTRYPOINT_NAME 10021
+#define STEP_CALL_PARAMETERS_LENGTH 10022
+#define STEP_CALL_PARAMETERS 10023
 
 bool parse_operations_final(struct parse_state *const state, struct parsed_operation_group *const out) {
-    if (out->operation.tag == OPERATION_TAG_NONE && !out->has_reveal) {
+    if (out->operation.kind == OPERATION_KIND_NONE && !out->has_reveal) {
         return false;
     }
-    return state->op_step == STEP_END_OF_MESSAGE || state->op_step == 1;
+    return state->op_step == STEP_END_OF_MESSAGE || state->op_step == STEP_OPERATION_TAG;
+}
+
+parsed_contract_t const *parsed_operations_signer(struct parse_state *const state, struct parsed_operation_group *const out) {
+    check_null(state);
+    check_null(out);
+    if (out->signing.signature_type == SIGNATURE_TYPE_UNSET) {
+        compute_pkh(&out->public_key, &out->signing, state->derivation_type, state->bip32_path);
+    }
+    return &out->signing;
+}
+
+// Returns the step that starts parsing the current field.
+static inline int16_t enter_field(struct parse_state *const state) {
+    struct operation_field const *const field = &state->schema->fields[state->field_index];
+
+    // Consecutive fields of the same type share a subparser call site; make sure it starts over.
+    state->subparser_state.integer.lineno = -1;
+
+    if (field->type == OPERATION_FIELD_END) {
+        return state->schema->ends_group ? STEP_END_OF_MESSAGE : STEP_OPERATION_TAG;
+    }
+    return (field->flags & OPERATION_FIELD_FLAG_OPTIONAL) ? STEP_OPTIONAL_FIELD : STEP_FIELD;
+}
+
+static inline void script_hash_byte(struct script_hash_state *const state, uint8_t const byte) {
+    state->staged[state->staged_length++] = byte;
+    if (state->staged_length == sizeof(state->staged)) {
+        cx_hash((cx_hash_t *)&state->state, 0, state->staged, sizeof(state->staged), NULL, 0);
+        state->staged_length = 0;
+    }
+}
+
+// Names of the entrypoints that have a dedicated tag, indexed by tag.
+static const char *const standard_entrypoints[] = {
+    [ENTRYPOINT_DEFAULT] = "default",
+    [ENTRYPOINT_ROOT] = "root",
+    [ENTRYPOINT_DO] = "do",
+    [ENTRYPOINT_SET_DELEGATE] = "set_delegate",
+    [ENTRYPOINT_REMOVE_DELEGATE] = "remove_delegate",
+};
+
+// Entrypoints are named with the characters of Michelson annotations.
+static inline bool is_entrypoint_char(uint8_t const c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+        c == '_' || c == '.' || c == '%' || c == '@';
+}
+
+// Writes the next character of the entrypoint name, whose position follows from the bytes of it left to read.
+// Callers terminate the name once it is complete.
+static inline void append_entrypoint_char(
+    struct parse_state const *const state, struct parsed_operation *const operation, uint8_t const c
+) {
+    size_t const index = state->entrypoint_length - state->argument_length;
+    if (!is_entrypoint_char(c) || index >= MAX_ENTRYPOINT_LENGTH) PARSE_ERROR();
+    operation->entrypoint[index] = c;
+}
+
+// Marks the fields of the displayed operation before `end` as final, so they can be shown while the rest
+// arrives. Totals never are: they may still grow with later operations of the group. Fields that are already
+// final are left alone.
+static inline void mark_fields_ready(
+    struct parse_state const *const state,
+    struct parsed_operation_group *const out,
+    size_t const end
+) {
+    if (state->schema->kind == OPERATION_KIND_REVEAL) return;
+
+    uint16_t const pending = (uint16_t)((1u << end) - 1) & ~out->operation.ready_fields;
+    for (size_t i = 0; i < end; i++) {
+        if ((pending & (1 << i)) && !(state->schema->fields[i].flags & OPERATION_FIELD_FLAG_ACCUMULATE)) {
+            out->operation.ready_fields |= 1 << i;
+        }
+    }
+}
+
+// Parameters may turn a transaction into a manager.tz call, which rewrites the fields before them.
+static inline bool parameters_follow(struct parse_state const *const state) {
+    for (size_t i = state->field_index + 1; state->schema->fields[i].type != OPERATION_FIELD_END; i++) {
+        if (state->schema->fields[i].type == OPERATION_FIELD_PARAMETERS) return true;
+    }
+    return false;
+}
+
+static inline int16_t next_field(struct parse_state *const state, struct parsed_operation_group *const out) {
+    if (!parameters_follow(state)) mark_fields_ready(state, out, state->field_index + 1);
+    state->field_index++;
+    return enter_field(state);
 }
 
 static inline bool parse_byte(
@@ -305,10 +656,10 @@ static inline bool parse_byte(
 #define JMP(step) state->op_step=step; return true
 
 // Set the next state to end-of-message
-#define JMP_EOM JMP(-1)
+#define JMP_EOM JMP(STEP_END_OF_MESSAGE)
 
-// Set the next state to start-of-payload; used after reveal.
-#define JMP_TO_TOP JMP(1)
+// Set the next state to the next field of the current operation.
+#define JMP_NEXT_FIELD JMP(next_field(state, out))
 
 // Conditionally set the next state.
 #define OP_JMPIF(step, cond) if(cond) { state->op_step=step; return true; }
@@ -318,6 +669,9 @@ static inline bool parse_byte(
 #define OP_STEP_REQUIRE_BYTE(constant) { if(byte != constant) { PRINTF("Expected: %d, got: %d\n", constant, byte); PARSE_ERROR(); } } OP_STEP
 #define OP_STEP_REQUIRE_LENGTH(constant) { uint32_t val = MICHELSON_READ_LENGTH; if(val != constant) { PARSE_ERROR(); } } OP_STEP
 
+// Where the current field is stored. Only valid for fields with a target.
+#define FIELD_TARGET(type) ((type *)((uint8_t *)out + field->target))
+
     switch(state->op_step) {
 
         case STEP_HARD_FAIL:
@@ -334,202 +688,204 @@ static inline bool parse_byte(
                 if (ogh->magic_byte != MAGIC_BYTE_UNSAFE_OP) PARSE_ERROR();
             }
 
-        OP_NAMED_STEP(1)
+        OP_NAMED_STEP(STEP_OPERATION_TAG)
 
+        {
             state->tag = NEXT_BYTE;
 
-            if (!is_operation_allowed(state->tag)) PARSE_ERROR();
-
-        OP_STEP
-
-            // Parse 'source'
-            switch (state->tag) {
-                // Tags that don't have "originated" byte only support tz accounts, not KT or tz.
-                case OPERATION_TAG_PROPOSAL:
-                case OPERATION_TAG_BALLOT:
-                case OPERATION_TAG_BABYLON_DELEGATION:
-                case OPERATION_TAG_BABYLON_ORIGINATION:
-                case OPERATION_TAG_BABYLON_REVEAL:
-                case OPERATION_TAG_BABYLON_TRANSACTION: {
-                    struct implicit_contract const *const implicit_source = NEXT_TYPE(struct implicit_contract);
-                    out->operation.source.originated = 0;
-                    out->operation.source.signature_type = parse_raw_tezos_header_signature_type(&implicit_source->signature_type);
-                    memcpy(out->operation.source.hash, implicit_source->pkh, sizeof(out->operation.source.hash));
-                    break;
-                }
+            struct operation_schema const *const schema = find_operation_schema(state->tag);
+            if (schema == NULL || !is_operation_allowed(schema->kind)) PARSE_ERROR();
 
-                case OPERATION_TAG_ATHENS_DELEGATION:
-                case OPERATION_TAG_ATHENS_ORIGINATION:
-                case OPERATION_TAG_ATHENS_REVEAL:
-                case OPERATION_TAG_ATHENS_TRANSACTION: {
-                    struct contract const *const source = NEXT_TYPE(struct contract);
-                    parse_contract(&out->operation.source, source);
-                    break;
-                }
+            if (schema->kind != OPERATION_KIND_REVEAL) {
+                // We are only currently allowing one non-reveal operation
+                if (out->operation.kind != OPERATION_KIND_NONE) PARSE_ERROR();
 
-                default: PARSE_ERROR();
+                // This is the one allowable non-reveal operation per set
+                out->operation.tag = state->tag;
+                out->operation.kind = schema->kind;
             }
 
-
-        OP_JMPIF(STEP_AFTER_MANAGER_FIELDS, (state->tag == OPERATION_TAG_PROPOSAL || state->tag == OPERATION_TAG_BALLOT));
-
-        OP_STEP
-
-        // out->operation.source IS NORMALIZED AT THIS POINT
-
-        // Parse common fields for non-governance related operations.
-
-            out->total_fee += PARSE_Z; // fee
-        OP_STEP
-            PARSE_Z; // counter
-        OP_STEP
-            PARSE_Z; // gas limit
-        OP_STEP
-            out->total_storage_limit += PARSE_Z; // storage limit
-
-        OP_JMPIF(STEP_AFTER_MANAGER_FIELDS, (state->tag != OPERATION_TAG_ATHENS_REVEAL && state->tag != OPERATION_TAG_BABYLON_REVEAL))
-        OP_STEP
-
-            // We know this is a reveal
-
-            // Public key up next! Ensure it matches signing key.
-            // Ignore source :-) and do not parse it from hdr.
-            // We don't much care about reveals, they have very little in the way of bad security
-            // implications and any fees have already been accounted for
-        {
-            raw_tezos_header_signature_type_t const *const sig_type = NEXT_TYPE(raw_tezos_header_signature_type_t);
-            if (parse_raw_tezos_header_signature_type(sig_type) != out->signing.signature_type) PARSE_ERROR();
+            state->schema = schema;
+            state->field_index = 0;
+            JMP(enter_field(state));
         }
 
-        OP_STEP
+        case STEP_OPTIONAL_FIELD:
 
-        {
-            size_t klen = out->public_key.W_len;
-
-            CALL_SUBPARSER(parse_next_type, byte, &(state->subparser_state.nexttype), klen);
-
-            if(memcmp(out->public_key.W, &(state->subparser_state.nexttype.body.raw), klen) != 0) PARSE_ERROR();
-
-            out->has_reveal = true;
-
-            JMP_TO_TOP;
-        }
+            switch (NEXT_BYTE) {
+                case 0x00:
+                    out->operation.absent_fields |= 1 << state->field_index;
+                    JMP_NEXT_FIELD;
+                case 0xFF:
+                    JMP(STEP_FIELD);
+                default:
+                    PARSE_ERROR();
+            }
 
-        case STEP_AFTER_MANAGER_FIELDS: // Anything but a reveal
+        default:
+        {
+        struct operation_field const *const field = &state->schema->fields[state->field_index];
+
+        switch (field->type) {
+            case OPERATION_FIELD_IMPLICIT:
+            case OPERATION_FIELD_CONTRACT:
+                {
+                    // Nothing past NEXT_TYPE runs before the last byte of the address, which keeps the other
+                    // bytes of this, the most common field, as cheap as the ones of a fixed field used to be.
+                    parsed_contract_t contract;
+                    if (field->type == OPERATION_FIELD_IMPLICIT) {
+                        struct implicit_contract const *const implicit = NEXT_TYPE(struct implicit_contract);
+                        memset(&contract, 0, sizeof(contract)); // COMPARE includes the padding
+                        parse_implicit(&contract, &implicit->signature_type, implicit->pkh);
+                    } else {
+                        struct contract const *const parsed = NEXT_TYPE(struct contract);
+                        memset(&contract, 0, sizeof(contract));
+                        parse_contract(&contract, parsed);
+                    }
 
-        if (out->operation.tag != OPERATION_TAG_NONE) {
-            // We are only currently allowing one non-reveal operation
-            PARSE_ERROR();
-        }
+                    // If the source is an implicit contract, it had better match our key, otherwise why are we signing it?
+                    if ((field->flags & OPERATION_FIELD_FLAG_SIGNER) && contract.originated == 0) {
+                        if (COMPARE(&contract, parsed_operations_signer(state, out)) != 0) PARSE_ERROR();
+                    }
+                    if (field->target != OPERATION_FIELD_NO_TARGET) {
+                        memcpy(FIELD_TARGET(parsed_contract_t), &contract, sizeof(contract));
+                    }
+                }
+                JMP_NEXT_FIELD;
+
+            case OPERATION_FIELD_ZARITH:
+                {
+                    uint64_t const value = PARSE_Z;
+                    if (field->target != OPERATION_FIELD_NO_TARGET) {
+                        uint64_t *const target = FIELD_TARGET(uint64_t);
+                        if (field->flags & OPERATION_FIELD_FLAG_ACCUMULATE) {
+                            *target += value;
+                        } else {
+                            *target = value;
+                        }
+                    }
+                }
+                JMP_NEXT_FIELD;
 
-        // This is the one allowable non-reveal operation per set
+            case OPERATION_FIELD_INT32:
+                {
+                    int32_t const *const value = NEXT_TYPE(int32_t);
+                    *FIELD_TARGET(uint32_t) = READ_UNALIGNED_BIG_ENDIAN(int32_t, value);
+                }
+                JMP_NEXT_FIELD;
 
-        out->operation.tag = (uint8_t)state->tag;
+            case OPERATION_FIELD_PROTOCOL_HASH:
+                {
+                    protocol_hash_t const *const hash = NEXT_TYPE(protocol_hash_t);
+                    memcpy(FIELD_TARGET(uint8_t), hash->v, sizeof(hash->v));
+                }
+                JMP_NEXT_FIELD;
 
-        // If the source is an implicit contract,...
-        if (out->operation.source.originated == 0) {
-            // ... it had better match our key, otherwise why are we signing it?
-            if (COMPARE(&out->operation.source, &out->signing) != 0) PARSE_ERROR();
-        }
-        // OK, it passes muster.
+            case OPERATION_FIELD_PROTOCOL_HASHES:
+                {
+                    const struct proposal_contents *proposal_data = NEXT_TYPE(struct proposal_contents);
 
-        // This should by default be blanked out
-        out->operation.delegate.signature_type = SIGNATURE_TYPE_UNSET;
-        out->operation.delegate.originated = 0;
+                    const uint32_t payload_size = READ_UNALIGNED_BIG_ENDIAN(uint32_t, &proposal_data->num_bytes);
+                    if (payload_size != PROTOCOL_HASH_SIZE) PARSE_ERROR(); // We only accept exactly 1 proposal hash.
 
+                    memcpy(FIELD_TARGET(uint8_t), proposal_data->hash, sizeof(proposal_data->hash));
+                }
+                JMP_NEXT_FIELD;
+
+            case OPERATION_FIELD_BALLOT:
+                switch (NEXT_BYTE) {
+                    case 0:
+                        *FIELD_TARGET(enum ballot_vote) = BALLOT_VOTE_YEA;
+                        break;
+                    case 1:
+                        *FIELD_TARGET(enum ballot_vote) = BALLOT_VOTE_NAY;
+                        break;
+                    case 2:
+                        *FIELD_TARGET(enum ballot_vote) = BALLOT_VOTE_PASS;
+                        break;
+                    default:
+                        PARSE_ERROR();
+                }
+                JMP_NEXT_FIELD;
+
+            case OPERATION_FIELD_SIGNER_PUBLIC_KEY:
+                // Ensure the revealed key matches the signing key.
+                // We don't much care about reveals, they have very little in the way of bad security
+                // implications and any fees have already been accounted for
+                switch (state->op_step) {
+                    case STEP_FIELD: {
+                        raw_tezos_header_signature_type_t const *const sig_type = NEXT_TYPE(raw_tezos_header_signature_type_t);
+                        if (parse_raw_tezos_header_signature_type(sig_type) != parsed_operations_signer(state, out)->signature_type) PARSE_ERROR();
+                    }
 
-        // Deliberate epsilon-transition.
-        state->op_step=STEP_OP_TYPE_DISPATCH;
-        default:
+                    OP_STEP
 
-        switch (state->tag) {
-            case OPERATION_TAG_PROPOSAL:
-                switch(state->op_step) {
-                  case STEP_OP_TYPE_DISPATCH: {
-                      const struct proposal_contents *proposal_data = NEXT_TYPE(struct proposal_contents);
+                    {
+                        size_t klen = out->public_key.length;
 
-                      const size_t payload_size = READ_UNALIGNED_BIG_ENDIAN(int32_t, &proposal_data->num_bytes);
-                      if (payload_size != PROTOCOL_HASH_SIZE) PARSE_ERROR(); // We only accept exactly 1 proposal hash.
+                        CALL_SUBPARSER(parse_next_type, byte, &(state->subparser_state.nexttype), klen);
 
-                      out->operation.proposal.voting_period = READ_UNALIGNED_BIG_ENDIAN(int32_t, &proposal_data->period);
+                        if(memcmp(out->public_key.bytes, &(state->subparser_state.nexttype.body.raw), klen) != 0) PARSE_ERROR();
 
-                      memcpy(out->operation.proposal.protocol_hash, proposal_data->hash, sizeof(out->operation.proposal.protocol_hash));
-                  }
+                        out->has_reveal = true;
+                    }
 
-                  JMP_EOM;
+                    JMP_NEXT_FIELD;
                 }
                 break;
-            case OPERATION_TAG_BALLOT:
-                switch(state->op_step) {
-                    case STEP_OP_TYPE_DISPATCH: {
-                        const struct ballot_contents *ballot_data = NEXT_TYPE(struct ballot_contents);
-
-                        out->operation.ballot.voting_period = READ_UNALIGNED_BIG_ENDIAN(int32_t, &ballot_data->period);
-                        memcpy(out->operation.ballot.protocol_hash, ballot_data->proposal, sizeof(out->operation.ballot.protocol_hash));
-
-                        const int8_t ballot_vote = READ_UNALIGNED_BIG_ENDIAN(int8_t, &ballot_data->ballot);
-                        switch (ballot_vote) {
-                            case 0:
-                                out->operation.ballot.vote = BALLOT_VOTE_YEA;
-                                break;
-                            case 1:
-                                out->operation.ballot.vote = BALLOT_VOTE_NAY;
-                                break;
-                            case 2:
-                                out->operation.ballot.vote = BALLOT_VOTE_PASS;
-                                break;
-                            default:
-                                PARSE_ERROR();
-                        }
-                        JMP_EOM;
-                    }
-                }
 
-            case OPERATION_TAG_ATHENS_DELEGATION:
-            case OPERATION_TAG_BABYLON_DELEGATION:
-                switch(state->op_step) {
-                    case STEP_OP_TYPE_DISPATCH: {
-                        uint8_t delegate_present = NEXT_BYTE;
-
-                        OP_JMPIF(STEP_HAS_DELEGATE, delegate_present)
-                    }
-                    // Else branch: Encode "not present"
-                    out->operation.destination.originated = 0;
-                    out->operation.destination.signature_type = SIGNATURE_TYPE_UNSET;
+            case OPERATION_FIELD_SCRIPT:
+                // Code and storage can run to many kilobytes, far more than we could ever display.
+                // Instead they are streamed through their own hash, which is shown so that it can
+                // be checked against the script on the host.
+                if (state->op_step == STEP_FIELD) {
+                    cx_blake2b_init(&state->script.state, SIGN_HASH_SIZE*8); // cx_blake2b_init takes size in bits.
+                    state->script.staged_length = 0;
+                    state->script.parts_left = 2;
+                    state->op_step = STEP_SCRIPT_PART; // Deliberate epsilon-transition.
+                }
 
-                    JMP_TO_TOP; // These go back to the top to catch any reveals.
+                script_hash_byte(&state->script, byte);
 
-                    case STEP_HAS_DELEGATE: {
-                        const struct delegation_contents *dlg = NEXT_TYPE(struct delegation_contents);
-                        parse_implicit(&out->operation.destination, &dlg->signature_type, dlg->hash);
-                    }
-                    JMP_TO_TOP; // These go back to the top to catch any reveals.
+                switch (state->op_step) {
+                    case STEP_SCRIPT_PART:
+                        state->argument_length = MICHELSON_READ_LENGTH;
+                        OP_JMPIF(STEP_SCRIPT_PART_BYTES, state->argument_length > 0);
+                        break;
+                    case STEP_SCRIPT_PART_BYTES:
+                        if (--state->argument_length > 0) return true;
+                        break;
+                    default:
+                        PARSE_ERROR();
                 }
-            case OPERATION_TAG_ATHENS_ORIGINATION:
-            case OPERATION_TAG_BABYLON_ORIGINATION:
-                PARSE_ERROR(); // We can't parse the script yet, and all babylon originations have a script; we have to just reject originations.
-
-            case OPERATION_TAG_ATHENS_TRANSACTION:
-            case OPERATION_TAG_BABYLON_TRANSACTION:
-                switch(state->op_step) {
-                    case STEP_OP_TYPE_DISPATCH:
 
-                        out->operation.amount = PARSE_Z;
+                // Done with either the code or the storage.
+                state->subparser_state.integer.lineno = -1;
+                OP_JMPIF(STEP_SCRIPT_PART, --state->script.parts_left > 0);
 
-                    OP_STEP {
-                        const struct contract *destination = NEXT_TYPE(struct contract);
-                        parse_contract(&out->operation.destination, destination);
-                    }
+                cx_hash((cx_hash_t *)&state->script.state, CX_LAST,
+                        state->script.staged, state->script.staged_length,
+                        FIELD_TARGET(uint8_t), SIGN_HASH_SIZE);
+                JMP_NEXT_FIELD;
 
-                    OP_STEP {
-                        char has_params = NEXT_BYTE;
+            case OPERATION_FIELD_PARAMETERS:
+                switch(state->op_step) {
+                    case STEP_FIELD: {
+                        const enum entrypoint_tag entrypoint = NEXT_BYTE;
 
-                        if(has_params == MICHELSON_PARAMS_NONE) {
-                            JMP_TO_TOP;
-                        }
+                        // Only manager.tz calls rewrite the fields before the parameters.
+                        if (entrypoint != ENTRYPOINT_DO) mark_fields_ready(state, out, state->field_index);
 
-                        if(has_params != MICHELSON_PARAMS_SOME) {
-                            PARSE_ERROR();
+                        switch (entrypoint) {
+                            case ENTRYPOINT_DO:
+                                break; // Only manager.tz calls use "do"; they are matched against its template below.
+                            case ENTRYPOINT_NAMED:
+                                JMP(STEP_ENTRYPOINT_NAME_LENGTH);
+                            default:
+                                if (entrypoint >= NUM_ELEMENTS(standard_entrypoints)) PARSE_ERROR();
+                                copy_string(out->operation.entrypoint, sizeof(out->operation.entrypoint),
+                                            standard_entrypoints[entrypoint]);
+                                JMP(STEP_CALL_PARAMETERS_LENGTH);
                         }
 
                         // From this point on we are _only_ parsing manager.tz operatinos, so we show the outer destination (the KT1) as the source of the transaction.
@@ -543,19 +899,6 @@ static inline bool parse_byte(
                         }
                     }
 
-
-                    OP_STEP {
-                        const enum entrypoint_tag entrypoint = NEXT_BYTE;
-
-                        // Don't bother parsing the name, we'll reject if it's there either way.
-
-                        // Anything that’s not “do” is not a
-                        // manager.tz contract.
-                        if (entrypoint != ENTRYPOINT_DO) {
-                            PARSE_ERROR();
-                        }
-                    }
-
                     OP_STEP {
                         state->argument_length = MICHELSON_READ_LENGTH;
                     }
@@ -576,6 +919,7 @@ static inline bool parse_byte(
                                 || state->argument_length > MAX_MICHELSON_SEQUENCE_LENGTH) {
                             PARSE_ERROR();
                         }
+                        state->michelson_end = state->offset + sequence_length;
                     }
 
                     OP_STEP
@@ -600,6 +944,36 @@ static inline bool parse_byte(
                         }
                     }
 
+                    case STEP_ENTRYPOINT_NAME_LENGTH:
+                        state->argument_length = NEXT_BYTE;
+                        if (state->argument_length == 0 || state->argument_length > MAX_ENTRYPOINT_LENGTH) PARSE_ERROR();
+                        state->entrypoint_length = state->argument_length;
+                        JMP(STEP_ENTRYPOINT_NAME);
+
+                    case STEP_ENTRYPOINT_NAME:
+                        append_entrypoint_char(state, &out->operation, byte);
+                        OP_JMPIF(STEP_ENTRYPOINT_NAME, --state->argument_length > 0);
+                        out->operation.entrypoint[state->entrypoint_length] = '\0';
+                        JMP(STEP_CALL_PARAMETERS_LENGTH);
+
+                    case STEP_CALL_PARAMETERS_LENGTH:
+                        state->argument_length = MICHELSON_READ_LENGTH;
+                        if (state->argument_length == 0) PARSE_ERROR();
+                        micheline_printer_init(&state->parameters, out->operation.parameters,
+                                               sizeof(out->operation.parameters));
+                        JMP(STEP_CALL_PARAMETERS);
+
+                    case STEP_CALL_PARAMETERS:
+                        // Parameters are rendered as they stream past and never stored; if they don't
+                        // fit on screen the operation can still be signed blindly.
+                        micheline_printer_byte(&state->parameters, byte);
+                        if (--state->argument_length > 0) return true;
+
+                        if (!micheline_printer_done(&state->parameters)) {
+                            out->operation.parameters[0] = '\0';
+                        }
+                        JMP_NEXT_FIELD;
+
                     case STEP_MICHELSON_FIRST_IS_PUSH: {
 
                         state->michelson_op = MICHELSON_READ_SHORT;
@@ -617,7 +991,8 @@ static inline bool parse_byte(
 
                     case STEP_MICHELSON_SECOND_IS_KEY_HASH:
 
-                    MICHELSON_READ_ADDRESS(&out->operation.destination, state->base58_pkh1);
+                    MICHELSON_READ_ADDRESS(&out->operation.destination);
+                    if (out->operation.destination.originated) PARSE_ERROR(); // A key hash is never a KT1
 
                     OP_STEP {
 
@@ -639,8 +1014,7 @@ static inline bool parse_byte(
                         uint16_t val = MICHELSON_READ_SHORT;
                         if(val != MICHELSON_SET_DELEGATE) PARSE_ERROR();
 
-                        out->operation.tag = OPERATION_TAG_BABYLON_DELEGATION;
-                        out->operation.destination.originated = true;
+                        out->operation.kind = OPERATION_KIND_DELEGATION;
                         JMP(STEP_MICHELSON_CONTRACT_END);
 
                     }
@@ -670,7 +1044,7 @@ static inline bool parse_byte(
 
                         uint16_t val = MICHELSON_READ_SHORT;
                         if(val != MICHELSON_TRANSFER_TOKENS) PARSE_ERROR();
-                        out->operation.tag = OPERATION_TAG_BABYLON_TRANSACTION;
+                        out->operation.kind = OPERATION_KIND_TRANSACTION;
 
                         JMP(STEP_MICHELSON_CONTRACT_END);
                     }
@@ -679,7 +1053,7 @@ static inline bool parse_byte(
 
                     {
                         // Matching: PUSH address <adr> ; CONTRACT <par> ; ASSERT_SOME ; PUSH mutez <val> ; UNIT ; TRANSFER_TOKENS
-                        MICHELSON_READ_ADDRESS(&out->operation.destination, state->base58_pkh2);
+                        MICHELSON_READ_ADDRESS(&out->operation.destination);
                     }
 
                     OP_STEP
@@ -692,9 +1066,8 @@ static inline bool parse_byte(
 
                         const enum michelson_code type = MICHELSON_READ_SHORT;
 
-                        // Can’t display any parameters, need
-                        // to throw anything but unit out for now.
-                        // TODO: display michelson arguments
+                        // The call below always passes UNIT, so
+                        // only unit contracts are supported.
                         if (type != MICHELSON_CONTRACT_UNIT) {
                             PARSE_ERROR();
                         }
@@ -713,16 +1086,25 @@ static inline bool parse_byte(
 
                     case STEP_MICHELSON_CHECKING_CONTRACT_ENTRYPOINT:
                     {
-                        // No way to display
-                        // entrypoint now, so need to
-                        // bail out on anything but
-                        // default.
-                        // TODO: display entrypoints
-                        uint8_t entrypoint_byte = NEXT_BYTE;
-                        if(entrypoint_byte != ENTRYPOINT_DEFAULT) {
+                        // The entrypoint is given as an annotation, e.g. "%transfer".
+                        state->argument_length = MICHELSON_READ_LENGTH;
+                        if (state->argument_length < 2 || state->argument_length > MAX_ENTRYPOINT_LENGTH + 1) {
                             PARSE_ERROR();
                         }
+                        state->entrypoint_length = state->argument_length;
                     }
+
+                    OP_STEP
+
+                    OP_STEP_REQUIRE_BYTE('%')
+
+                    case STEP_MICHELSON_CONTRACT_ENTRYPOINT_NAME:
+                    append_entrypoint_char(state, &out->operation, byte);
+                    OP_JMPIF(STEP_MICHELSON_CONTRACT_ENTRYPOINT_NAME, --state->argument_length > 1);
+                    out->operation.entrypoint[state->entrypoint_length - 1] = '\0'; // Without the '%'
+
+                    // Only unit contracts are accepted above, and the call below passes UNIT.
+                    STRCPY(out->operation.parameters, "Unit");
                     JMP(STEP_MICHELSON_CONTRACT_TO_CONTRACT_CHAIN_2);
 
                     case STEP_MICHELSON_CONTRACT_TO_CONTRACT_CHAIN_2:
@@ -754,7 +1136,7 @@ static inline bool parse_byte(
                     {
                         uint16_t val = MICHELSON_READ_SHORT;
                         if(val != MICHELSON_TRANSFER_TOKENS) PARSE_ERROR();
-                        out->operation.tag = OPERATION_TAG_BABYLON_TRANSACTION;
+                        out->operation.kind = OPERATION_KIND_TRANSACTION;
                         JMP(STEP_MICHELSON_CONTRACT_END);
                     }
 
@@ -767,9 +1149,9 @@ static inline bool parse_byte(
                         uint16_t val = MICHELSON_READ_SHORT;
                         if(val != MICHELSON_SET_DELEGATE) PARSE_ERROR();
 
-                        out->operation.tag = OPERATION_TAG_BABYLON_DELEGATION;
-                        out->operation.destination.originated = 0;
-                        out->operation.destination.signature_type = SIGNATURE_TYPE_UNSET;
+                        out->operation.kind = OPERATION_KIND_DELEGATION;
+                        // No delegate; the destination still holds the KT1's hash, which is now the source.
+                        memset(&out->operation.destination, 0, sizeof(out->operation.destination));
 
                     }
 
@@ -779,17 +1161,18 @@ static inline bool parse_byte(
 
                     {
                         uint16_t val = MICHELSON_READ_SHORT;
-                        if(val != MICHELSON_CONS) PARSE_ERROR();
+                        // The call has to fill the sequence exactly.
+                        if(val != MICHELSON_CONS || state->offset != state->michelson_end) PARSE_ERROR();
                     }
 
                     JMP_EOM;
-
-                    default:
-                        PARSE_ERROR();
                 }
-            default: // Any other tag; probably not possible here.
+                break;
+
+            default: // OPERATION_FIELD_END is never entered.
                 PARSE_ERROR();
         }
+        }
     }
 
     PARSE_ERROR(); // Probably not reachable, but removes a warning.
@@ -812,9 +1195,11 @@ static void parse_operations_throws_parse_error(
     parse_operations_init(out, derivation_type, bip32_path, &G.parse_state);
 
     while (ix < length) {
+        ix += copy_next_type_bytes(&G.parse_state, (uint8_t const *)data + ix, length - ix);
         uint8_t byte = ((uint8_t*)data)[ix];
         parse_byte(byte, &G.parse_state, out, is_operation_allowed);
         PRINTF("Byte: %x - Next op_step state: %d\n", byte, G.parse_state.op_step);
+        G.parse_state.offset++;
         ix++;
     }
 
@@ -858,9 +1243,11 @@ bool parse_operations_packet(
         TRY {
             size_t ix = 0;
             while (ix < length) {
+                ix += copy_next_type_bytes(&G.parse_state, data + ix, length - ix);
                 uint8_t byte = ((uint8_t*)data)[ix];
                 parse_byte(byte, &G.parse_state, out, is_operation_allowed);
                 PRINTF("Byte: %x - Next op_step state: %d\n", byte, G.parse_state.op_step);
+                G.parse_state.offset++;
                 ix++;
             }
         }
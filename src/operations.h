@@ -8,9 +8,10 @@
 #include "protocol.h"
 
 #include "cx.h"
+#include "micheline.h"
 #include "types.h"
 
-typedef bool (*is_operation_allowed_t)(enum operation_tag);
+typedef bool (*is_operation_allowed_t)(enum operation_kind);
 
 
 // Wire format that gets parsed into `signature_type`.
@@ -39,27 +40,72 @@ struct contract {
     } u;
 } __attribute__((packed));
 
-struct delegation_contents {
-    raw_tezos_header_signature_type_t signature_type;
-    uint8_t hash[HASH_SIZE];
-} __attribute__((packed));
-
 struct proposal_contents {
-    int32_t period;
-    size_t num_bytes;
+    uint32_t num_bytes;
     uint8_t hash[PROTOCOL_HASH_SIZE];
 } __attribute__((packed));
 
-struct ballot_contents {
-    int32_t period;
-    uint8_t proposal[PROTOCOL_HASH_SIZE];
-    int8_t ballot;
-} __attribute__((packed));
-
 typedef struct {
     uint8_t v[HASH_SIZE];
 } __attribute__((packed)) hash_t;
 
+typedef struct {
+    uint8_t v[PROTOCOL_HASH_SIZE];
+} __attribute__((packed)) protocol_hash_t;
+
+// Operation schemas
+//
+// Every supported operation tag is described by a constant schema: the list of
+// fields that follow the tag on the wire, in order. `parse_byte` streams bytes
+// through the fields of the current schema, so supporting a new tag only takes
+// a new table entry.
+
+enum operation_field_type {
+    OPERATION_FIELD_END = 0,
+    OPERATION_FIELD_IMPLICIT, // Signature type and key hash
+    OPERATION_FIELD_CONTRACT, // Implicit or originated contract
+    OPERATION_FIELD_ZARITH, // Unsigned variable-length integer
+    OPERATION_FIELD_INT32, // Big-endian 32-bit integer
+    OPERATION_FIELD_PROTOCOL_HASH,
+    OPERATION_FIELD_PROTOCOL_HASHES, // Length-prefixed list, only a single hash is accepted
+    OPERATION_FIELD_BALLOT, // Yea, nay or pass
+    OPERATION_FIELD_SIGNER_PUBLIC_KEY, // Signature type and public key, must be the signing key
+    OPERATION_FIELD_PARAMETERS, // Entrypoint and Micheline call parameters
+    OPERATION_FIELD_SCRIPT, // Length-prefixed Micheline code and storage, only hashed
+};
+
+#define OPERATION_FIELD_FLAG_OPTIONAL 0x01 // Preceded by a presence byte
+#define OPERATION_FIELD_FLAG_SIGNER 0x02 // Implicit accounts must match the signing key
+#define OPERATION_FIELD_FLAG_ACCUMULATE 0x04 // Added to the target instead of overwriting it
+#define OPERATION_FIELD_FLAG_TEZ 0x08 // Displayed as an amount of tez
+
+#define OPERATION_FIELD_NO_TARGET 0xFFFF
+
+#define MAX_OPERATION_FIELDS 12
+
+struct operation_field {
+    uint8_t type; // enum operation_field_type
+    uint8_t flags;
+    uint8_t screen; // Index into the schema's prompts, 0 if the field isn't displayed
+    uint16_t target; // Offset into `struct parsed_operation_group`
+};
+
+struct operation_schema {
+    uint8_t kind; // enum operation_kind
+    bool ends_group; // No operation may follow this one
+    char const *type_label; // Value of the first screen
+
+    // NULL-terminated labels for schema-driven prompts, NULL if the operation has a dedicated prompt.
+    // May be unrelocated.
+    char const *const *prompts;
+
+    // Terminated by OPERATION_FIELD_END
+    struct operation_field fields[MAX_OPERATION_FIELDS + 1];
+};
+
+// Returns NULL for unsupported tags.
+struct operation_schema const *find_operation_schema(enum operation_tag tag);
+
 struct int_subparser_state {
 	uint32_t lineno; // Has to be in _all_ members of the subparser union.
 	uint64_t value; // Still need to fix this.
@@ -76,19 +122,17 @@ struct nexttype_subparser_state {
     struct implicit_contract ic;
     struct contract c;
 
-    struct delegation_contents dc;
     struct proposal_contents pc;
-    struct ballot_contents bc;
 
     hash_t ht;
+    protocol_hash_t pht;
 
     uint16_t i16;
     uint32_t i32;
     uint64_t i64;
 
     uint8_t raw[1];
-    uint8_t key[64]; // FIXME: check key length for non-tz1.
-    uint8_t text_pkh[HASH_SIZE_B58];
+    uint8_t key[MAX_COMPRESSED_PUBLIC_KEY_SIZE]; // Revealed keys are compared in compressed form
   } body;
   uint32_t fill_idx;
 };
@@ -98,11 +142,21 @@ struct michelson_address_subparser_state {
   uint8_t address_step;
   uint8_t micheline_type;
   uint32_t addr_length;
-  hash_t key_hash;
-  parsed_contract_t result; // Not neccessarily optimal, but easy.
   struct nexttype_subparser_state subsub_state;
-  raw_tezos_header_signature_type_t signature_type;
 
+  // Base58 addresses are decoded as their characters arrive, so the text is never kept.
+  uint8_t base58_data[PKH_BASE58_DATA_SIZE];
+  uint8_t base58_chars;
+};
+
+// Script bytes are staged here so the hash isn't updated one byte at a time.
+#define SCRIPT_HASH_STAGE_SIZE 32
+
+struct script_hash_state {
+    cx_blake2b_t state;
+    uint8_t staged[SCRIPT_HASH_STAGE_SIZE];
+    uint8_t staged_length;
+    uint8_t parts_left; // Code, then storage
 };
 
 union subparser_state {
@@ -113,15 +167,30 @@ union subparser_state {
 
 struct parse_state {
 	int16_t op_step;
+        int16_t failed_step; // Step that hit the first parse error
+        uint32_t offset; // Bytes of the message parsed so far, including the magic byte
+
+        // Key the operations are being signed with; only derived once a check needs it.
+        derivation_type_t derivation_type;
+        bip32_path_t const *bip32_path;
+
 	union subparser_state subparser_state;
-	enum operation_tag tag;
-        uint32_t argument_length;
+        struct operation_schema const *schema;
+        enum operation_tag tag;
+        uint8_t field_index;
+        uint8_t entrypoint_length; // What argument_length started at when the entrypoint name began
+        uint8_t next_type_size; // Of the value NEXT_TYPE is reading into subparser_state.nexttype, 0 if none
         uint16_t michelson_op;
         uint16_t contract_code;
-
-        // Places to stash textual base58-encoded PKHes.
-        char base58_pkh1[HASH_SIZE_B58];
-        char base58_pkh2[HASH_SIZE_B58];
+        uint32_t argument_length;
+        uint32_t michelson_end; // Offset of the last byte of a manager.tz call
+
+        // Only one of these is in use at a time: an operation is either an origination, a contract call,
+        // or a manager.tz call, and nothing else in the group needs them.
+        union {
+            struct script_hash_state script;
+            struct micheline_printer parameters;
+        };
 };
 
 // Allows arbitrarily many "REVEAL" operations but only one operation of any other type,
@@ -142,8 +211,20 @@ void parse_operations_init(
     struct parse_state *const state
     );
 
+// Same as `parse_operations_init`, but the signer is given by its public key, as returned by
+// INS_GET_PUBLIC_KEY, so that parsing never derives a key.
+void parse_operations_init_with_public_key(
+    struct parsed_operation_group *const out,
+    derivation_type_t derivation_type,
+    cx_ecfp_public_key_t const *const public_key,
+    struct parse_state *const state
+    );
+
 bool parse_operations_final(struct parse_state *const state, struct parsed_operation_group *const out);
 
+// Fills in `out->signing` and `out->public_key` if parsing hasn't needed them yet.
+parsed_contract_t const *parsed_operations_signer(struct parse_state *const state, struct parsed_operation_group *const out);
+
 bool parse_operations_packet(
     struct parsed_operation_group *const out,
     uint8_t const *const data,
@@ -2,8 +2,10 @@
 
 #include "apdu.h"
 #include "base58.h"
+#include "decimal.h"
 #include "keys.h"
 #include "delegates.h"
+#include "globals.h"
 
 #include <string.h>
 
@@ -26,12 +28,7 @@ void parsed_contract_to_string(
     size_t const buff_size,
     parsed_contract_t const *const contract
 ) {
-    // If hash_ptr exists, show it to us now. Otherwise, we unpack the
-    // packed hash.
-    if (contract->hash_ptr != NULL) {
-        if (buff_size < HASH_SIZE_B58) THROW(EXC_WRONG_LENGTH);
-        memcpy(buff, contract->hash_ptr, HASH_SIZE_B58);
-    } else if (contract->originated == 0 && contract->signature_type == SIGNATURE_TYPE_UNSET) {
+    if (contract->originated == 0 && contract->signature_type == SIGNATURE_TYPE_UNSET) {
         if (buff_size < sizeof(NO_CONTRACT_STRING)) THROW(EXC_WRONG_LENGTH);
         strcpy(buff, NO_CONTRACT_STRING);
     } else {
@@ -43,25 +40,70 @@ void parsed_contract_to_string(
     }
 }
 
+// Returns the index of the key hash in `named_delegate_keys`, or NAMED_DELEGATE_COUNT if it isn't there.
+static size_t find_named_delegate(signature_type_t const signature_type, uint8_t const hash[HASH_SIZE]) {
+    uint8_t key[NAMED_DELEGATE_KEY_SIZE];
+    key[0] = signature_type;
+    memcpy(&key[1], hash, HASH_SIZE);
+
+    size_t low = 0;
+    size_t high = NAMED_DELEGATE_COUNT;
+    while (low < high) {
+        size_t const mid = low + (high - low) / 2;
+        int const order = memcmp(named_delegate_keys[mid], key, sizeof(key));
+        if (order == 0) return mid;
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return NAMED_DELEGATE_COUNT;
+}
+
+// Expands the compressed name of delegate `index`, as described in tools/gen-delegates.py.
+static void named_delegate_to_string(char *const buff, size_t const buff_size, size_t const index) {
+    size_t out = 0;
+    size_t const end = named_delegate_name_offsets[index + 1];
+    for (size_t i = named_delegate_name_offsets[index]; i < end; i++) {
+        uint8_t const code = named_delegate_names[i];
+        uint8_t const *text = &named_delegate_names[i];
+        size_t length = 1;
+        if (code == DELEGATE_NAME_LITERAL_CODE) {
+            if (++i == end) THROW(EXC_MEMORY_ERROR);
+            text = &named_delegate_names[i];
+        } else if (code >= DELEGATE_NAME_WORD_CODE) {
+            size_t const word = code - DELEGATE_NAME_WORD_CODE;
+            if (word + 1 >= NUM_ELEMENTS(delegate_name_word_offsets)) THROW(EXC_MEMORY_ERROR);
+            text = &delegate_name_words[delegate_name_word_offsets[word]];
+            length = delegate_name_word_offsets[word + 1] - delegate_name_word_offsets[word];
+        }
+        if (buff_size - out <= length) THROW(EXC_WRONG_LENGTH);
+        memcpy(&buff[out], text, length);
+        out += length;
+    }
+    buff[out] = '\0';
+}
+
 void lookup_parsed_contract_name(
     char *const buff,
     size_t const buff_size,
     parsed_contract_t const *const contract
 ) {
-    parsed_contract_to_string(buff, buff_size, contract);
-
-    for (uint16_t i = 0; i < sizeof(named_delegates) / sizeof(named_delegate_t); i++) {
-        if (memcmp(named_delegates[i].bakerAccount, buff, HASH_SIZE_B58) == 0) {
-            // Found a matching baker, display it.
-            const char* name = (const char*)pic((unsigned int)named_delegates[i].bakerName);
-            if (buff_size <= strlen(name)) THROW(EXC_WRONG_LENGTH);
-            strcpy(buff, name);
-            return;
-        }
+    check_null(buff);
+    check_null(contract);
+
+    size_t index = NAMED_DELEGATE_COUNT;
+    if (contract->originated == 0 && contract->signature_type != SIGNATURE_TYPE_UNSET) {
+        index = find_named_delegate(contract->signature_type, contract->hash);
     }
 
-    if (buff_size <= strlen(NO_CONTRACT_NAME_STRING)) THROW(EXC_WRONG_LENGTH);
-    strcpy(buff, NO_CONTRACT_NAME_STRING);
+    if (index < NAMED_DELEGATE_COUNT) {
+        named_delegate_to_string(buff, buff_size, index);
+    } else {
+        if (buff_size <= strlen(NO_CONTRACT_NAME_STRING)) THROW(EXC_WRONG_LENGTH);
+        strcpy(buff, NO_CONTRACT_NAME_STRING);
+    }
 }
 
 void pubkey_to_pkh_string(
@@ -85,9 +127,29 @@ void bip32_path_with_curve_to_pkh_string(
     check_null(out);
     check_null(key);
 
-    cx_ecfp_public_key_t const *const pubkey = generate_public_key_return_global(
+    struct key_cache_entry const *const cached = public_key_hash_of_path_return_global(
         key->derivation_type, &key->bip32_path);
-    pubkey_to_pkh_string(out, out_size, key->derivation_type, pubkey);
+    pkh_to_string(out, out_size, derivation_type_to_signature_type(key->derivation_type), cached->hash);
+}
+
+void bip32_path_to_string(char *const out, size_t const out_size, bip32_path_t const *const path) {
+    check_null(out);
+    check_null(path);
+
+    size_t ix = 0;
+    for (size_t i = 0; i < path->length; i++) {
+        char digits[MAX_INT_DIGITS + 1];
+        size_t const length = number_to_string(digits, path->components[i] & ~BIP32_HARDENED_BIT);
+
+        // Separator, digits, apostrophe and the terminating null
+        if (out_size - ix < 1 + length + 1 + 1) THROW(EXC_WRONG_LENGTH);
+        if (i != 0) out[ix++] = '/';
+        memcpy(out + ix, digits, length);
+        ix += length;
+        if (path->components[i] & BIP32_HARDENED_BIT) out[ix++] = '\'';
+    }
+    if (out_size - ix < 1) THROW(EXC_WRONG_LENGTH);
+    out[ix] = '\0';
 }
 
 
@@ -115,6 +177,28 @@ void buffer_to_base58(char *const out, size_t const out_size, buffer_t const *co
     bin_to_base58(out, out_size, src->bytes, src->length);
 }
 
+void script_hash_to_string(char *const buff, size_t const buff_size, uint8_t const hash[SIGN_HASH_SIZE]) {
+    check_null(buff);
+    check_null(hash);
+    _Static_assert(SIGN_HASH_SIZE == 32, "Script hashes need another encoder");
+    size_t out_size = buff_size;
+    if (!b58enc_32(buff, &out_size, hash)) THROW(EXC_WRONG_LENGTH);
+}
+
+// Base58 prefixes of key hashes, by signature type. SIGNATURE_TYPE_UNSET stands for originated contracts.
+static const uint8_t pkh_prefixes[][3] = {
+    [SIGNATURE_TYPE_UNSET] = {2, 90, 121}, // KT1
+    [SIGNATURE_TYPE_SECP256K1] = {6, 161, 161}, // tz2
+    [SIGNATURE_TYPE_SECP256R1] = {6, 161, 164}, // tz3
+    [SIGNATURE_TYPE_ED25519] = {6, 161, 159}, // tz1
+};
+
+struct __attribute__((packed)) pkh_base58_data {
+    uint8_t prefix[3];
+    uint8_t hash[HASH_SIZE];
+    uint8_t checksum[TEZOS_HASH_CHECKSUM_SIZE];
+};
+
 void pkh_to_string(
     char *const buff, size_t const buff_size,
     signature_type_t const signature_type,
@@ -125,44 +209,45 @@ void pkh_to_string(
     if (buff_size < PKH_STRING_SIZE) THROW(EXC_WRONG_LENGTH);
 
     // Data to encode
-    struct __attribute__((packed)) {
-        uint8_t prefix[3];
-        uint8_t hash[HASH_SIZE];
-        uint8_t checksum[TEZOS_HASH_CHECKSUM_SIZE];
-    } data;
+    struct pkh_base58_data data;
 
     // prefix
-    switch (signature_type) {
-        case SIGNATURE_TYPE_UNSET:
-            data.prefix[0] = 2;
-            data.prefix[1] = 90;
-            data.prefix[2] = 121;
-            break;
-        case SIGNATURE_TYPE_ED25519:
-            data.prefix[0] = 6;
-            data.prefix[1] = 161;
-            data.prefix[2] = 159;
-            break;
-        case SIGNATURE_TYPE_SECP256K1:
-            data.prefix[0] = 6;
-            data.prefix[1] = 161;
-            data.prefix[2] = 161;
-            break;
-        case SIGNATURE_TYPE_SECP256R1:
-            data.prefix[0] = 6;
-            data.prefix[1] = 161;
-            data.prefix[2] = 164;
-            break;
-        default:
-            THROW(EXC_WRONG_PARAM); // Should not reach
-    }
+    if ((size_t)signature_type >= NUM_ELEMENTS(pkh_prefixes)) THROW(EXC_WRONG_PARAM); // Should not reach
+    memcpy(data.prefix, pkh_prefixes[signature_type], sizeof(data.prefix));
 
     // hash
     memcpy(data.hash, hash, sizeof(data.hash));
     compute_hash_checksum(data.checksum, &data, sizeof(data) - sizeof(data.checksum));
 
+    _Static_assert(sizeof(data) == PKH_BASE58_DATA_SIZE, "Key hashes need another encoder");
     size_t out_size = buff_size;
-    if (!b58enc(buff, &out_size, &data, sizeof(data))) THROW(EXC_WRONG_LENGTH);
+    if (!b58enc_27(buff, &out_size, &data)) THROW(EXC_WRONG_LENGTH);
+}
+
+bool pkh_from_base58_data(
+    signature_type_t *const signature_type_out,
+    uint8_t hash_out[HASH_SIZE],
+    uint8_t const bytes[PKH_BASE58_DATA_SIZE]
+) {
+    check_null(signature_type_out);
+    check_null(hash_out);
+    check_null(bytes);
+
+    _Static_assert(sizeof(struct pkh_base58_data) == PKH_BASE58_DATA_SIZE, "Key hashes decode to another size");
+    struct pkh_base58_data const *const data = (struct pkh_base58_data const *)bytes;
+
+    uint8_t checksum[TEZOS_HASH_CHECKSUM_SIZE];
+    compute_hash_checksum(checksum, data, sizeof(*data) - sizeof(data->checksum));
+    if (memcmp(checksum, data->checksum, sizeof(checksum)) != 0) return false;
+
+    for (size_t i = 0; i < NUM_ELEMENTS(pkh_prefixes); i++) {
+        if (memcmp(data->prefix, pkh_prefixes[i], sizeof(data->prefix)) == 0) {
+            *signature_type_out = (signature_type_t)i;
+            memcpy(hash_out, data->hash, sizeof(data->hash));
+            return true;
+        }
+    }
+    return false;
 }
 
 void protocol_hash_to_string(char *buff, const size_t buff_size, const uint8_t hash[PROTOCOL_HASH_SIZE]) {
@@ -182,8 +267,9 @@ void protocol_hash_to_string(char *buff, const size_t buff_size, const uint8_t h
     memcpy(data.hash, hash, sizeof(data.hash));
     compute_hash_checksum(data.checksum, &data, sizeof(data) - sizeof(data.checksum));
 
+    _Static_assert(sizeof(data) == 38, "Protocol hashes need another encoder");
     size_t out_size = buff_size;
-    if (!b58enc(buff, &out_size, &data, sizeof(data))) THROW(EXC_WRONG_LENGTH);
+    if (!b58enc_38(buff, &out_size, &data)) THROW(EXC_WRONG_LENGTH);
 }
 
 void chain_id_to_string(char *const buff, size_t const buff_size, chain_id_t const chain_id) {
@@ -225,24 +311,6 @@ void chain_id_to_string_with_aliases(char *const out, size_t const out_size, cha
     }
 }
 
-// These functions do not output terminating null bytes.
-
-// This function fills digits, potentially with all leading zeroes, from the end of the buffer backwards
-// This is intended to be used with a temporary buffer of length MAX_INT_DIGITS
-// Returns offset of where it stopped filling in
-static inline size_t convert_number(char dest[MAX_INT_DIGITS], uint64_t number, bool leading_zeroes) {
-    check_null(dest);
-    char *const end = dest + MAX_INT_DIGITS;
-    for (char *ptr = end - 1; ptr >= dest; ptr--) {
-        *ptr = '0' + number % 10;
-        number /= 10;
-        if (!leading_zeroes && number == 0) { // TODO: This is ugly
-            return ptr - dest;
-        }
-    }
-    return 0;
-}
-
 void number_to_string_indirect64(char *const dest, size_t const buff_size, uint64_t const *const number) {
     check_null(dest);
     check_null(number);
@@ -260,54 +328,21 @@ void number_to_string_indirect32(char *const dest, size_t const buff_size, uint3
 void microtez_to_string_indirect(char *const dest, size_t const buff_size, uint64_t const *const number) {
     check_null(dest);
     check_null(number);
-    if (buff_size < MAX_INT_DIGITS + 1) THROW(EXC_WRONG_LENGTH); // + terminating null + decimal point
+    if (buff_size < DECIMAL_MAX_LENGTH + 1) THROW(EXC_WRONG_LENGTH); // + terminating null
     microtez_to_string(dest, *number);
 }
 
 size_t number_to_string(char *const dest, uint64_t number) {
     check_null(dest);
-    char tmp[MAX_INT_DIGITS];
-    size_t off = convert_number(tmp, number, false);
-
-    // Copy without leading 0s
-    size_t length = sizeof(tmp) - off;
-    memcpy(dest, tmp + off, length);
-    dest[length] = '\0';
-    return length;
+    return decimal_to_string(dest, number, 0);
 }
 
 // Microtez are in millionths
-#define TEZ_SCALE 1000000
 #define DECIMAL_DIGITS 6
 
 size_t microtez_to_string(char *const dest, uint64_t number) {
     check_null(dest);
-    uint64_t whole_tez = number / TEZ_SCALE;
-    uint64_t fractional = number % TEZ_SCALE;
-    size_t off = number_to_string(dest, whole_tez);
-    if (fractional == 0) {
-        return off;
-    }
-    dest[off++] = '.';
-
-    char tmp[MAX_INT_DIGITS];
-    convert_number(tmp, number, true);
-
-    // Eliminate trailing 0s
-    char *start = tmp + MAX_INT_DIGITS - DECIMAL_DIGITS;
-    char *end;
-    for (end = tmp + MAX_INT_DIGITS - 1; end >= start; end--) {
-        if (*end != '0') {
-            end++;
-            break;
-        }
-    }
-
-    size_t length = end - start;
-    memcpy(dest + off, start, length);
-    off += length;
-    dest[off] = '\0';
-    return off;
+    return decimal_to_string(dest, number, DECIMAL_DIGITS);
 }
 
 void copy_string(char *const dest, size_t const buff_size, char const *const src) {
@@ -14,11 +14,22 @@ void pubkey_to_pkh_string(
     derivation_type_t const derivation_type,
     cx_ecfp_public_key_t const *const public_key
 );
+// Parses the decoded bytes of a base58 key hash or originated contract address (SIGNATURE_TYPE_UNSET),
+// checksum included. Returns false if they aren't one.
+bool pkh_from_base58_data(
+    signature_type_t *const signature_type_out,
+    uint8_t hash_out[HASH_SIZE],
+    uint8_t const data[PKH_BASE58_DATA_SIZE]
+);
 void bip32_path_with_curve_to_pkh_string(
     char *const out, size_t const out_size,
     bip32_path_with_curve_t const *const key
 );
+// Components are separated by '/', and hardened ones end with an apostrophe.
+void bip32_path_to_string(char *const out, size_t const out_size, bip32_path_t const *const path);
 void protocol_hash_to_string(char *const buff, size_t const buff_size, uint8_t const hash[PROTOCOL_HASH_SIZE]);
+// Base58 of the hash, with no prefix or checksum.
+void script_hash_to_string(char *const buff, size_t const buff_size, uint8_t const hash[SIGN_HASH_SIZE]);
 void parsed_contract_to_string(char *const buff, size_t const buff_size, parsed_contract_t const *const contract);
 void lookup_parsed_contract_name(char *const buff, size_t const buff_size, parsed_contract_t const *const contract);
 void chain_id_to_string(char *const buff, size_t const buff_size, chain_id_t const chain_id);
@@ -42,6 +42,10 @@ typedef enum {
 // Return number of bytes to transmit (tx)
 typedef size_t (*apdu_handler)(uint8_t instruction);
 
+// Writes the next part of a chained response into `out`, at most `out_size` bytes, and returns its length.
+// Sets `*more` if another part follows this one.
+typedef size_t (*response_producer_t)(uint8_t *const out, size_t const out_size, bool *const more);
+
 typedef uint32_t level_t;
 
 #define CHAIN_ID_BASE58_STRING_SIZE sizeof("NetXdQprcVkpaWU")
@@ -68,6 +72,9 @@ typedef bool (*ui_callback_t)(void); // return true to go back to idle screen
 // function pointers.
 typedef void (*string_generation_callback)(/* char *buffer, size_t buffer_size, const void *data */);
 
+// Renders screen `which` of a prompt: its label into `prompt` and its value into `value`.
+typedef void (*screen_generator)(size_t which, char *prompt, size_t prompt_size, char *value, size_t value_size);
+
 // Keys
 typedef struct {
     cx_ecfp_public_key_t public_key;
@@ -76,6 +83,8 @@ typedef struct {
 
 // Baking Auth
 #define MAX_BIP32_PATH 10
+#define BIP32_HARDENED_BIT 0x80000000 // Set in path components that use hardened derivation
+#define CHAIN_CODE_SIZE 32
 
 typedef struct {
     uint8_t length;
@@ -156,7 +165,7 @@ typedef struct {
 #define PKH_STRING_SIZE 40 // includes null byte // TODO: use sizeof for this.
 #define PROTOCOL_HASH_BASE58_STRING_SIZE sizeof("ProtoBetaBetaBetaBetaBetaBetaBetaBetaBet11111a5ug96")
 
-#define MAX_SCREEN_COUNT 7 // Current maximum usage
+#define MAX_SCREEN_COUNT 8 // Current maximum usage
 #define PROMPT_WIDTH 16
 #define VALUE_WIDTH PROTOCOL_HASH_BASE58_STRING_SIZE
 
@@ -166,6 +175,9 @@ typedef struct {
     str; \
 })
 
+// Same check as PROMPT, for initializers outside of functions where statement expressions aren't allowed.
+#define CONST_PROMPT(str) (sizeof(char[sizeof(str) <= PROMPT_WIDTH + 1/*null byte*/ ? 1 : -1]) ? (str) : (str))
+
 #define STATIC_UI_VALUE(str) ({ \
     _Static_assert(sizeof(str) <= VALUE_WIDTH + 1/*null byte*/, str " won't fit in the UI."); \
     str; \
@@ -175,12 +187,25 @@ typedef struct {
 // Operations
 #define PROTOCOL_HASH_SIZE 32
 
+#define MAX_ENTRYPOINT_LENGTH 31
+
 // TODO: Rename to KEY_HASH_SIZE
 #define HASH_SIZE 20
 
 // HASH_SIZE encoded in base-58 ASCII
 #define HASH_SIZE_B58 36
 
+// What HASH_SIZE_B58 characters decode to: a 3-byte prefix, the hash and a 4-byte checksum
+#define PKH_BASE58_DATA_SIZE 27
+
+// Largest compressed public key: a parity byte, then X, on the secp256 curves
+#define MAX_COMPRESSED_PUBLIC_KEY_SIZE 33
+
+struct compressed_public_key {
+    uint8_t length;
+    uint8_t bytes[MAX_COMPRESSED_PUBLIC_KEY_SIZE];
+};
+
 typedef struct {
     chain_id_t chain_id;
     bool is_endorsement;
@@ -193,8 +218,6 @@ typedef struct parsed_contract {
                                      // An implicit contract with signature_type of 0 means not present
 
     uint8_t hash[HASH_SIZE];
-
-    char *hash_ptr;
 } parsed_contract_t;
 
 struct parsed_proposal {
@@ -227,19 +250,43 @@ enum operation_tag {
     OPERATION_TAG_BABYLON_TRANSACTION = 108,
     OPERATION_TAG_BABYLON_ORIGINATION = 109,
     OPERATION_TAG_BABYLON_DELEGATION = 110,
+    OPERATION_TAG_ITHACA_SET_DEPOSITS_LIMIT = 112,
+};
+
+// What an operation does, independent of the protocol-specific tag it was encoded with.
+enum operation_kind {
+    OPERATION_KIND_NONE = 0,
+    OPERATION_KIND_PROPOSAL,
+    OPERATION_KIND_BALLOT,
+    OPERATION_KIND_REVEAL,
+    OPERATION_KIND_TRANSACTION,
+    OPERATION_KIND_ORIGINATION,
+    OPERATION_KIND_DELEGATION,
+    OPERATION_KIND_SET_DEPOSITS_LIMIT,
 };
 
-// TODO: Make this an enum.
-// Flags for parsed_operation.flag
-#define ORIGINATION_FLAG_SPENDABLE 1
-#define ORIGINATION_FLAG_DELEGATABLE 2
+// Screens of rendered contract call parameters that can be shown; longer parameters are signed as a hash.
+#ifdef TARGET_NANOX
+#   define PARAMETERS_PAGES 8
+#else
+#   define PARAMETERS_PAGES 3
+#endif
 
 struct parsed_operation {
-    enum operation_tag tag;
+    enum operation_tag tag; // As found on the wire
+    enum operation_kind kind; // May differ from the tag's kind for manager.tz transactions
     struct parsed_contract source;
     struct parsed_contract destination;
     union {
-        struct parsed_contract delegate; // For originations only
+        struct { // For originations only
+            struct parsed_contract delegate;
+            uint8_t script_hash[SIGN_HASH_SIZE]; // Of the code and storage, as encoded in the operation
+        };
+        struct { // For contract calls only
+            char entrypoint[MAX_ENTRYPOINT_LENGTH + 1]; // Empty if the call has no parameters
+            // Rendered Micheline, empty if it couldn't be rendered or didn't fit
+            char parameters[PARAMETERS_PAGES * VALUE_WIDTH + 1];
+        };
         struct parsed_proposal proposal; // For proposals only
         struct parsed_ballot ballot; // For ballots only
     };
@@ -249,10 +296,12 @@ struct parsed_operation {
 
     uint64_t amount; // 0 where inappropriate
     uint32_t flags;  // Interpretation depends on operation type
+    uint16_t absent_fields; // Bit n is set when optional schema field n was not present
+    uint16_t ready_fields; // Bit n is set once schema field n is parsed and can no longer change
 };
 
 struct parsed_operation_group {
-    cx_ecfp_public_key_t public_key; // compressed
+    struct compressed_public_key public_key;
     uint64_t total_fee;
     uint64_t total_storage_limit;
     bool has_reveal;
@@ -261,7 +310,7 @@ struct parsed_operation_group {
 };
 
 // Maximum number of APDU instructions
-#define INS_MAX 0x0F
+#define INS_MAX 0x14
 
 #define APDU_INS(x) ({ \
     _Static_assert(x <= INS_MAX, "APDU instruction is out of bounds"); \
@@ -22,7 +22,25 @@ __attribute__((noreturn)) bool exit_app(void); // Might want to send it argument
 __attribute__((noreturn))
 void ui_prompt(const char *const *labels, ui_callback_t ok_c, ui_callback_t cxl_c);
 
+// Displays labels like ui_prompt, but offers neither accept nor reject, and returns.
+// The screens stay up until the next prompt, so data can be shown while it's still arriving.
+void ui_preview(const char *const *labels);
+
+// Like ui_prompt and ui_preview, with screens that `generate` renders as they are shown, so that there can be any
+// number of them. Only a few rendered screens are kept at a time.
+__attribute__((noreturn))
+void ui_prompt_screens(size_t screen_count, screen_generator generate, ui_callback_t ok_c, ui_callback_t cxl_c);
+void ui_preview_screens(size_t screen_count, screen_generator generate);
+
+// Returns to the initial screen if a preview is being displayed.
+void ui_cancel_preview(void);
+
 
 // This function registers how a value is to be produced
 void register_ui_callback(uint32_t which, string_generation_callback cb, const void *data);
+
+// Used by the device-specific UI code to show the screens of ui_prompt and ui_preview.
+// set_registered_screens checks labels and their callbacks and returns the number of screens.
+size_t set_registered_screens(const char *const *labels);
+void registered_screen(size_t which, char *prompt, size_t prompt_size, char *value, size_t value_size);
 #define REGISTER_STATIC_UI_VALUE(index, str) register_ui_callback(index, copy_string, STATIC_UI_VALUE(str))
@@ -2,6 +2,9 @@
 
 #include "globals.h"
 #include "os.h"
+#include "to_string.h"
+
+#include <string.h>
 
 void io_seproxyhal_display(const bagl_element_t *element);
 
@@ -19,6 +22,42 @@ void register_ui_callback(uint32_t which, string_generation_callback cb, const v
     global.ui.prompt.callback_data[which] = data;
 }
 
+size_t set_registered_screens(const char *const *const labels) {
+    check_null(labels);
+    global.ui.prompt.labels = labels;
+
+    size_t i;
+    for (i = 0; labels[i] != NULL; i++) {
+        const char *const label = (const char *)PIC(labels[i]);
+        if (i >= MAX_SCREEN_COUNT || strlen(label) > PROMPT_WIDTH) THROW(EXC_MEMORY_ERROR);
+        if (global.ui.prompt.callbacks[i] == NULL) THROW(EXC_MEMORY_ERROR);
+    }
+    return i;
+}
+
+void registered_screen(
+    size_t const which,
+    char *const prompt, size_t const prompt_size,
+    char *const value, size_t const value_size
+) {
+    if (which >= MAX_SCREEN_COUNT || global.ui.prompt.callbacks[which] == NULL) THROW(EXC_MEMORY_ERROR);
+    copy_string(prompt, prompt_size, global.ui.prompt.labels[which]);
+    global.ui.prompt.callbacks[which](value, value_size, global.ui.prompt.callback_data[which]);
+}
+
+__attribute__((noreturn))
+void ui_prompt(const char *const *labels, ui_callback_t ok_c, ui_callback_t cxl_c) {
+    ui_prompt_screens(set_registered_screens(labels), registered_screen, ok_c, cxl_c);
+}
+
+void ui_preview(const char *const *labels) {
+    ui_preview_screens(set_registered_screens(labels), registered_screen);
+}
+
+void ui_cancel_preview(void) {
+    if (global.ui.previewing) ui_initial_screen();
+}
+
 void require_pin(void) {
     bolos_ux_params_t params;
     memset(&params, 0, sizeof(params));
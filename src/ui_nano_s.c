@@ -33,6 +33,8 @@ static void ui_display(const bagl_element_t *elems, size_t sz, ui_callback_t ok_
 
 
 // ----------------------------- ui_prompt
+// This is called by internal UI code to render the first screens of a prompt once, before it is shown
+static void render_screens(size_t screen_count);
 // This is called by internal UI code to implement buffering
 static void switch_screen(uint32_t which);
 // This is called by internal UI code to prevent callbacks from sticking around
@@ -180,6 +182,7 @@ void ui_display(const bagl_element_t *elems, size_t sz, ui_callback_t ok_c, ui_c
     G.ok_callback = ok_c;
     G.cxl_callback = cxl_c;
     if (!is_idling()) {
+        render_screens(step_count);
         switch_screen(0);
     }
 // TODO: Upgrade the nano-sdk to the master branch, and upgrade legacy ui functions
@@ -280,35 +283,81 @@ static const bagl_element_t ui_multi_screen[] = {
      global.ui.prompt.active_value },
 };
 
+static void render_screen(uint32_t which) {
+    if (which >= global.ui.prompt.screen_count) THROW(EXC_MEMORY_ERROR);
+    global.ui.prompt.generate(
+        which,
+        global.ui.prompt.active_prompt, sizeof(global.ui.prompt.active_prompt),
+        global.ui.prompt.active_value, sizeof(global.ui.prompt.active_value));
+}
+
+void render_screens(size_t const screen_count) {
+    size_t used = 0;
+    for (size_t i = 0; i < screen_count && i < PROMPT_CACHED_SCREENS; i++) {
+        render_screen(i);
+        size_t const prompt_size = strlen(global.ui.prompt.active_prompt) + 1;
+        size_t const value_size = strlen(global.ui.prompt.active_value) + 1;
+        if (prompt_size + value_size <= sizeof(global.ui.prompt.screens) - used) {
+            char *const entry = &global.ui.prompt.screens[used];
+            memcpy(entry, global.ui.prompt.active_prompt, prompt_size);
+            memcpy(entry + prompt_size, global.ui.prompt.active_value, value_size);
+            global.ui.prompt.screen_offsets[i] = used;
+            used += prompt_size + value_size;
+        } else {
+            global.ui.prompt.screen_offsets[i] = PROMPT_SCREEN_NOT_CACHED;
+        }
+    }
+}
+
 void switch_screen(uint32_t which) {
-    if (which >= MAX_SCREEN_COUNT) THROW(EXC_MEMORY_ERROR);
-    const char *label = (const char*)PIC(global.ui.prompt.prompts[which]);
-
-    strncpy(global.ui.prompt.active_prompt, label, sizeof(global.ui.prompt.active_prompt));
-    if (global.ui.prompt.callbacks[which] == NULL) THROW(EXC_MEMORY_ERROR);
-    global.ui.prompt.callbacks[which](
-        global.ui.prompt.active_value, sizeof(global.ui.prompt.active_value),
-        global.ui.prompt.callback_data[which]);
+    if (which >= global.ui.prompt.screen_count) THROW(EXC_MEMORY_ERROR);
+    if (which < PROMPT_CACHED_SCREENS && global.ui.prompt.screen_offsets[which] != PROMPT_SCREEN_NOT_CACHED) {
+        // Entries were checked to fit in active_prompt and active_value when they were rendered.
+        char const *const entry = &global.ui.prompt.screens[global.ui.prompt.screen_offsets[which]];
+        strcpy(global.ui.prompt.active_prompt, entry);
+        strcpy(global.ui.prompt.active_value, entry + strlen(entry) + 1);
+    } else {
+        render_screen(which);
+    }
 }
 
+// Same as ui_multi_screen, without the buttons.
+static const bagl_element_t ui_preview_screen[] = {
+    {{BAGL_RECTANGLE, BAGL_STATIC_ELEMENT, 0, 0, 128, 32, 0, 0, BAGL_FILL, 0x000000, 0xFFFFFF,
+      0, 0},
+     NULL },
+
+    {{BAGL_LABELINE, BAGL_STATIC_ELEMENT, 0, 12, 128, 12, 0, 0, 0, 0xFFFFFF, 0x000000,
+      BAGL_FONT_OPEN_SANS_EXTRABOLD_11px | BAGL_FONT_ALIGNMENT_CENTER, 0},
+     global.ui.prompt.active_prompt },
+
+    {{BAGL_LABELINE, BAGL_SCROLLING_ELEMENT, 23, 26, 82, 12, 0x80 | 10, 0, 0, 0xFFFFFF, 0x000000,
+      BAGL_FONT_OPEN_SANS_EXTRABOLD_11px | BAGL_FONT_ALIGNMENT_CENTER, 26},
+     global.ui.prompt.active_value },
+};
+
 void clear_ui_callbacks(void) {
     for (int i = 0; i < MAX_SCREEN_COUNT; ++i) {
         global.ui.prompt.callbacks[i] = NULL;
     }
+    global.ui.prompt.screen_count = 0;
+    memset(global.ui.prompt.screens, 0, sizeof(global.ui.prompt.screens));
+    memset(global.ui.prompt.screen_offsets, PROMPT_SCREEN_NOT_CACHED, sizeof(global.ui.prompt.screen_offsets));
+    G.previewing = false;
+}
+
+static void set_screens(size_t const screen_count, screen_generator const generate) {
+    check_null(generate);
+    if (screen_count == 0) THROW(EXC_MEMORY_ERROR);
+    global.ui.prompt.generate = generate;
+    global.ui.prompt.screen_count = screen_count;
 }
 
 __attribute__((noreturn))
-void ui_prompt(const char *const *labels, ui_callback_t ok_c, ui_callback_t cxl_c) {
-    check_null(labels);
-    global.ui.prompt.prompts = labels;
-
-    size_t i;
-    for (i = 0; labels[i] != NULL; i++) {
-        const char *label = (const char *)PIC(labels[i]);
-        if (i >= MAX_SCREEN_COUNT || strlen(label) > PROMPT_WIDTH) THROW(EXC_MEMORY_ERROR);
-    }
-    size_t screen_count = i;
+void ui_prompt_screens(size_t const screen_count, screen_generator const generate, ui_callback_t ok_c, ui_callback_t cxl_c) {
+    set_screens(screen_count, generate);
 
+    G.previewing = false;
     ui_display(ui_multi_screen, NUM_ELEMENTS(ui_multi_screen),
                ok_c, cxl_c, screen_count);
 #ifdef DEBUG
@@ -319,6 +368,19 @@ void ui_prompt(const char *const *labels, ui_callback_t ok_c, ui_callback_t cxl_
 #endif
 }
 
+// Either button, or the prompt timeout, only hides the preview.
+static bool dismiss_preview(void) {
+    return true;
+}
+
+void ui_preview_screens(size_t const screen_count, screen_generator const generate) {
+    set_screens(screen_count, generate);
+
+    ui_display(ui_preview_screen, NUM_ELEMENTS(ui_preview_screen),
+               dismiss_preview, dismiss_preview, screen_count);
+    G.previewing = true;
+}
+
 
 #pragma mark ui_menu
 
@@ -129,23 +129,77 @@ UX_FLOW(ux_idle_flow,
 
 
 // prompt
-#define PROMPT_SCREEN_NAME(idx) ux_prompt_flow_ ## idx ## _step
-#define PROMPT_SCREEN_TPL(idx) \
-    UX_STEP_NOCB( \
-        PROMPT_SCREEN_NAME(idx), \
-        bnnn_paging, \
-        { \
-            .title = G.prompt.screen[idx].prompt, \
-            .text = G.prompt.screen[idx].value, \
-        })
-
-PROMPT_SCREEN_TPL(0);
-PROMPT_SCREEN_TPL(1);
-PROMPT_SCREEN_TPL(2);
-PROMPT_SCREEN_TPL(3);
-PROMPT_SCREEN_TPL(4);
-PROMPT_SCREEN_TPL(5);
-PROMPT_SCREEN_TPL(6);
+// The screens of a prompt are all shown by one step, between two steps that are never displayed. Moving onto
+// either of those renders the next or previous screen and moves back onto the screen step, until there are no
+// more screens that way and the flow goes on past them.
+
+// Copies screen `which` into the screen step, rendering it unless it is still in the window.
+static void show_screen(size_t const which) {
+    if (which >= G.prompt.screen_count) THROW(EXC_MEMORY_ERROR);
+    check_null(G.prompt.generate);
+
+    struct prompt_window_entry *const entry = &G.prompt.window[which % PROMPT_WINDOW_SIZE];
+    if (entry->index != which) {
+        entry->index = PROMPT_NO_SCREEN; // In case rendering fails
+        memset(&entry->screen, 0, sizeof(entry->screen));
+        G.prompt.generate(
+            which,
+            entry->screen.prompt, sizeof(entry->screen.prompt),
+            entry->screen.value, sizeof(entry->screen.value));
+        entry->index = which;
+    }
+    memcpy(&G.prompt.shown, &entry->screen, sizeof(G.prompt.shown));
+    G.prompt.current_screen = which;
+}
+
+// Only reached going back from the screen step.
+static void before_screen_step(void) {
+    if (G.prompt.current_screen > 0) {
+        show_screen(G.prompt.current_screen - 1);
+    }
+    ux_flow_next();
+}
+
+static void after_screen_step(void) {
+    if (!G.prompt.on_screens) {
+        // Coming back from the steps after the screens, to the last one
+        G.prompt.on_screens = true;
+        ux_flow_prev();
+    } else if (G.prompt.current_screen + 1 < G.prompt.screen_count) {
+        show_screen(G.prompt.current_screen + 1);
+        ux_flow_prev();
+        // Steps entered going back start on their last page, but this is a new screen.
+        G_ux.layout_paging.current = 0;
+        ux_layout_bnnn_paging_redisplay(0);
+    } else {
+        G.prompt.on_screens = false;
+        ux_flow_next();
+    }
+}
+
+UX_STEP_INIT(
+    ux_prompt_flow_before_step,
+    NULL,
+    NULL,
+    {
+        before_screen_step();
+    });
+
+UX_STEP_NOCB(
+    ux_prompt_flow_screen_step,
+    bnnn_paging,
+    {
+        .title = G.prompt.shown.prompt,
+        .text = G.prompt.shown.value,
+    });
+
+UX_STEP_INIT(
+    ux_prompt_flow_after_step,
+    NULL,
+    NULL,
+    {
+        after_screen_step();
+    });
 
 static void prompt_response(bool const accepted) {
     ui_initial_screen();
@@ -175,17 +229,27 @@ UX_STEP_CB(
     });
 
 UX_FLOW(ux_prompts_flow,
-    &PROMPT_SCREEN_NAME(0),
-    &PROMPT_SCREEN_NAME(1),
-    &PROMPT_SCREEN_NAME(2),
-    &PROMPT_SCREEN_NAME(3),
-    &PROMPT_SCREEN_NAME(4),
-    &PROMPT_SCREEN_NAME(5),
-    &PROMPT_SCREEN_NAME(6),
+    &ux_prompt_flow_before_step,
+    &ux_prompt_flow_screen_step,
+    &ux_prompt_flow_after_step,
     &ux_prompt_flow_reject_step,
     &ux_prompt_flow_accept_step
 );
-_Static_assert(NUM_ELEMENTS(ux_prompts_flow) - 3 /*reject + accept + end*/ == MAX_SCREEN_COUNT, "ux_prompts_flow doesn't have the same number of screens as MAX_SCREEN_COUNT");
+
+UX_STEP_NOCB(
+    ux_preview_flow_wait_step,
+    bn,
+    {
+        "Receiving",
+        "operation..."
+    });
+
+UX_FLOW(ux_preview_flow,
+    &ux_prompt_flow_before_step,
+    &ux_prompt_flow_screen_step,
+    &ux_prompt_flow_after_step,
+    &ux_preview_flow_wait_step
+);
 
 
 void ui_initial_screen(void) {
@@ -193,6 +257,8 @@ void ui_initial_screen(void) {
         calculate_baking_idle_screens_data();
 #   endif
 
+    G.previewing = false;
+
     // reserve a display stack slot if none yet
     if(G_ux.stack_count == 0) {
         ux_stack_push();
@@ -200,31 +266,35 @@ void ui_initial_screen(void) {
     ux_flow_init(0, ux_idle_flow, NULL);
 }
 
-__attribute__((noreturn))
-void ui_prompt(const char *const *labels, ui_callback_t ok_c, ui_callback_t cxl_c) {
-    check_null(labels);
-
-    size_t const screen_count = ({
-        size_t i = 0;
-        while (i < MAX_SCREEN_COUNT && labels[i] != NULL) { i++; }
-        i;
-    });
-
-    // We fill the destination buffers at the end instead of the beginning so we can
-    // use the same array for any number of screens.
-    size_t const offset = MAX_SCREEN_COUNT - screen_count;
-    for (size_t i = 0; labels[i] != NULL; i++) {
-        const char *const label = (const char *)PIC(labels[i]);
-        if (strlen(label) > sizeof(G.prompt.screen[i].prompt)) THROW(EXC_MEMORY_ERROR);
-        strcpy(G.prompt.screen[offset + i].prompt, label);
-        memset(G.prompt.screen[offset + i].value, 0, sizeof(G.prompt.screen[offset + 1].value));
-        G.prompt.callbacks[i](G.prompt.screen[offset + i].value, sizeof(G.prompt.screen[offset + i].value), G.prompt.callback_data[i]);
+// Starts showing a prompt on its first screen.
+static void start_screens(size_t const screen_count, screen_generator const generate) {
+    check_null(generate);
+    if (screen_count == 0) THROW(EXC_MEMORY_ERROR);
+    G.prompt.generate = generate;
+    G.prompt.screen_count = screen_count;
+    for (size_t i = 0; i < PROMPT_WINDOW_SIZE; i++) {
+        G.prompt.window[i].index = PROMPT_NO_SCREEN;
     }
+    G.prompt.on_screens = true;
+    show_screen(0);
+}
 
+__attribute__((noreturn))
+void ui_prompt_screens(size_t const screen_count, screen_generator const generate, ui_callback_t ok_c, ui_callback_t cxl_c) {
+    start_screens(screen_count, generate);
+
+    G.previewing = false;
     G.ok_callback = ok_c;
     G.cxl_callback = cxl_c;
-    ux_flow_init(0, &ux_prompts_flow[offset], NULL);
+    ux_flow_init(0, ux_prompts_flow, &ux_prompt_flow_screen_step);
     THROW(ASYNC_EXCEPTION);
 }
 
+void ui_preview_screens(size_t const screen_count, screen_generator const generate) {
+    start_screens(screen_count, generate);
+
+    G.previewing = true;
+    ux_flow_init(0, ux_preview_flow, &ux_prompt_flow_screen_step);
+}
+
 #endif // #ifdef TARGET_NANOX
@@ -0,0 +1,210 @@
+// Differential test and benchmark of the base58 encoder against the byte-wise one it replaced, and round trips
+// through the decoder.
+// Build and run with test/base58/run.sh.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "base58.h"
+
+// The previous encoder, as it was in src/base58.c (Copyright 2012-2014 Luke Dashjr, MIT license).
+static const char reference_digits[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+static bool reference_b58enc(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *data, size_t binsz)
+{
+    const uint8_t *bin = data;
+    int carry;
+    size_t i, j, high, zcount = 0;
+    size_t size;
+
+    while (zcount < binsz && !bin[zcount])
+        ++zcount;
+
+    size = (binsz - zcount) * 138 / 100 + 1;
+    uint8_t buf[size];
+    memset(buf, 0, size);
+
+    for (i = zcount, high = size - 1; i < binsz; ++i, high = j)
+    {
+        for (carry = bin[i], j = size - 1; ((int)j >= 0) && ((j > high) || carry); --j)
+        {
+            carry += 256 * buf[j];
+            buf[j] = carry % 58;
+            carry /= 58;
+        }
+    }
+
+    for (j = 0; j < size && !buf[j]; ++j);
+
+    if (*b58sz <= zcount + size - j)
+    {
+        *b58sz = zcount + size - j + 1;
+        return false;
+    }
+
+    if (zcount)
+        memset(b58, '1', zcount);
+    for (i = zcount; j < size; ++i, ++j)
+        b58[i] = reference_digits[buf[j]];
+    b58[i] = '\0';
+    *b58sz = i + 1;
+
+    return true;
+}
+
+static unsigned failures;
+
+static void check(char const *const name, uint8_t const *const in, size_t const in_size, size_t const out_size) {
+    char expected[256], actual[256];
+    size_t expected_size = out_size, actual_size = out_size;
+    memset(actual, 0, sizeof(actual));
+    bool const expected_ok = reference_b58enc(expected, &expected_size, in, in_size);
+
+    bool actual_ok;
+    switch (in_size) {
+        case 27: actual_ok = b58enc_27(actual, &actual_size, in); break;
+        case 32: actual_ok = b58enc_32(actual, &actual_size, in); break;
+        case 38: actual_ok = b58enc_38(actual, &actual_size, in); break;
+        default: actual_ok = b58enc(actual, &actual_size, in, in_size); break;
+    }
+
+    if (expected_ok != actual_ok || expected_size != actual_size || (expected_ok && strcmp(expected, actual) != 0)) {
+        failures++;
+        printf("FAIL %s: %zu bytes into %zu:", name, in_size, out_size);
+        for (size_t i = 0; i < in_size; i++) printf(" %02x", in[i]);
+        printf("\n  expected %d %zu %s\n  actual   %d %zu %s\n",
+               expected_ok, expected_size, expected_ok ? expected : "",
+               actual_ok, actual_size, actual_ok ? actual : "");
+    }
+}
+
+static void differential_tests(void) {
+    uint8_t in[B58ENC_MAX_SIZE + 8];
+
+    // Edge values of every size: all zeros, all ones, a single one at either end
+    for (size_t size = 0; size <= B58ENC_MAX_SIZE; size++) {
+        memset(in, 0, size);
+        check("zeros", in, size, 256);
+        memset(in, 0xff, size);
+        check("ones", in, size, 256);
+        if (size > 0) {
+            memset(in, 0, size);
+            in[size - 1] = 1;
+            check("last", in, size, 256);
+            memset(in, 0, size);
+            in[0] = 1;
+            check("first", in, size, 256);
+        }
+    }
+
+    // Random inputs with leading zero bytes, into buffers that are large, exact and too small
+    srand(1);
+    for (unsigned n = 0; n < 200000; n++) {
+        size_t const size = (size_t)rand() % (B58ENC_MAX_SIZE + 1);
+        size_t const zeros = size == 0 ? 0 : (size_t)rand() % 4 == 0 ? (size_t)rand() % size : 0;
+        for (size_t i = 0; i < size; i++) in[i] = i < zeros ? 0 : (uint8_t)rand();
+
+        check("random", in, size, 256);
+        char scratch[256];
+        size_t needed = sizeof(scratch);
+        reference_b58enc(scratch, &needed, in, size);
+        check("exact", in, size, needed);
+        check("short", in, size, needed - 1);
+    }
+}
+
+static void check_decode(uint8_t const *const in, size_t const in_size) {
+    char text[256];
+    size_t text_size = sizeof(text);
+    if (!reference_b58enc(text, &text_size, in, in_size)) return;
+
+    uint8_t out[B58ENC_MAX_SIZE + 8];
+    if (!b58dec(out, in_size, text, text_size - 1) || memcmp(out, in, in_size) != 0) {
+        failures++;
+        printf("FAIL decode of %s\n", text);
+    }
+    // The same number with one more leading '1' is another encoding of it.
+    char longer[257] = "1";
+    memcpy(longer + 1, text, text_size);
+    if (b58dec(out, in_size, longer, text_size)) {
+        failures++;
+        printf("FAIL accepted 1%s\n", text);
+    }
+}
+
+static void decode_tests(void) {
+    uint8_t in[B58ENC_MAX_SIZE + 8];
+    srand(2);
+    for (unsigned n = 0; n < 50000; n++) {
+        size_t const size = 1 + (size_t)rand() % B58ENC_MAX_SIZE;
+        size_t const zeros = (size_t)rand() % 4 == 0 ? (size_t)rand() % size : 0;
+        for (size_t i = 0; i < size; i++) in[i] = i < zeros ? 0 : (uint8_t)rand();
+        check_decode(in, size);
+    }
+
+    uint8_t out[4];
+    if (b58dec(out, sizeof(out), "0", 1) || b58dec(out, sizeof(out), "7YXq9H", 6)) {
+        failures++;
+        printf("FAIL accepted a bad character or a number that doesn't fit\n");
+    }
+}
+
+static double seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static volatile char sink;
+
+static void benchmark(size_t const size) {
+    enum { ROUNDS = 200000 };
+    uint8_t in[64];
+    char out[128];
+    for (size_t i = 0; i < size; i++) in[i] = (uint8_t)(i * 37 + 11);
+
+    double start = seconds();
+    for (unsigned n = 0; n < ROUNDS; n++) {
+        size_t out_size = sizeof(out);
+        in[size - 1] = (uint8_t)n;
+        reference_b58enc(out, &out_size, in, size);
+        sink = out[0];
+    }
+    double const reference_ns = (seconds() - start) / ROUNDS * 1e9;
+
+    start = seconds();
+    for (unsigned n = 0; n < ROUNDS; n++) {
+        size_t out_size = sizeof(out);
+        in[size - 1] = (uint8_t)n;
+        switch (size) {
+            case 27: b58enc_27(out, &out_size, in); break;
+            case 32: b58enc_32(out, &out_size, in); break;
+            case 38: b58enc_38(out, &out_size, in); break;
+            default: b58enc(out, &out_size, in, size); break;
+        }
+        sink = out[0];
+    }
+    double const limb_ns = (seconds() - start) / ROUNDS * 1e9;
+
+    printf("%2zu bytes: %8.1f ns byte-wise, %8.1f ns limbs (%.1fx)\n",
+           size, reference_ns, limb_ns, reference_ns / limb_ns);
+}
+
+int main(void) {
+    differential_tests();
+    decode_tests();
+    if (failures != 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("Differential tests passed\n");
+
+    benchmark(11); // Chain IDs
+    benchmark(27);
+    benchmark(32);
+    benchmark(38);
+    return 0;
+}
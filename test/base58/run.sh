@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+# Builds the base58 encoder for the host and checks it against the previous implementation, then benchmarks both.
+set -Eeuo pipefail
+
+root="$(git rev-parse --show-toplevel)"
+out="$(mktemp -d)"
+trap 'rm -rf "$out"' EXIT
+
+"${CC:-cc}" -std=gnu11 -O2 -Wall -Wextra -I"$root/src" \
+    "$root/test/base58/base58_test.c" "$root/src/base58.c" -o "$out/base58_test"
+"$out/base58_test"
@@ -0,0 +1,135 @@
+// Differential test of the decimal formatter against the digit-by-digit formatting it replaced in src/to_string.c.
+// Build and run with test/decimal/run.sh; pass `full` to it to cover every 32-bit number instead of those below 10^8.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decimal.h"
+
+// The previous formatting, as it was in src/to_string.c.
+#define MAX_INT_DIGITS 20
+#define TEZ_SCALE 1000000
+#define DECIMAL_DIGITS 6
+
+static size_t convert_number(char dest[MAX_INT_DIGITS], uint64_t number, bool leading_zeroes) {
+    char *const end = dest + MAX_INT_DIGITS;
+    for (char *ptr = end - 1; ptr >= dest; ptr--) {
+        *ptr = '0' + number % 10;
+        number /= 10;
+        if (!leading_zeroes && number == 0) {
+            return ptr - dest;
+        }
+    }
+    return 0;
+}
+
+static size_t reference_number_to_string(char *const dest, uint64_t number) {
+    char tmp[MAX_INT_DIGITS];
+    size_t off = convert_number(tmp, number, false);
+    size_t length = sizeof(tmp) - off;
+    memcpy(dest, tmp + off, length);
+    dest[length] = '\0';
+    return length;
+}
+
+static size_t reference_microtez_to_string(char *const dest, uint64_t number) {
+    uint64_t whole_tez = number / TEZ_SCALE;
+    uint64_t fractional = number % TEZ_SCALE;
+    size_t off = reference_number_to_string(dest, whole_tez);
+    if (fractional == 0) {
+        return off;
+    }
+    dest[off++] = '.';
+
+    char tmp[MAX_INT_DIGITS];
+    convert_number(tmp, number, true);
+
+    char *start = tmp + MAX_INT_DIGITS - DECIMAL_DIGITS;
+    char *end;
+    for (end = tmp + MAX_INT_DIGITS - 1; end >= start; end--) {
+        if (*end != '0') {
+            end++;
+            break;
+        }
+    }
+
+    size_t length = end - start;
+    memcpy(dest + off, start, length);
+    off += length;
+    dest[off] = '\0';
+    return off;
+}
+
+static unsigned long long checked;
+static unsigned failures;
+
+static void check(uint64_t const number) {
+    char expected[DECIMAL_MAX_LENGTH + 1], actual[DECIMAL_MAX_LENGTH + 8];
+    checked++;
+
+    memset(actual, 'x', sizeof(actual));
+    size_t expected_length = reference_number_to_string(expected, number);
+    size_t actual_length = decimal_to_string(actual, number, 0);
+    if (expected_length != actual_length || strcmp(expected, actual) != 0 || actual[DECIMAL_MAX_LENGTH] != 'x') {
+        if (failures++ < 20) printf("FAIL %llu: expected %s, got %s\n", (unsigned long long)number, expected, actual);
+    }
+
+    memset(actual, 'x', sizeof(actual));
+    expected_length = reference_microtez_to_string(expected, number);
+    actual_length = decimal_to_string(actual, number, DECIMAL_DIGITS);
+    if (expected_length != actual_length || strcmp(expected, actual) != 0 || actual[DECIMAL_MAX_LENGTH + 1] != 'x') {
+        if (failures++ < 20) printf("FAIL %llu mutez: expected %s, got %s\n", (unsigned long long)number, expected, actual);
+    }
+}
+
+static void check_around(uint64_t const number) {
+    for (uint64_t delta = 0; delta <= 1000; delta++) {
+        check(number + delta);
+        check(number - delta);
+    }
+}
+
+int main(int argc, char **argv) {
+    bool const full = argc > 1 && strcmp(argv[1], "full") == 0;
+
+    // Every number up to the limit, which covers every value of a chunk below it
+    uint64_t const limit = full ? (uint64_t)UINT32_MAX + 1 : 100000000;
+    for (uint64_t number = 0; number < limit; number++) check(number);
+
+    // Around every power of two and ten, which covers the ends of every chunk and of the 32-bit fast path
+    for (unsigned bit = 0; bit < 64; bit++) check_around((uint64_t)1 << bit);
+    check_around(0);
+    for (uint64_t power = 1; power <= UINT64_MAX / 10; power *= 10) {
+        check_around(power * 10);
+        for (uint64_t digit = 2; digit <= 9 && power <= UINT64_MAX / 10 / digit; digit++) check(power * 10 * digit);
+    }
+
+    // Every number with two nonzero digits, which puts zeroes inside and around every chunk
+    for (uint64_t high = 1; high <= UINT64_MAX / 10; high *= 10) {
+        for (uint64_t low = 1; low < high; low *= 10) {
+            for (uint64_t a = 1; a <= 9 && high <= UINT64_MAX / a; a++) {
+                for (uint64_t b = 1; b <= 9; b++) {
+                    if (high * a <= UINT64_MAX - low * b) check(high * a + low * b);
+                }
+            }
+        }
+    }
+
+    // Random numbers of every bit length
+    srand(1);
+    for (unsigned n = 0; n < 10000000; n++) {
+        uint64_t const number = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand() ^
+                                ((uint64_t)rand() << 62);
+        check(number >> (n % 64));
+    }
+
+    if (failures != 0) {
+        printf("%u failures in %llu numbers\n", failures, checked);
+        return 1;
+    }
+    printf("%llu numbers formatted as the previous implementation did\n", checked);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+# Builds the decimal formatter for the host and checks it against the previous implementation.
+# Pass `full` to check every 32-bit number, which takes several minutes.
+set -Eeuo pipefail
+
+root="$(git rev-parse --show-toplevel)"
+out="$(mktemp -d)"
+trap 'rm -rf "$out"' EXIT
+
+"${CC:-cc}" -std=gnu11 -O2 -Wall -Wextra -I"$root/src" \
+    "$root/test/decimal/decimal_test.c" "$root/src/decimal.c" -o "$out/decimal_test"
+"$out/decimal_test" "$@"
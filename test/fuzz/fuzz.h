@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// libFuzzer's interface, which main.c calls the way libFuzzer does when the target is built without it.
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(uint8_t const *data, size_t size);
+
+// Whether the parser accepted the last input. main.c mutates those further.
+bool fuzz_input_accepted(void);
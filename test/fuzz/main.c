@@ -0,0 +1,236 @@
+// Standalone driver for fuzz targets, for when they aren't built with libFuzzer: under AFL, or with a compiler that
+// has no libFuzzer. It takes libFuzzer's options, so that the same command works with either build.
+//
+// Inputs are files, the files in directories, or stdin if none are given, which is how AFL runs targets without @@.
+// Each is run once. With -runs or -max_total_time, inputs are then mutated and run: random edits, splices and
+// changes to the bytes of numbers and lengths. Mutants the target accepts are kept to mutate further, since there
+// is no coverage to guide the search.
+
+#include "fuzz.h"
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define DEFAULT_MAX_LEN 4096
+#define MAX_POOL 4096
+#define MAX_MUTATIONS 4
+
+struct input {
+    uint8_t *data;
+    size_t size;
+};
+
+static struct {
+    struct input inputs[MAX_POOL];
+    size_t count;
+} pool;
+
+static struct {
+    long long runs; // Mutants to run, -1 for no limit
+    long long max_total_time; // Seconds, 0 for no limit
+    uint64_t seed;
+    size_t max_len;
+} options = {
+    .runs = -1,
+    .max_len = DEFAULT_MAX_LEN,
+};
+
+static size_t min_size(size_t const a, size_t const b) {
+    return a < b ? a : b;
+}
+
+static size_t max_size(size_t const a, size_t const b) {
+    return a > b ? a : b;
+}
+
+__attribute__((noreturn))
+static void die(char const *const what, char const *const detail) {
+    fprintf(stderr, "parse-fuzz: %s%s%s\n", what, detail == NULL ? "" : ": ", detail == NULL ? "" : detail);
+    exit(EXIT_FAILURE);
+}
+
+static void add_input(uint8_t const *const data, size_t const size) {
+    if (pool.count == MAX_POOL) return;
+    struct input *const input = &pool.inputs[pool.count];
+    input->data = malloc(size == 0 ? 1 : size);
+    if (input->data == NULL) die("out of memory", NULL);
+    memcpy(input->data, data, size);
+    input->size = size;
+    pool.count++;
+}
+
+static void load_stream(FILE *const file, char const *const name) {
+    static uint8_t buffer[1 << 20];
+    size_t const size = fread(buffer, 1, sizeof(buffer), file);
+    if (ferror(file)) die("can't read", name);
+    add_input(buffer, min_size(size, options.max_len));
+}
+
+static void load_file(char const *const path) {
+    FILE *const file = fopen(path, "rb");
+    if (file == NULL) die("can't open", path);
+    load_stream(file, path);
+    fclose(file);
+}
+
+static void load(char const *const path) {
+    struct stat status;
+    if (stat(path, &status) != 0) die("can't find", path);
+    if (!S_ISDIR(status.st_mode)) {
+        load_file(path);
+        return;
+    }
+
+    DIR *const directory = opendir(path);
+    if (directory == NULL) die("can't open", path);
+    struct dirent const *entry;
+    while ((entry = readdir(directory)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char file[4096];
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        if (stat(file, &status) == 0 && S_ISREG(status.st_mode)) load_file(file);
+    }
+    closedir(directory);
+}
+
+// xorshift64*
+static uint64_t random_state;
+
+static uint64_t next_random(void) {
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return random_state * 0x2545F4914F6CDD1Dull;
+}
+
+static size_t below(size_t const n) {
+    return n == 0 ? 0 : next_random() % n;
+}
+
+// Values that sit on the boundaries of the encoding: presence bytes, tags, continuation bits and small lengths.
+static uint8_t const interesting_bytes[] = {0x00, 0x01, 0x02, 0x03, 0x05, 0x0a, 0x1f, 0x20, 0x40, 0x7f, 0x80, 0xff};
+
+static size_t mutate(uint8_t *const data, size_t size, size_t const capacity) {
+    size_t const mutations = 1 + below(MAX_MUTATIONS);
+    for (size_t m = 0; m < mutations; m++) {
+        switch (below(8)) {
+            case 0: // Flip a bit
+                if (size > 0) data[below(size)] ^= 1 << below(8);
+                break;
+            case 1: // A random byte
+                if (size > 0) data[below(size)] = next_random();
+                break;
+            case 2: // An interesting byte
+                if (size > 0) data[below(size)] = interesting_bytes[below(sizeof(interesting_bytes))];
+                break;
+            case 3: { // Insert bytes
+                size_t const at = below(size + 1);
+                size_t const count = min_size(1 + below(8), capacity - size);
+                memmove(data + at + count, data + at, size - at);
+                for (size_t i = 0; i < count; i++) data[at + i] = next_random();
+                size += count;
+                break;
+            }
+            case 4: { // Delete bytes
+                if (size == 0) break;
+                size_t const at = below(size);
+                size_t const count = min_size(1 + below(8), size - at);
+                memmove(data + at, data + at + count, size - at - count);
+                size -= count;
+                break;
+            }
+            case 5: { // A 4-byte big-endian length near the one there, or a small one
+                if (size < 4) break;
+                size_t const at = below(size - 3);
+                uint32_t value = (uint32_t)data[at] << 24 | data[at + 1] << 16 | data[at + 2] << 8 | data[at + 3];
+                value = below(2) ? value + (uint32_t)below(9) - 4 : (uint32_t)below(64);
+                data[at] = value >> 24;
+                data[at + 1] = value >> 16;
+                data[at + 2] = value >> 8;
+                data[at + 3] = value;
+                break;
+            }
+            case 6: { // Splice in part of another input
+                struct input const *const other = &pool.inputs[below(pool.count)];
+                if (other->size == 0 || size == 0) break;
+                size_t const from = below(other->size);
+                size_t const at = below(size);
+                size_t const count = min_size(1 + below(other->size - from), capacity - at);
+                memcpy(data + at, other->data + from, count);
+                size = max_size(size, at + count);
+                break;
+            }
+            case 7: // Another key, or another way to split the message
+                if (size >= 2) data[below(2)] = next_random();
+                break;
+        }
+    }
+    return size;
+}
+
+static void parse_options(int const argc, char **const argv, int *const first_path) {
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        char *end;
+        char const *const value = strchr(argv[i], '=');
+        if (value == NULL) die("unknown option", argv[i]);
+        long long const number = strtoll(value + 1, &end, 10);
+        if (*end != '\0' || number < 0) die("not a number", argv[i]);
+
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            options.runs = number;
+        } else if (strncmp(argv[i], "-max_total_time=", 16) == 0) {
+            options.max_total_time = number;
+        } else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            options.seed = number;
+        } else if (strncmp(argv[i], "-max_len=", 9) == 0) {
+            options.max_len = number;
+        } else {
+            die("unknown option", argv[i]);
+        }
+    }
+    *first_path = i;
+}
+
+int main(int argc, char **argv) {
+    int first_path;
+    parse_options(argc, argv, &first_path);
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    if (first_path == argc || (first_path + 1 == argc && strcmp(argv[first_path], "-") == 0)) {
+        load_stream(stdin, "stdin");
+    } else {
+        for (int i = first_path; i < argc; i++) load(argv[i]);
+    }
+
+    size_t const seeds = pool.count;
+    for (size_t i = 0; i < seeds; i++) LLVMFuzzerTestOneInput(pool.inputs[i].data, pool.inputs[i].size);
+    if (options.runs < 0 && options.max_total_time == 0) return EXIT_SUCCESS;
+    if (seeds == 0) die("no inputs to mutate", NULL);
+
+    if (options.seed == 0) options.seed = time(NULL);
+    random_state = options.seed;
+    fprintf(stderr, "parse-fuzz: mutating %zu inputs with -seed=%" PRIu64 "\n", seeds, options.seed);
+
+    uint8_t *const buffer = malloc(options.max_len);
+    if (buffer == NULL) die("out of memory", NULL);
+    time_t const end = time(NULL) + options.max_total_time;
+    for (long long run = 0; options.runs < 0 || run < options.runs; run++) {
+        if (options.max_total_time != 0 && run % 1024 == 0 && time(NULL) >= end) break;
+
+        struct input const *const input = &pool.inputs[below(pool.count)];
+        size_t size = min_size(input->size, options.max_len);
+        memcpy(buffer, input->data, size);
+        size = mutate(buffer, size, options.max_len);
+
+        LLVMFuzzerTestOneInput(buffer, size);
+        if (fuzz_input_accepted()) add_input(buffer, size);
+    }
+    free(buffer);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,326 @@
+// Fuzz target for the wallet's operation parser, for libFuzzer, AFL or the standalone driver in main.c.
+//
+// An input is a byte that picks the signing key, a byte that seeds how the message is split into packets, and the
+// message. The message is parsed as the wallet parses it, through parse_operations_init, parse_operations_packet on
+// each packet and parse_operations_final; then again in a single packet, which has to end the same way. Each
+// accepted message is decoded by the reference decoder in reference.c, and the run aborts with a report when the
+// reference doesn't take it, or when what it decodes differs from what the parser extracted. Fields the parser
+// marked ready after a packet, which the wallet shows while the rest arrives, must not have changed by the end.
+//
+// A summary of the run, with the parser's throughput in bytes per second, is printed when the process exits.
+
+#include "fuzz.h"
+
+#include "globals.h"
+#include "keys.h"
+#include "operations.h"
+#include "reference.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef BAKING_APP
+#   error "The baking app parses operations in a single call; this drives the wallet's packet parser"
+#endif
+
+#define G global.apdu.u.sign
+
+#define INPUT_HEADER_SIZE 2 // Key, split seed
+#define MAX_PACKETS 512
+#define DEPOSITS_LIMIT_FIELD 5 // After the source and the manager fields
+
+static bip32_path_t const signer_path = {
+    .length = 4,
+    .components = { 44 | BIP32_HARDENED_BIT, 1729 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT },
+};
+
+// Every curve the host build derives keys on; it has no BIP32-Ed25519.
+static derivation_type_t const derivation_types[] = {
+    DERIVATION_TYPE_ED25519,
+    DERIVATION_TYPE_SECP256K1,
+    DERIVATION_TYPE_SECP256R1,
+};
+
+static struct reference_signer signers[NUM_ELEMENTS(derivation_types)];
+
+static bool last_accepted;
+
+static struct {
+    uint64_t inputs;
+    uint64_t accepted;
+    uint64_t reference_only; // Taken by the reference, rejected by the parser
+    uint64_t bytes; // Message bytes through the parser
+    uint64_t parse_ns; // Spent in the parser
+    uint64_t start_ns;
+} stats;
+
+static uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static void print_stats(void) {
+    double const parse_s = stats.parse_ns / 1e9;
+    double const total_s = (now_ns() - stats.start_ns) / 1e9;
+    fprintf(stderr,
+            "parse-fuzz: %" PRIu64 " inputs, %" PRIu64 " accepted, %" PRIu64 " taken by the reference only\n"
+            "parse-fuzz: %" PRIu64 " bytes parsed in %.3f s: %.0f bytes/s in the parser, %.0f inputs/s overall\n",
+            stats.inputs, stats.accepted, stats.reference_only, stats.bytes, parse_s,
+            parse_s > 0 ? stats.bytes / parse_s : 0, total_s > 0 ? stats.inputs / total_s : 0);
+}
+
+static bool is_operation_allowed(enum operation_kind const kind) {
+    return kind != OPERATION_KIND_NONE; // As the wallet has it
+}
+
+int LLVMFuzzerInitialize(int *const argc, char ***const argv) {
+    (void)argc;
+    (void)argv;
+    init_globals();
+
+    // The reference checks sources and reveals against the keys the app derives; keys_test checks those.
+    for (size_t i = 0; i < NUM_ELEMENTS(derivation_types); i++) {
+        struct parsed_operation_group out;
+        parse_operations_init(&out, derivation_types[i], &signer_path, &G.parse_state);
+        signers[i].contract = *parsed_operations_signer(&G.parse_state, &out);
+        memcpy(signers[i].public_key, out.public_key.bytes, out.public_key.length);
+        signers[i].public_key_length = out.public_key.length;
+    }
+
+    stats.start_ns = now_ns();
+    atexit(print_stats);
+    return 0;
+}
+
+__attribute__((noreturn, format(printf, 3, 4)))
+static void report(uint8_t const *const data, size_t const size, char const *const format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "parse-fuzz: ");
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\nparse-fuzz: input ");
+    for (size_t i = 0; i < size; i++) fprintf(stderr, "%02x", data[i]);
+    fprintf(stderr, "\n");
+    abort();
+}
+
+// Packet sizes from a seed: mostly as large as APDUs get, with runs of small ones. Seed 0 is a single packet.
+static size_t split(size_t *const sizes, size_t const length, uint8_t const seed) {
+    if (seed == 0) {
+        sizes[0] = length;
+        return 1;
+    }
+    uint32_t state = 0x9E3779B9u * seed;
+    size_t count = 0;
+    for (size_t done = 0; done < length; done += sizes[count++]) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        size_t const size = 1 + (state % 4 == 0 ? (state >> 8) % 8 : (state >> 8) % MAX_APDU_SIZE);
+        sizes[count] = count == MAX_PACKETS - 1 ? length - done : MIN(size, length - done);
+    }
+    return count;
+}
+
+// Where the parser keeps a schema field, and how large it is; 0 for fields without a target.
+static size_t field_size(struct operation_field const *const field) {
+    if (field->target == OPERATION_FIELD_NO_TARGET) return 0;
+    switch (field->type) {
+        case OPERATION_FIELD_IMPLICIT:
+        case OPERATION_FIELD_CONTRACT: return sizeof(parsed_contract_t);
+        case OPERATION_FIELD_ZARITH: return sizeof(uint64_t);
+        case OPERATION_FIELD_INT32: return sizeof(uint32_t);
+        case OPERATION_FIELD_PROTOCOL_HASH:
+        case OPERATION_FIELD_PROTOCOL_HASHES: return PROTOCOL_HASH_SIZE;
+        case OPERATION_FIELD_BALLOT: return sizeof(enum ballot_vote);
+        case OPERATION_FIELD_SCRIPT: return SIGN_HASH_SIZE;
+        default: return 0;
+    }
+}
+
+// Parses `message` in packets of `sizes`, as apdu_sign.c does. `previews` gets what the parser had after each
+// packet but the last.
+static bool parse(
+    struct parsed_operation_group *const out, struct parsed_operation_group *const previews,
+    uint8_t const *const message, size_t const *const sizes, size_t const count, derivation_type_t const derivation_type
+) {
+    uint64_t const start = now_ns();
+    parse_operations_init(out, derivation_type, &signer_path, &G.parse_state);
+    bool parsed = true;
+    size_t offset = 0;
+    for (size_t i = 0; i < count && parsed; i++) {
+        parsed = parse_operations_packet(out, message + offset, sizes[i], is_operation_allowed);
+        offset += sizes[i];
+        if (previews != NULL && i + 1 < count) previews[i] = *out;
+    }
+    parsed = parsed && parse_operations_final(&G.parse_state, out);
+    stats.parse_ns += now_ns() - start;
+    stats.bytes += offset;
+    return parsed;
+}
+
+#define CHECK_FIELD(name, field) \
+    if (memcmp(&parsed->field, &expected->field, sizeof(parsed->field)) != 0) { \
+        report(data, size, "%s differs from the reference", name); \
+    }
+
+static void check_contract(
+    uint8_t const *const data, size_t const size, char const *const name,
+    parsed_contract_t const *const parsed, parsed_contract_t const *const expected
+) {
+    if (parsed->originated != expected->originated || parsed->signature_type != expected->signature_type ||
+        memcmp(parsed->hash, expected->hash, sizeof(parsed->hash)) != 0) {
+        report(data, size, "%s is %s %d %02x%02x..., the reference has %s %d %02x%02x...", name,
+               parsed->originated ? "originated" : "implicit", parsed->signature_type, parsed->hash[0], parsed->hash[1],
+               expected->originated ? "originated" : "implicit", expected->signature_type, expected->hash[0],
+               expected->hash[1]);
+    }
+}
+
+static void check_against_reference(
+    uint8_t const *const data, size_t const size, struct parsed_operation_group const *const group,
+    struct reference_group const *const reference
+) {
+    struct parsed_operation const *const parsed = &group->operation;
+    struct reference_operation const *const expected = &reference->operation;
+
+    if (group->total_fee != reference->total_fee) report(data, size, "total fee differs from the reference");
+    if (group->total_storage_limit != reference->total_storage_limit) {
+        report(data, size, "total storage limit differs from the reference");
+    }
+    if (group->has_reveal != reference->has_reveal) report(data, size, "has_reveal differs from the reference");
+    CHECK_FIELD("operation tag", tag);
+    CHECK_FIELD("operation kind", kind);
+    if (parsed->kind == OPERATION_KIND_NONE) return;
+
+    CHECK_FIELD("manager.tz flag", is_manager_tz_operation);
+    switch (parsed->kind) {
+        case OPERATION_KIND_PROPOSAL:
+            check_contract(data, size, "source", &parsed->source, &expected->source);
+            if (parsed->proposal.voting_period != expected->voting_period) report(data, size, "voting period differs");
+            if (memcmp(parsed->proposal.protocol_hash, expected->protocol_hash, PROTOCOL_HASH_SIZE) != 0) {
+                report(data, size, "proposal differs from the reference");
+            }
+            break;
+
+        case OPERATION_KIND_BALLOT:
+            check_contract(data, size, "source", &parsed->source, &expected->source);
+            if (parsed->ballot.voting_period != expected->voting_period) report(data, size, "voting period differs");
+            if (memcmp(parsed->ballot.protocol_hash, expected->protocol_hash, PROTOCOL_HASH_SIZE) != 0) {
+                report(data, size, "ballot proposal differs from the reference");
+            }
+            if (parsed->ballot.vote != expected->vote) report(data, size, "vote differs from the reference");
+            break;
+
+        case OPERATION_KIND_ORIGINATION:
+            check_contract(data, size, "source", &parsed->source, &expected->source);
+            check_contract(data, size, "delegate", &parsed->delegate, &expected->delegate);
+            CHECK_FIELD("balance", amount);
+            if (memcmp(parsed->script_hash, expected->script_hash, SIGN_HASH_SIZE) != 0) {
+                report(data, size, "script hash differs from the reference");
+            }
+            break;
+
+        case OPERATION_KIND_SET_DEPOSITS_LIMIT:
+            check_contract(data, size, "source", &parsed->source, &expected->source);
+            CHECK_FIELD("limit", amount);
+            if (!(parsed->absent_fields & 1 << DEPOSITS_LIMIT_FIELD) != !expected->amount_absent) {
+                report(data, size, "presence of the limit differs from the reference");
+            }
+            break;
+
+        default: // Transactions and delegations, which manager.tz calls may also be
+            check_contract(data, size, "source", &parsed->source, &expected->source);
+            check_contract(data, size, "destination", &parsed->destination, &expected->destination);
+            CHECK_FIELD("amount", amount);
+            if (parsed->kind == OPERATION_KIND_TRANSACTION && strcmp(parsed->entrypoint, expected->entrypoint) != 0) {
+                report(data, size, "entrypoint is \"%s\", the reference has \"%s\"", parsed->entrypoint,
+                       expected->entrypoint);
+            }
+            if (parsed->is_manager_tz_operation) {
+                check_contract(data, size, "implicit account", &parsed->implicit_account, &expected->implicit_account);
+            }
+            break;
+    }
+}
+
+// Fields marked ready in a preview have to be final.
+static void check_previews(
+    uint8_t const *const data, size_t const size, struct parsed_operation_group const *const previews,
+    size_t const count, struct parsed_operation_group const *const out
+) {
+    struct operation_schema const *const schema = find_operation_schema(out->operation.tag);
+    for (size_t i = 0; i < count; i++) {
+        uint16_t const ready = previews[i].operation.ready_fields;
+        if (ready == 0) continue;
+        if (previews[i].operation.tag != out->operation.tag || schema == NULL) {
+            report(data, size, "fields were ready after packet %zu before the operation was known", i + 1);
+        }
+        for (size_t field = 0; schema->fields[field].type != OPERATION_FIELD_END; field++) {
+            size_t const field_size_ = field_size(&schema->fields[field]);
+            if (!(ready & 1 << field) || field_size_ == 0) continue;
+            uint16_t const target = schema->fields[field].target;
+            if (memcmp((uint8_t const *)&previews[i] + target, (uint8_t const *)out + target, field_size_) != 0) {
+                report(data, size, "field %zu changed after it was shown as ready after packet %zu", field, i + 1);
+            }
+        }
+        if ((ready & ~out->operation.ready_fields) != 0) {
+            report(data, size, "fields ready after packet %zu are no longer ready at the end", i + 1);
+        }
+    }
+}
+
+int LLVMFuzzerTestOneInput(uint8_t const *const data, size_t const size) {
+    last_accepted = false;
+    if (size < INPUT_HEADER_SIZE) return 0;
+    size_t const key = data[0] % NUM_ELEMENTS(derivation_types);
+    uint8_t const *const message = data + INPUT_HEADER_SIZE;
+    size_t const length = size - INPUT_HEADER_SIZE;
+    stats.inputs++;
+
+    static size_t sizes[MAX_PACKETS];
+    static struct parsed_operation_group previews[MAX_PACKETS];
+    size_t const count = split(sizes, length, data[1]);
+
+    static struct parsed_operation_group out, whole;
+    bool const parsed = parse(&out, previews, message, sizes, count, derivation_types[key]);
+    if (count > 1) {
+        bool const parsed_whole = parse(&whole, NULL, message, &length, 1, derivation_types[key]);
+        if (parsed_whole != parsed) {
+            report(data, size, "%s in %zu packets, %s in one", parsed ? "accepted" : "rejected", count,
+                   parsed_whole ? "accepted" : "rejected");
+        }
+        if (parsed && memcmp(&whole, &out, sizeof(out)) != 0) {
+            report(data, size, "group parsed in %zu packets differs from the one parsed in one", count);
+        }
+    }
+
+    struct reference_group reference;
+    char const *reason = NULL;
+    enum reference_result const result = reference_decode(&reference, &reason, message, length, &signers[key]);
+
+    if (!parsed) {
+        if (result == REFERENCE_OK) stats.reference_only++;
+        return 0;
+    }
+    stats.accepted++;
+    last_accepted = true;
+
+    if (result != REFERENCE_OK) {
+        report(data, size, "parser accepted a message the reference finds %s: %s",
+               result == REFERENCE_INVALID ? "invalid" : "unsupported", reason);
+    }
+    check_against_reference(data, size, &out, &reference);
+    if (count > 1) check_previews(data, size, previews, count - 1, &out);
+    return 0;
+}
+
+bool fuzz_input_accepted(void) {
+    return last_accepted;
+}
@@ -0,0 +1,705 @@
+#include "reference.h"
+
+#include "cx.h"
+
+#include <openssl/sha.h>
+
+#include <string.h>
+
+// Michelson primitives that manager.tz calls are made of, from the protocol's table of primitives.
+enum {
+    PRIM_CONS = 0x1B,
+    PRIM_IMPLICIT_ACCOUNT = 0x1E,
+    PRIM_DROP = 0x20,
+    PRIM_FAILWITH = 0x27,
+    PRIM_IF_NONE = 0x2F,
+    PRIM_NIL = 0x3D,
+    PRIM_NONE = 0x3E,
+    PRIM_PUSH = 0x43,
+    PRIM_SOME = 0x46,
+    PRIM_TRANSFER_TOKENS = 0x4D,
+    PRIM_SET_DELEGATE = 0x4E,
+    PRIM_UNIT = 0x4F,
+    PRIM_CONTRACT = 0x55,
+    PRIM_KEY_HASH = 0x5D,
+    PRIM_MUTEZ = 0x6A,
+    PRIM_UNIT_TYPE = 0x6C,
+    PRIM_OPERATION = 0x6D,
+    PRIM_ADDRESS = 0x6E,
+};
+
+// Micheline node tags
+enum {
+    NODE_INT = 0,
+    NODE_STRING = 1,
+    NODE_SEQUENCE = 2,
+    NODE_PRIM = 3, // No arguments, no annotations
+    NODE_PRIM_ANNOTATED = 4,
+    NODE_PRIM_1 = 5, // One argument
+    NODE_PRIM_1_ANNOTATED = 6,
+    NODE_PRIM_2 = 7, // Two arguments
+    NODE_PRIM_2_ANNOTATED = 8,
+    NODE_PRIM_GENERIC = 9, // Any number of arguments, annotations
+    NODE_BYTES = 10,
+};
+
+#define MAX_NODES 64
+#define MAX_DEPTH 16
+#define MAX_MANAGER_TZ_SIZE 200 // Longest manager.tz call the wallet takes
+#define PROPOSAL_HASHES_MAX 20
+
+struct reader {
+    uint8_t const *data;
+    size_t length;
+    size_t offset;
+    enum reference_result result;
+    char const *reason;
+};
+
+// The encoding can't be read any further.
+static bool invalid(struct reader *const r, char const *const reason) {
+    if (r->result != REFERENCE_INVALID) {
+        r->result = REFERENCE_INVALID;
+        r->reason = reason;
+    }
+    return false;
+}
+
+// The wallet doesn't sign this, but the rest of the group is still read: it may turn out not to be valid at all.
+static void unsupported(struct reader *const r, char const *const reason) {
+    if (r->result == REFERENCE_OK) {
+        r->result = REFERENCE_UNSUPPORTED;
+        r->reason = reason;
+    }
+}
+
+static bool read_bytes(struct reader *const r, void *const out, size_t const size) {
+    if (size > r->length - r->offset) return invalid(r, "truncated");
+    if (out != NULL) memcpy(out, r->data + r->offset, size);
+    r->offset += size;
+    return true;
+}
+
+static bool read_u8(struct reader *const r, uint8_t *const out) {
+    return read_bytes(r, out, 1);
+}
+
+static bool read_u32(struct reader *const r, uint32_t *const out) {
+    uint8_t bytes[4];
+    if (!read_bytes(r, bytes, sizeof(bytes))) return false;
+    *out = (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
+    return true;
+}
+
+// A 4-byte length, then that many bytes, which have to be in the message.
+static bool read_sized(struct reader *const r, uint8_t const **const out, uint32_t *const size) {
+    if (!read_u32(r, size)) return false;
+    *out = r->data + r->offset;
+    return read_bytes(r, NULL, *size);
+}
+
+// Variable-length integers, in 7-bit groups from the least significant, with the top bit set on all bytes but the
+// last. Integers of Micheline start with a sign bit and 6 bits instead. The last byte of a number can only be 0 if
+// it is the only one.
+static bool read_zarith(
+    struct reader *const r, bool const is_signed, uint64_t *const value, bool *const negative, bool *const too_big
+) {
+    *value = 0;
+    *negative = false;
+    *too_big = false;
+
+    uint8_t byte;
+    if (!read_u8(r, &byte)) return false;
+    unsigned shift = is_signed ? 6 : 7;
+    *value = byte & ((1u << shift) - 1);
+    if (is_signed) *negative = byte & 0x40;
+
+    while (byte & 0x80) {
+        if (!read_u8(r, &byte)) return false;
+        if (byte == 0) return invalid(r, "number with a trailing zero");
+        uint64_t const bits = byte & 0x7F;
+        if (shift >= 64 || (bits << shift) >> shift != bits) {
+            *too_big = true;
+        } else {
+            *value |= bits << shift;
+        }
+        shift += 7;
+    }
+    return true;
+}
+
+static bool read_n(struct reader *const r, uint64_t *const out) {
+    bool negative, too_big;
+    if (!read_zarith(r, false, out, &negative, &too_big)) return false;
+    if (too_big) unsupported(r, "number over 64 bits");
+    return true;
+}
+
+static bool add_total(struct reader *const r, uint64_t *const total, uint64_t const value) {
+    if (__builtin_add_overflow(*total, value, total)) unsupported(r, "total over 64 bits");
+    return true;
+}
+
+// Contracts
+
+static bool decode_implicit(parsed_contract_t *const out, uint8_t const tag, uint8_t const hash[HASH_SIZE]) {
+    static const signature_type_t signature_types[] = {
+        SIGNATURE_TYPE_ED25519, // tz1
+        SIGNATURE_TYPE_SECP256K1, // tz2
+        SIGNATURE_TYPE_SECP256R1, // tz3
+    };
+    if (tag >= sizeof(signature_types) / sizeof(*signature_types)) return false;
+    memset(out, 0, sizeof(*out));
+    out->signature_type = signature_types[tag];
+    memcpy(out->hash, hash, HASH_SIZE);
+    return true;
+}
+
+// 0x00 and an implicit account, or 0x01, the hash of an originated contract and a zero byte.
+static bool decode_contract(parsed_contract_t *const out, uint8_t const bytes[22]) {
+    switch (bytes[0]) {
+        case 0x00:
+            return decode_implicit(out, bytes[1], bytes + 2);
+        case 0x01:
+            if (bytes[21] != 0) return false;
+            memset(out, 0, sizeof(*out));
+            out->originated = 1;
+            out->signature_type = SIGNATURE_TYPE_UNSET;
+            memcpy(out->hash, bytes + 1, HASH_SIZE);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool read_implicit(struct reader *const r, parsed_contract_t *const out) {
+    uint8_t bytes[1 + HASH_SIZE];
+    if (!read_bytes(r, bytes, sizeof(bytes))) return false;
+    if (!decode_implicit(out, bytes[0], bytes + 1)) return invalid(r, "key hash tag");
+    return true;
+}
+
+static bool read_contract(struct reader *const r, parsed_contract_t *const out) {
+    uint8_t bytes[22];
+    if (!read_bytes(r, bytes, sizeof(bytes))) return false;
+    if (!decode_contract(out, bytes)) return invalid(r, "contract");
+    return true;
+}
+
+static bool contracts_equal(parsed_contract_t const *const a, parsed_contract_t const *const b) {
+    return a->originated == b->originated && a->signature_type == b->signature_type &&
+        memcmp(a->hash, b->hash, HASH_SIZE) == 0;
+}
+
+// Base58check, for addresses written as text in Michelson: 36 characters for a 3-byte prefix, a 20-byte hash and
+// a 4-byte checksum.
+
+#define BASE58_ADDRESS_LENGTH 36
+#define BASE58_ADDRESS_DATA_SIZE 27
+
+static bool base58check_decode(uint8_t out[BASE58_ADDRESS_DATA_SIZE], uint8_t const *const text, size_t const length) {
+    static char const alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    if (length != BASE58_ADDRESS_LENGTH) return false;
+
+    memset(out, 0, BASE58_ADDRESS_DATA_SIZE);
+    for (size_t i = 0; i < length; i++) {
+        char const *const digit = text[i] == '\0' ? NULL : strchr(alphabet, text[i]);
+        if (digit == NULL) return false;
+        unsigned carry = digit - alphabet;
+        for (size_t j = BASE58_ADDRESS_DATA_SIZE; j-- > 0; ) {
+            carry += 58u * out[j];
+            out[j] = carry & 0xFF;
+            carry >>= 8;
+        }
+        if (carry != 0) return false;
+    }
+
+    // Each leading '1' stands for a leading zero byte, and there are no other leading zero bytes.
+    size_t ones = 0;
+    while (ones < length && text[ones] == '1') ones++;
+    size_t zeros = 0;
+    while (zeros < BASE58_ADDRESS_DATA_SIZE && out[zeros] == 0) zeros++;
+    if (ones != zeros) return false;
+
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256(out, BASE58_ADDRESS_DATA_SIZE - 4, digest);
+    SHA256(digest, sizeof(digest), digest);
+    return memcmp(digest, out + BASE58_ADDRESS_DATA_SIZE - 4, 4) == 0;
+}
+
+static bool decode_base58_address(parsed_contract_t *const out, uint8_t const *const text, size_t const length) {
+    static const uint8_t prefixes[][3] = {
+        {6, 161, 159}, // tz1
+        {6, 161, 161}, // tz2
+        {6, 161, 164}, // tz3
+        {2, 90, 121}, // KT1
+    };
+    uint8_t data[BASE58_ADDRESS_DATA_SIZE];
+    if (!base58check_decode(data, text, length)) return false;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        if (memcmp(data, prefixes[i], 3) == 0) return decode_implicit(out, i, data + 3);
+    }
+    if (memcmp(data, prefixes[3], 3) != 0) return false;
+    memset(out, 0, sizeof(*out));
+    out->originated = 1;
+    memcpy(out->hash, data + 3, HASH_SIZE);
+    return true;
+}
+
+// Micheline
+
+struct node {
+    uint8_t tag;
+    uint8_t prim;
+    struct node *first; // Arguments of primitives, items of sequences
+    struct node *next;
+    uint8_t const *text; // Strings and bytes
+    uint32_t text_length;
+    uint8_t const *annotations;
+    uint32_t annotations_length;
+    uint64_t value; // Integers
+    bool negative;
+    bool too_big;
+};
+
+struct micheline {
+    struct node nodes[MAX_NODES];
+    size_t count;
+};
+
+static bool read_node(struct reader *r, struct micheline *m, unsigned depth, struct node **out);
+
+// Reads nodes up to `size` bytes on, which have to end there.
+static bool read_nodes(
+    struct reader *const r, struct micheline *const m, unsigned const depth, uint32_t const size,
+    struct node **const first
+) {
+    if (size > r->length - r->offset) return invalid(r, "truncated");
+    size_t const length = r->length;
+    r->length = r->offset + size;
+
+    struct node **link = first;
+    *link = NULL;
+    while (r->offset < r->length) {
+        if (!read_node(r, m, depth, link)) return false;
+        link = &(*link)->next;
+    }
+    r->length = length;
+    return true;
+}
+
+static bool read_node(struct reader *const r, struct micheline *const m, unsigned const depth, struct node **const out) {
+    if (depth > MAX_DEPTH || m->count == MAX_NODES) return invalid(r, "Micheline too large");
+    struct node *const node = &m->nodes[m->count++];
+    memset(node, 0, sizeof(*node));
+    *out = node;
+
+    if (!read_u8(r, &node->tag)) return false;
+    switch (node->tag) {
+        case NODE_INT:
+            return read_zarith(r, true, &node->value, &node->negative, &node->too_big);
+        case NODE_STRING:
+        case NODE_BYTES:
+            return read_sized(r, &node->text, &node->text_length);
+        case NODE_SEQUENCE: {
+            uint32_t size;
+            return read_u32(r, &size) && read_nodes(r, m, depth + 1, size, &node->first);
+        }
+        case NODE_PRIM_GENERIC: {
+            uint32_t size;
+            return read_u8(r, &node->prim) && read_u32(r, &size) && read_nodes(r, m, depth + 1, size, &node->first) &&
+                read_sized(r, &node->annotations, &node->annotations_length);
+        }
+        case NODE_PRIM:
+        case NODE_PRIM_ANNOTATED:
+        case NODE_PRIM_1:
+        case NODE_PRIM_1_ANNOTATED:
+        case NODE_PRIM_2:
+        case NODE_PRIM_2_ANNOTATED: {
+            if (!read_u8(r, &node->prim)) return false;
+            struct node **link = &node->first;
+            for (unsigned i = 0; i < (node->tag - NODE_PRIM) / 2u; i++) {
+                if (!read_node(r, m, depth + 1, link)) return false;
+                link = &(*link)->next;
+            }
+            if (node->tag % 2 == 0) return read_sized(r, &node->annotations, &node->annotations_length);
+            return true;
+        }
+        default:
+            return invalid(r, "Micheline node tag");
+    }
+}
+
+static size_t children(struct node const *const node, struct node const **const out, size_t const max) {
+    size_t count = 0;
+    for (struct node const *child = node->first; child != NULL; child = child->next) {
+        if (count < max) out[count] = child;
+        count++;
+    }
+    return count;
+}
+
+// A primitive of the compact form for its number of arguments, without annotations.
+static bool is_prim(struct node const *const node, uint8_t const prim, size_t const arguments) {
+    return node->tag == NODE_PRIM + 2 * arguments && node->prim == prim;
+}
+
+static bool is_sequence(struct node const *const node, size_t const items) {
+    struct node const *ignored[1];
+    return node->tag == NODE_SEQUENCE && children(node, ignored, 0) == items;
+}
+
+// Entrypoint names are made of the characters of annotations.
+static bool is_entrypoint(uint8_t const *const name, size_t const length) {
+    if (length == 0 || length > MAX_ENTRYPOINT_LENGTH) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (strchr("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_.%@", name[i]) == NULL ||
+            name[i] == '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// key_hash: 21 bytes, or the tz1, tz2 or tz3 address.
+static bool key_hash_literal(parsed_contract_t *const out, struct node const *const node) {
+    if (node->tag == NODE_BYTES) {
+        return node->text_length == 1 + HASH_SIZE && decode_implicit(out, node->text[0], node->text + 1);
+    }
+    return node->tag == NODE_STRING && decode_base58_address(out, node->text, node->text_length) && !out->originated;
+}
+
+// address, without an entrypoint: 22 bytes, or the address.
+static bool address_literal(parsed_contract_t *const out, struct node const *const node) {
+    if (node->tag == NODE_BYTES) return node->text_length == 22 && decode_contract(out, node->text);
+    return node->tag == NODE_STRING && decode_base58_address(out, node->text, node->text_length);
+}
+
+// PUSH mutez <amount>
+static bool push_mutez(struct reader *const r, struct reference_operation *const op, struct node const *const node) {
+    struct node const *args[2];
+    if (!is_prim(node, PRIM_PUSH, 2) || children(node, args, 2) != 2 || !is_prim(args[0], PRIM_MUTEZ, 0) ||
+        args[1]->tag != NODE_INT) {
+        return false;
+    }
+    if (args[1]->negative) unsupported(r, "negative amount");
+    if (args[1]->too_big) unsupported(r, "amount over 64 bits");
+    op->amount = args[1]->value;
+    return true;
+}
+
+// The calls that tezos-client makes to the "do" entrypoint of manager.tz, the script of originated accounts:
+//   { DROP ; NIL operation ; <body> ; CONS }
+// where the body is one of
+//   NONE key_hash ; SET_DELEGATE                                          (withdraw delegate)
+//   PUSH key_hash <pkh> ; SOME ; SET_DELEGATE                             (set delegate)
+//   PUSH key_hash <pkh> ; IMPLICIT_ACCOUNT ; PUSH mutez <amount> ; UNIT ; TRANSFER_TOKENS
+//   PUSH address <addr> ; CONTRACT [%entrypoint] unit ; { IF_NONE { { UNIT ; FAILWITH } } {} } ;
+//       PUSH mutez <amount> ; UNIT ; TRANSFER_TOKENS
+static bool manager_tz_call(struct reader *const r, struct reference_operation *const op, struct node const *const root) {
+    struct node const *items[10];
+    size_t const count = children(root, items, 10);
+    struct node const *args[2];
+
+    if (root->tag != NODE_SEQUENCE || count < 5 || count > 10 || !is_prim(items[0], PRIM_DROP, 0) ||
+        !is_prim(items[1], PRIM_NIL, 1) || children(items[1], args, 1) != 1 || !is_prim(args[0], PRIM_OPERATION, 0) ||
+        !is_prim(items[count - 1], PRIM_CONS, 0)) {
+        return false;
+    }
+    struct node const *const *const body = items + 2;
+    size_t const body_count = count - 3;
+
+    if (body_count == 2) {
+        if (!is_prim(body[0], PRIM_NONE, 1) || children(body[0], args, 1) != 1 || !is_prim(args[0], PRIM_KEY_HASH, 0) ||
+            !is_prim(body[1], PRIM_SET_DELEGATE, 0)) {
+            return false;
+        }
+        op->kind = OPERATION_KIND_DELEGATION;
+        memset(&op->destination, 0, sizeof(op->destination));
+        return true;
+    }
+
+    if (!is_prim(body[0], PRIM_PUSH, 2) || children(body[0], args, 2) != 2) return false;
+
+    if (body_count == 3 || body_count == 5) {
+        if (!is_prim(args[0], PRIM_KEY_HASH, 0) || !key_hash_literal(&op->destination, args[1])) return false;
+        if (body_count == 3) {
+            op->kind = OPERATION_KIND_DELEGATION;
+            return is_prim(body[1], PRIM_SOME, 0) && is_prim(body[2], PRIM_SET_DELEGATE, 0);
+        }
+        op->kind = OPERATION_KIND_TRANSACTION;
+        return is_prim(body[1], PRIM_IMPLICIT_ACCOUNT, 0) && push_mutez(r, op, body[2]) &&
+            is_prim(body[3], PRIM_UNIT, 0) && is_prim(body[4], PRIM_TRANSFER_TOKENS, 0);
+    }
+
+    if (body_count != 6) return false;
+    if (!is_prim(args[0], PRIM_ADDRESS, 0) || !address_literal(&op->destination, args[1])) return false;
+
+    struct node const *const contract = body[1];
+    if (contract->prim != PRIM_CONTRACT || children(contract, args, 1) != 1 || !is_prim(args[0], PRIM_UNIT_TYPE, 0)) {
+        return false;
+    }
+    if (contract->tag == NODE_PRIM_1_ANNOTATED) {
+        // A single field annotation, which names the entrypoint
+        if (contract->annotations_length < 2 || contract->annotations[0] != '%' ||
+            !is_entrypoint(contract->annotations + 1, contract->annotations_length - 1)) {
+            return false;
+        }
+        memcpy(op->entrypoint, contract->annotations + 1, contract->annotations_length - 1);
+    } else if (contract->tag != NODE_PRIM_1) {
+        return false;
+    }
+
+    // { IF_NONE { { UNIT ; FAILWITH } } {} }
+    struct node const *if_none, *branches[2], *failure, *failure_items[2];
+    if (!is_sequence(body[2], 1) || (children(body[2], &if_none, 1), !is_prim(if_none, PRIM_IF_NONE, 2)) ||
+        children(if_none, branches, 2) != 2 || !is_sequence(branches[0], 1) || !is_sequence(branches[1], 0) ||
+        (children(branches[0], &failure, 1), !is_sequence(failure, 2)) ||
+        (children(failure, failure_items, 2), !is_prim(failure_items[0], PRIM_UNIT, 0)) ||
+        !is_prim(failure_items[1], PRIM_FAILWITH, 0)) {
+        return false;
+    }
+
+    op->kind = OPERATION_KIND_TRANSACTION;
+    return push_mutez(r, op, body[3]) && is_prim(body[4], PRIM_UNIT, 0) && is_prim(body[5], PRIM_TRANSFER_TOKENS, 0);
+}
+
+static void read_manager_tz_call(
+    struct reader *const r, struct reference_operation *const op, uint8_t const *const parameters, uint32_t const size
+) {
+    if (op->amount != 0) unsupported(r, "manager.tz call with an amount");
+    if (size > MAX_MANAGER_TZ_SIZE) unsupported(r, "manager.tz call too long");
+
+    static struct micheline m;
+    m.count = 0;
+    struct reader expression = {.data = parameters, .length = size};
+    struct node *root;
+    struct reference_operation call = *op;
+    if (!read_node(&expression, &m, 0, &root) || expression.offset != size || !manager_tz_call(r, &call, root)) {
+        unsupported(r, "call to \"do\" that isn't manager.tz");
+        return;
+    }
+
+    call.is_manager_tz_operation = true;
+    call.implicit_account = op->source; // The account manager.tz is the script of acts for the key that signs
+    call.source = op->destination;
+    *op = call;
+}
+
+// Operations
+
+static bool read_source(struct reader *const r, struct reference_operation *const op, bool const contract,
+                        struct reference_signer const *const signer) {
+    if (!(contract ? read_contract(r, &op->source) : read_implicit(r, &op->source))) return false;
+    if (!op->source.originated && !contracts_equal(&op->source, &signer->contract)) {
+        unsupported(r, "source isn't the signer");
+    }
+    return true;
+}
+
+// Fee, counter, gas limit and storage limit
+static bool read_manager_fields(struct reader *const r, struct reference_group *const out) {
+    uint64_t fee, counter, gas_limit, storage_limit;
+    return read_n(r, &fee) && add_total(r, &out->total_fee, fee) && read_n(r, &counter) && read_n(r, &gas_limit) &&
+        read_n(r, &storage_limit) && add_total(r, &out->total_storage_limit, storage_limit);
+}
+
+static bool read_presence(struct reader *const r, bool *const present) {
+    uint8_t byte;
+    if (!read_u8(r, &byte)) return false;
+    if (byte != 0x00 && byte != 0xFF) return invalid(r, "presence byte");
+    *present = byte == 0xFF;
+    return true;
+}
+
+static bool read_public_key(struct reader *const r, struct reference_signer const *const signer) {
+    static const struct {
+        signature_type_t type;
+        size_t size;
+    } keys[] = {
+        {SIGNATURE_TYPE_ED25519, 32},
+        {SIGNATURE_TYPE_SECP256K1, 33},
+        {SIGNATURE_TYPE_SECP256R1, 33},
+    };
+    uint8_t tag, key[33];
+    if (!read_u8(r, &tag)) return false;
+    if (tag >= sizeof(keys) / sizeof(*keys)) return invalid(r, "public key tag");
+    if (!read_bytes(r, key, keys[tag].size)) return false;
+
+    if (keys[tag].type != signer->contract.signature_type || keys[tag].size != signer->public_key_length ||
+        memcmp(key, signer->public_key, keys[tag].size) != 0) {
+        unsupported(r, "reveals a key other than the signer's");
+    }
+    return true;
+}
+
+static bool read_parameters(struct reader *const r, struct reference_operation *const op, bool *const ends_group) {
+    static char const *const standard_entrypoints[] = {"default", "root", "do", "set_delegate", "remove_delegate"};
+    bool present;
+    if (!read_presence(r, &present)) return false;
+    if (!present) return true;
+
+    uint8_t tag;
+    if (!read_u8(r, &tag)) return false;
+    if (tag < sizeof(standard_entrypoints) / sizeof(*standard_entrypoints)) {
+        if (tag != 2) strcpy(op->entrypoint, standard_entrypoints[tag]);
+    } else if (tag == 0xFF) {
+        uint8_t length;
+        if (!read_u8(r, &length)) return false;
+        if (length > MAX_ENTRYPOINT_LENGTH) return invalid(r, "entrypoint name too long");
+        uint8_t const *const name = r->data + r->offset;
+        if (!read_bytes(r, op->entrypoint, length)) return false;
+        if (!is_entrypoint(name, length)) unsupported(r, "entrypoint name");
+    } else {
+        return invalid(r, "entrypoint tag");
+    }
+
+    uint8_t const *parameters;
+    uint32_t size;
+    if (!read_sized(r, &parameters, &size)) return false;
+    if (size == 0) unsupported(r, "empty parameters");
+    if (tag == 2) {
+        read_manager_tz_call(r, op, parameters, size);
+        *ends_group = true; // The app stops reading at the end of the call
+    }
+    return true;
+}
+
+static bool read_script(struct reader *const r, struct reference_operation *const op) {
+    size_t const start = r->offset;
+    uint8_t const *ignored;
+    uint32_t size;
+    if (!read_sized(r, &ignored, &size) || !read_sized(r, &ignored, &size)) return false; // Code, then storage
+
+    cx_blake2b_t hash;
+    cx_blake2b_init(&hash, SIGN_HASH_SIZE * 8);
+    cx_hash((cx_hash_t *)&hash, CX_LAST, r->data + start, r->offset - start, op->script_hash, sizeof(op->script_hash));
+    return true;
+}
+
+// Reads the operation after its tag.
+static bool read_operation(
+    struct reader *const r, struct reference_group *const out, struct reference_operation *const op,
+    struct reference_signer const *const signer, bool *const ends_group
+) {
+    switch (op->tag) {
+        case OPERATION_TAG_PROPOSAL: {
+            op->kind = OPERATION_KIND_PROPOSAL;
+            *ends_group = true;
+            uint8_t const *proposals;
+            uint32_t size;
+            if (!read_source(r, op, false, signer) || !read_u32(r, &op->voting_period) ||
+                !read_sized(r, &proposals, &size)) {
+                return false;
+            }
+            if (size % PROTOCOL_HASH_SIZE != 0 || size > PROPOSAL_HASHES_MAX * PROTOCOL_HASH_SIZE) {
+                return invalid(r, "proposals");
+            }
+            if (size != PROTOCOL_HASH_SIZE) {
+                unsupported(r, "not a single proposal");
+            } else {
+                memcpy(op->protocol_hash, proposals, PROTOCOL_HASH_SIZE);
+            }
+            return true;
+        }
+
+        case OPERATION_TAG_BALLOT: {
+            op->kind = OPERATION_KIND_BALLOT;
+            *ends_group = true;
+            uint8_t vote;
+            if (!read_source(r, op, false, signer) || !read_u32(r, &op->voting_period) ||
+                !read_bytes(r, op->protocol_hash, PROTOCOL_HASH_SIZE) || !read_u8(r, &vote)) {
+                return false;
+            }
+            if (vote > BALLOT_VOTE_PASS) return invalid(r, "ballot");
+            op->vote = vote;
+            return true;
+        }
+
+        // The app reads the operations of Athens with the field encodings of Babylon, but for their sources.
+        case OPERATION_TAG_ATHENS_REVEAL:
+        case OPERATION_TAG_BABYLON_REVEAL:
+            op->kind = OPERATION_KIND_REVEAL;
+            out->has_reveal = true;
+            return read_source(r, op, op->tag == OPERATION_TAG_ATHENS_REVEAL, signer) && read_manager_fields(r, out) &&
+                read_public_key(r, signer);
+
+        case OPERATION_TAG_ATHENS_TRANSACTION:
+        case OPERATION_TAG_BABYLON_TRANSACTION:
+            op->kind = OPERATION_KIND_TRANSACTION;
+            return read_source(r, op, op->tag == OPERATION_TAG_ATHENS_TRANSACTION, signer) &&
+                read_manager_fields(r, out) && read_n(r, &op->amount) && read_contract(r, &op->destination) &&
+                read_parameters(r, op, ends_group);
+
+        case OPERATION_TAG_BABYLON_ORIGINATION: {
+            op->kind = OPERATION_KIND_ORIGINATION;
+            bool present;
+            return read_source(r, op, false, signer) && read_manager_fields(r, out) && read_n(r, &op->amount) &&
+                read_presence(r, &present) && (!present || read_implicit(r, &op->delegate)) && read_script(r, op);
+        }
+
+        case OPERATION_TAG_ATHENS_DELEGATION:
+        case OPERATION_TAG_BABYLON_DELEGATION: {
+            op->kind = OPERATION_KIND_DELEGATION;
+            bool present;
+            return read_source(r, op, op->tag == OPERATION_TAG_ATHENS_DELEGATION, signer) &&
+                read_manager_fields(r, out) && read_presence(r, &present) &&
+                (!present || read_implicit(r, &op->destination));
+        }
+
+        case OPERATION_TAG_ITHACA_SET_DEPOSITS_LIMIT: {
+            op->kind = OPERATION_KIND_SET_DEPOSITS_LIMIT;
+            bool present;
+            if (!read_source(r, op, false, signer) || !read_manager_fields(r, out) || !read_presence(r, &present)) {
+                return false;
+            }
+            op->amount_absent = !present;
+            return !present || read_n(r, &op->amount);
+        }
+
+        default:
+            // Without knowing its fields, the rest of the group can't be read.
+            unsupported(r, "operation the wallet doesn't sign");
+            return false;
+    }
+}
+
+enum reference_result reference_decode(
+    struct reference_group *const out, char const **const reason,
+    uint8_t const *const data, size_t const length, struct reference_signer const *const signer
+) {
+    struct reader r = {.data = data, .length = length};
+    memset(out, 0, sizeof(*out));
+    out->operation.tag = OPERATION_TAG_NONE;
+    out->operation.kind = OPERATION_KIND_NONE;
+
+    uint8_t magic;
+    if (read_u8(&r, &magic) && magic != 0x03) invalid(&r, "magic byte");
+    read_bytes(&r, NULL, 32); // Branch
+
+    size_t count = 0;
+    bool ended = false;
+    while (r.result != REFERENCE_INVALID && r.offset < r.length) {
+        if (ended) unsupported(&r, "operation after one that ends the group");
+
+        uint8_t tag;
+        read_u8(&r, &tag);
+        struct reference_operation op = {.tag = tag};
+        bool ends_group = false;
+        if (!read_operation(&r, out, &op, signer, &ends_group)) break;
+        count++;
+        ended |= ends_group;
+
+        if (op.kind == OPERATION_KIND_REVEAL) continue;
+        if (out->operation.kind != OPERATION_KIND_NONE) {
+            unsupported(&r, "more than one operation besides reveals");
+        } else {
+            out->operation = op;
+        }
+    }
+    if (count == 0 && r.result == REFERENCE_OK) invalid(&r, "no operations");
+
+    *reason = r.reason;
+    return r.result;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// Reference decoder of Tezos operation groups, to check the parser in src/operations.c against. It reads the binary
+// encoding the way the protocol's data-encoding does, over the whole message at once, and then applies the rules of
+// what the wallet signs. It shares no code with the parser.
+
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum reference_result {
+    REFERENCE_OK,
+    REFERENCE_INVALID, // Not an operation group in the Tezos encoding
+    REFERENCE_UNSUPPORTED, // Valid, but not something the wallet signs
+};
+
+// What an operation is, as far as the parser is concerned.
+struct reference_operation {
+    enum operation_tag tag;
+    enum operation_kind kind;
+    parsed_contract_t source;
+    parsed_contract_t destination;
+    parsed_contract_t delegate; // Originations
+    uint8_t script_hash[SIGN_HASH_SIZE]; // Originations
+    char entrypoint[MAX_ENTRYPOINT_LENGTH + 1]; // Transactions
+    bool is_manager_tz_operation;
+    parsed_contract_t implicit_account; // manager.tz calls
+    uint64_t amount;
+    bool amount_absent; // Deposit limits
+    uint32_t voting_period; // Proposals and ballots
+    uint8_t protocol_hash[PROTOCOL_HASH_SIZE]; // Proposals and ballots
+    enum ballot_vote vote;
+};
+
+// The fields the parser extracts, as the encoding says they should be.
+struct reference_group {
+    uint64_t total_fee;
+    uint64_t total_storage_limit;
+    bool has_reveal;
+    struct reference_operation operation; // The one that isn't a reveal; its kind is OPERATION_KIND_NONE if none is
+};
+
+// The key signing the group: implicit sources have to be its hash, and reveals have to reveal it.
+struct reference_signer {
+    parsed_contract_t contract;
+    uint8_t public_key[MAX_COMPRESSED_PUBLIC_KEY_SIZE];
+    size_t public_key_length;
+};
+
+// Decodes `data`, magic byte included. `reason` is set to why the group is invalid or unsupported.
+enum reference_result reference_decode(
+    struct reference_group *out, char const **reason,
+    uint8_t const *data, size_t length, struct reference_signer const *signer);
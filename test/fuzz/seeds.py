@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Writes the seed corpus of parse-fuzz (test/fuzz/parse_operations_fuzz.c) into a directory.
+
+Usage: seeds.py DIRECTORY
+
+Each seed is an input of the fuzz target: a byte that picks the signing key (0, Ed25519), a byte that seeds how the
+message is split into packets, and an operation group the wallet signs with that key. The groups are the ones of the
+APDU tests, signed by the key of the host build, and one of each kind of operation and manager.tz call the wallet
+parses, built here from the encoding.
+"""
+
+import hashlib
+import os
+import struct
+import sys
+
+# Public key of 44'/1729'/0'/0' on Ed25519 from the mnemonic of host builds, and its hash
+PUBLIC_KEY = bytes.fromhex("1dbfcc527042205a12508a62f37a72080e512c9338a9e7db3adeb6cae73e3ca5")
+SIGNER = hashlib.blake2b(PUBLIC_KEY, digest_size=20).digest()
+
+# Key hash the APDU tests sign with, which is replaced by SIGNER
+APDU_TESTS_SIGNER = bytes.fromhex("cf49f66b9ea137e11818f2a78b4b6fc9895b4e50")
+
+BRANCH = bytes(range(0xB0, 0xD0))
+OTHER = bytes(range(20))
+KT1 = bytes(range(0x40, 0x54))
+
+APDU_TEST_GROUPS = [
+    # transaction.sh
+    "0317777d8de5596705f1cb35b0247b9605a7c93a7ed5c0caa454d4f4ff39eb411d6c00cf49f66b9ea137e11818f2a78b4b6fc9895b4e"
+    "50830ae58003c35000c0843d0000eac6c762212c4110f221ec8fcb05ce83db95845700",
+    # named-delegates.sh
+    "034376b9304606f1dc37a507b7d2e730e60a3040389f57d2ccc3cf2520607c52d66e00cf49f66b9ea137e11818f2a78b4b6fc9895b4e"
+    "50e80904f44e00ff00cf49f66b9ea137e11818f2a78b4b6fc9895b4e50",
+    "035379ba9122785f71ec283a3b6398c05edc8f8d77eef885d167d22c50e9f9c26c6e00cf49f66b9ea137e11818f2a78b4b6fc9895b4e"
+    "50019e1480ea30e0d403ff00531ab5764a29f77c5d40b80a5da45c84468f08a1",
+    "035379ba9122785f71ec283a3b6398c05edc8f8d77eef885d167d22c50e9f9c26c6e00cf49f66b9ea137e11818f2a78b4b6fc9895b4e"
+    "50c0843d9e1480ea30e0d403ff00b5a3c247300abfea1242d10f347c321f796c1b88",
+]
+
+
+def zarith(value):
+    out = bytearray()
+    while True:
+        byte, value = value & 0x7F, value >> 7
+        out.append(byte | (0x80 if value else 0))
+        if not value:
+            return bytes(out)
+
+
+def sized(data):
+    return struct.pack(">I", len(data)) + data
+
+
+def implicit(key_hash, tag=0):
+    return bytes([tag]) + key_hash
+
+
+def contract(key_hash, originated=False):
+    return b"\x01" + key_hash + b"\x00" if originated else b"\x00" + implicit(key_hash)
+
+
+def base58check(prefix, payload):
+    alphabet = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"
+    data = prefix + payload
+    data += hashlib.sha256(hashlib.sha256(data).digest()).digest()[:4]
+    number, text = int.from_bytes(data, "big"), ""
+    while number:
+        number, digit = divmod(number, 58)
+        text = alphabet[digit] + text
+    return ("1" * (len(data) - len(data.lstrip(b"\0"))) + text).encode()
+
+
+# Micheline
+
+def micheline_int(value):
+    magnitude, out = abs(value), bytearray()
+    out.append((magnitude & 0x3F) | (0x40 if value < 0 else 0) | (0x80 if magnitude >> 6 else 0))
+    magnitude >>= 6
+    while magnitude:
+        byte, magnitude = magnitude & 0x7F, magnitude >> 7
+        out.append(byte | (0x80 if magnitude else 0))
+    return b"\x00" + bytes(out)
+
+
+def string(text):
+    return b"\x01" + sized(text)
+
+
+def seq(*items):
+    return b"\x02" + sized(b"".join(items))
+
+
+def prim(code, *args, annotation=None):
+    tag = 3 + 2 * len(args) + (1 if annotation is not None else 0)
+    return bytes([tag, code]) + b"".join(args) + (sized(annotation) if annotation is not None else b"")
+
+
+def micheline_bytes(data):
+    return b"\x0a" + sized(data)
+
+
+DROP, NIL, OPERATION, CONS = 0x20, 0x3D, 0x6D, 0x1B
+PUSH, KEY_HASH, SOME, NONE, SET_DELEGATE = 0x43, 0x5D, 0x46, 0x3E, 0x4E
+IMPLICIT_ACCOUNT, MUTEZ, UNIT, TRANSFER_TOKENS = 0x1E, 0x6A, 0x4F, 0x4D
+ADDRESS, CONTRACT, UNIT_TYPE, IF_NONE, FAILWITH = 0x6E, 0x55, 0x6C, 0x2F, 0x27
+DATA_UNIT, PAIR = 0x0B, 0x07
+
+
+def manager_tz(*body):
+    return seq(prim(DROP), prim(NIL, prim(OPERATION)), *body, prim(CONS))
+
+
+def to_implicit(key_hash, amount):
+    return manager_tz(prim(PUSH, prim(KEY_HASH), key_hash), prim(IMPLICIT_ACCOUNT),
+                      prim(PUSH, prim(MUTEZ), micheline_int(amount)), prim(UNIT), prim(TRANSFER_TOKENS))
+
+
+def to_contract(address, amount, entrypoint=None):
+    return manager_tz(prim(PUSH, prim(ADDRESS), address),
+                      prim(CONTRACT, prim(UNIT_TYPE), annotation=entrypoint),
+                      seq(prim(IF_NONE, seq(seq(prim(UNIT), prim(FAILWITH))), seq())),
+                      prim(PUSH, prim(MUTEZ), micheline_int(amount)), prim(UNIT), prim(TRANSFER_TOKENS))
+
+
+# Operations
+
+def manager(tag, fee=1420, storage_limit=300, source=None):
+    return bytes([tag]) + (source if source is not None else implicit(SIGNER)) + zarith(fee) + zarith(7) + \
+        zarith(10600) + zarith(storage_limit)
+
+
+def reveal(tag=107, source=None):
+    return manager(tag, 1257, 0, source) + b"\x00" + PUBLIC_KEY
+
+
+def transaction(amount, destination, parameters=None, tag=108, source=None):
+    return manager(tag, source=source) + zarith(amount) + destination + \
+        (b"\xff" + parameters if parameters is not None else b"\x00")
+
+
+def call(entrypoint, value):
+    if isinstance(entrypoint, int):
+        return bytes([entrypoint]) + sized(value)
+    return b"\xff" + bytes([len(entrypoint)]) + entrypoint + sized(value)
+
+
+def group(*operations):
+    return b"\x03" + BRANCH + b"".join(operations)
+
+
+def generated_groups():
+    to_kt1 = contract(KT1, originated=True)
+    yield "transaction", group(transaction(1000000, contract(OTHER, False)))
+    yield "reveal-transaction", group(reveal(), transaction(2 ** 40, to_kt1))
+    yield "reveal", group(reveal())
+    yield "call-default", group(transaction(0, to_kt1, call(0, prim(DATA_UNIT))))
+    yield "call-named", group(transaction(5, to_kt1, call(b"transfer", prim(PAIR, micheline_int(-3), string(b"x")))))
+    yield "call-set-delegate", group(transaction(0, to_kt1, call(3, micheline_bytes(implicit(OTHER)))))
+    yield "origination", group(manager(109) + zarith(500) + b"\xff" + implicit(OTHER) +
+                               sized(seq(prim(DROP))) + sized(prim(DATA_UNIT)))
+    yield "origination-no-delegate", group(reveal(), manager(109) + zarith(0) + b"\x00" + sized(b"") + sized(b""))
+    yield "delegation", group(manager(110) + b"\xff" + implicit(OTHER, 2))
+    yield "withdraw-delegate", group(manager(110) + b"\x00")
+    yield "deposits-limit", group(manager(112) + b"\xff" + zarith(10 ** 12))
+    yield "deposits-limit-none", group(manager(112) + b"\x00")
+    yield "proposal", group(b"\x05" + implicit(SIGNER) + struct.pack(">I", 12) + sized(bytes(range(32))))
+    yield "ballot", group(b"\x06" + implicit(SIGNER) + struct.pack(">I", 12) + bytes(range(32)) + b"\x02")
+    yield "athens", group(reveal(7, contract(SIGNER)), transaction(1, contract(OTHER), None, 8, to_kt1))
+    yield "athens-reveal-after", group(transaction(1, contract(OTHER), None, 8, to_kt1), reveal(7, contract(SIGNER)))
+    yield "athens-delegation", group(manager(10, source=to_kt1) + b"\xff" + implicit(OTHER))
+
+    manager_calls = {
+        "set-delegate": manager_tz(prim(PUSH, prim(KEY_HASH), micheline_bytes(implicit(OTHER, 1))), prim(SOME),
+                                   prim(SET_DELEGATE)),
+        "remove-delegate": manager_tz(prim(NONE, prim(KEY_HASH)), prim(SET_DELEGATE)),
+        "to-implicit": to_implicit(micheline_bytes(implicit(OTHER)), 10 ** 6),
+        "to-implicit-string": to_implicit(string(base58check(bytes([6, 161, 164]), OTHER)), 63),
+        "to-contract": to_contract(micheline_bytes(contract(KT1, originated=True)), 64),
+        "to-contract-entrypoint": to_contract(string(base58check(bytes([2, 90, 121]), KT1)), 2 ** 62, b"%deposit"),
+    }
+    for name, code in manager_calls.items():
+        yield "manager-tz-" + name, group(transaction(0, to_kt1, call(2, code)))
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__.strip().splitlines()[2])
+    directory = sys.argv[1]
+    os.makedirs(directory, exist_ok=True)
+
+    seeds = [("apdu-test-%d" % i, bytes.fromhex(text).replace(APDU_TESTS_SIGNER, SIGNER))
+             for i, text in enumerate(APDU_TEST_GROUPS)]
+    seeds += list(generated_groups())
+    for i, (name, message) in enumerate(seeds):
+        # In one packet, and split in a few ways
+        for split in (0, 1 + i, 101 + i):
+            with open(os.path.join(directory, "%s-%d" % (name, split)), "wb") as file:
+                file.write(bytes([0, split]) + message)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,181 @@
+#include "test.h"
+
+#include "apdu.h"
+#include "apdu_batch_pubkey.h"
+#include "globals.h"
+#include "keys.h"
+
+#include <string.h>
+
+#define P1_HASHES 0x01
+#define P1_RANGE 0x02
+
+#define CURVE_ED25519 0
+#define CURVE_SECP256K1 1
+#define CURVE_SECP256R1 2
+
+static bip32_path_t const account_path = {
+    .length = 4,
+    .components = { 44 | BIP32_HARDENED_BIT, 1729 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT },
+};
+
+static size_t write_path(uint8_t *const out, bip32_path_t const *const path) {
+    size_t size = 0;
+    out[size++] = path->length;
+    for (size_t i = 0; i < path->length; i++) {
+        for (size_t b = 0; b < sizeof(uint32_t); b++) out[size++] = path->components[i] >> (24 - 8 * b);
+    }
+    return size;
+}
+
+static size_t request(uint8_t const p1, uint8_t const curve, uint8_t const *const data, size_t const size) {
+    G_io_apdu_buffer[OFFSET_CLA] = 0x80;
+    G_io_apdu_buffer[OFFSET_INS] = INS_GET_PUBLIC_KEYS;
+    G_io_apdu_buffer[OFFSET_P1] = p1;
+    G_io_apdu_buffer[OFFSET_CURVE] = curve;
+    G_io_apdu_buffer[OFFSET_LC] = size;
+    memcpy(&G_io_apdu_buffer[OFFSET_CDATA], data, size);
+    return handle_apdu_get_public_keys(INS_GET_PUBLIC_KEYS);
+}
+
+// Collects the whole response, fetching parts as main_loop does for INS_GET_RESPONSE, and checks that every part
+// holds as many whole entries of `entry_size` as fit. Returns the size of the response.
+static size_t collect_response(uint8_t *const out, size_t tx, size_t const entry_size, size_t const entries) {
+    size_t const per_part = MAX_RESPONSE_PART_SIZE / entry_size;
+    size_t size = 0;
+    for (size_t part = 0;; part++) {
+        CHECK(tx >= 2);
+        bool const last = (part + 1) * per_part >= entries;
+        size_t const expected = last ? entries - part * per_part : per_part;
+        CHECK_EQ(expected * entry_size, tx - 2);
+        memcpy(out + size, G_io_apdu_buffer, tx - 2);
+        size += tx - 2;
+
+        uint16_t const sw = (G_io_apdu_buffer[tx - 2] << 8) | G_io_apdu_buffer[tx - 1];
+        if (last) {
+            CHECK_EQ(0x9000, sw);
+            return size;
+        }
+        CHECK_EQ(SW_MORE_DATA, sw);
+        tx = send_response_part();
+    }
+}
+
+// Checks `entry` against the key of `path`, or against its hash.
+static void check_entry(
+    uint8_t const *const entry, bool const hashes, derivation_type_t const derivation_type,
+    bip32_path_t const *const path
+) {
+    cx_ecfp_public_key_t public_key;
+    generate_public_key(&public_key, derivation_type, path);
+    uint8_t hash[HASH_SIZE];
+    cx_ecfp_public_key_t compressed;
+    public_key_hash(hash, sizeof(hash), &compressed, derivation_type, &public_key);
+    if (hashes) {
+        CHECK_MEM(hash, entry, HASH_SIZE);
+    } else {
+        CHECK_MEM(compressed.W, entry, compressed.W_len);
+    }
+}
+
+static size_t entry_size(bool const hashes, uint8_t const curve) {
+    if (hashes) return HASH_SIZE;
+    return curve == CURVE_ED25519 ? 32 : 33;
+}
+
+static void check_range(uint8_t const p1, uint8_t const curve, bip32_path_t const *const first, uint8_t const count) {
+    uint8_t data[MAX_APDU_SIZE];
+    size_t size = write_path(data, first);
+    data[size++] = count;
+
+    bool const hashes = (p1 & P1_HASHES) != 0;
+    size_t const entry = entry_size(hashes, curve);
+    static uint8_t response[255 * 33];
+    CHECK_EQ(count * entry, collect_response(response, request(p1 | P1_RANGE, curve, data, size), entry, count));
+
+    derivation_type_t const derivation_type = parse_derivation_type(curve);
+    for (size_t i = 0; i < count; i++) {
+        bip32_path_t path = *first;
+        path.components[path.length - 1] += i;
+        check_entry(response + i * entry, hashes, derivation_type, &path);
+    }
+    CHECK_THROWS(EXC_REFERENCED_DATA_NOT_FOUND, send_response_part());
+}
+
+static void check_list(uint8_t const p1, uint8_t const curve, bip32_path_t const *const paths, size_t const count) {
+    uint8_t data[MAX_APDU_SIZE];
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) size += write_path(data + size, &paths[i]);
+
+    bool const hashes = (p1 & P1_HASHES) != 0;
+    size_t const entry = entry_size(hashes, curve);
+    static uint8_t response[255 * 33];
+    CHECK_EQ(count * entry, collect_response(response, request(p1, curve, data, size), entry, count));
+
+    derivation_type_t const derivation_type = parse_derivation_type(curve);
+    for (size_t i = 0; i < count; i++) check_entry(response + i * entry, hashes, derivation_type, &paths[i]);
+}
+
+static void test_range(void) {
+    check_range(0, CURVE_SECP256K1, &account_path, 20); // Parts of 7, 7 and 6 keys
+    check_range(P1_HASHES, CURVE_ED25519, &account_path, 15); // Parts of 12 and 3 key hashes
+    check_range(P1_HASHES, CURVE_SECP256R1, &account_path, 1);
+
+    // Up to the last hardened and the last unhardened index
+    bip32_path_t path = account_path;
+    path.components[3] = BIP32_HARDENED_BIT | 0x7FFFFFFE;
+    check_range(0, CURVE_ED25519, &path, 2);
+    path.components[3] = 0x7FFFFFFE;
+    check_range(P1_HASHES, CURVE_SECP256K1, &path, 2);
+}
+
+static void test_list(void) {
+    // As many 4-component paths as fit in one request, in three parts of keys
+    bip32_path_t paths[MAX_APDU_SIZE / 17];
+    for (size_t i = 0; i < NUM_ELEMENTS(paths); i++) {
+        paths[i] = account_path;
+        paths[i].components[i % 4] ^= i;
+    }
+    check_list(0, CURVE_SECP256R1, paths, NUM_ELEMENTS(paths));
+
+    // Paths of different lengths
+    bip32_path_t const mixed[] = {
+        { .length = 1, .components = { 44 | BIP32_HARDENED_BIT } },
+        account_path,
+        { .length = 5, .components = { 44 | BIP32_HARDENED_BIT, 1729 | BIP32_HARDENED_BIT, 1, 2, 3 } },
+    };
+    check_list(P1_HASHES, CURVE_SECP256K1, mixed, NUM_ELEMENTS(mixed));
+    check_list(0, CURVE_ED25519, mixed, NUM_ELEMENTS(mixed));
+    check_list(P1_HASHES, CURVE_ED25519, mixed, NUM_ELEMENTS(mixed));
+}
+
+static void check_refused(uint8_t const p1, uint8_t const *const data, size_t const size, exception_t const exception) {
+    CHECK_THROWS(exception, request(p1, CURVE_ED25519, data, size));
+}
+
+static void test_refused(void) {
+    uint8_t data[MAX_APDU_SIZE];
+
+    // A range running from unhardened into hardened indices, and an empty range
+    bip32_path_t path = account_path;
+    path.components[3] = 0x7FFFFFFE;
+    size_t size = write_path(data, &path);
+    data[size++] = 3;
+    check_refused(P1_RANGE, data, size, EXC_WRONG_VALUES);
+    data[size - 1] = 0;
+    check_refused(P1_RANGE, data, size, EXC_WRONG_VALUES);
+
+    // A range without its count, and a list with a truncated path after a whole one
+    check_refused(P1_RANGE, data, size - 1, EXC_WRONG_LENGTH_FOR_INS);
+    size_t const whole = write_path(data, &account_path);
+    size = whole + write_path(data + whole, &account_path);
+    check_refused(0, data, size - 1, EXC_WRONG_LENGTH_FOR_INS);
+    check_refused(0, data, 0, EXC_WRONG_LENGTH_FOR_INS);
+    check_refused(0x04, data, whole, EXC_WRONG_PARAM);
+}
+
+void apdu_batch_pubkey_tests(void) {
+    RUN(test_range);
+    RUN(test_list);
+    RUN(test_refused);
+}
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Integration test of apdu-server, the app as a process serving APDUs over TCP (host/server/main.c).
+
+Usage: apdu_server_test.py APP SERVER [--rounds N]
+
+APP is tezos_wallet or tezos_baking, and SERVER the apdu-server built for it by `make host-server`. Starts the
+server, checks a few exchanges, a long response, and that prompts follow the policy it was given (and for the baking
+app, that NVRAM survives a restart), then times signing round trips and reports how many it does per second.
+"""
+
+import argparse
+import hashlib
+import os
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+PATH = [44 | 0x80000000, 1729 | 0x80000000, 0x80000000, 0x80000000]
+ED25519 = 0
+
+# Public key of PATH on Ed25519 from the default mnemonic, worked out with Python and the openssl tool
+PUBLIC_KEY = bytes.fromhex("021dbfcc527042205a12508a62f37a72080e512c9338a9e7db3adeb6cae73e3ca5")
+
+SW_OK = 0x9000
+SW_MORE_DATA = 0x6100
+SW_REJECT = 0x6985
+SW_WRONG_VALUES = 0x6a80
+SW_REFERENCED_DATA_NOT_FOUND = 0x6a88
+
+INS_VERSION = 0x00
+INS_AUTHORIZE_BAKING = 0x01
+INS_GET_PUBLIC_KEY = 0x02
+INS_QUERY_AUTH_KEY = 0x07
+INS_QUERY_MAIN_HWM = 0x08
+INS_SIGN = 0x04
+INS_SIGN_WITH_HASH = 0x0F
+INS_GET_PUBLIC_KEYS = 0x12
+INS_GET_RESPONSE = 0xC0
+
+SECP256K1 = 1
+P1_RANGE = 0x02
+
+P1_LAST = 0x81
+
+
+def path_bytes(path):
+    return bytes([len(path)]) + b"".join(struct.pack(">I", c) for c in path)
+
+
+def zarith(value):
+    out = bytearray()
+    while True:
+        byte, value = value & 0x7F, value >> 7
+        out.append(byte | (0x80 if value else 0))
+        if not value:
+            return bytes(out)
+
+
+def self_delegation():
+    key_hash = hashlib.blake2b(PUBLIC_KEY[1:], digest_size=20).digest()
+    return (b"\x03" + bytes(range(0xB0, 0xD0)) + bytes([110, 0]) + key_hash
+            + zarith(1257) + zarith(7) + zarith(10600) + zarith(0) + b"\xff\x00" + key_hash)
+
+
+def block(level):
+    return b"\x01" + struct.pack(">II", 0x7A06A770, level) + b"\x02" + bytes(32)
+
+
+class Server:
+    """An apdu-server process and a connection to it, framed as speculos and ledgerblue frame APDUs."""
+
+    def __init__(self, binary, *args):
+        self.process = subprocess.Popen([binary, "-p", "0", *args], stdout=subprocess.PIPE, text=True)
+        line = self.process.stdout.readline()
+        if not line.startswith("Listening on 127.0.0.1:"):
+            raise RuntimeError("Unexpected output from the server: %r" % line)
+        self.socket = socket.create_connection(("127.0.0.1", int(line.rsplit(":", 1)[1])))
+        self.socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def close(self):
+        self.socket.close()
+        self.process.terminate()
+        self.process.wait()
+
+    def receive(self, size):
+        data = b""
+        while len(data) < size:
+            part = self.socket.recv(size - len(data))
+            if not part:
+                raise RuntimeError("The server closed the connection")
+            data += part
+        return data
+
+    def exchange(self, ins, p1=0, p2=ED25519, data=b""):
+        apdu = bytes([0x80, ins, p1, p2, len(data)]) + data
+        self.socket.sendall(struct.pack(">I", len(apdu)) + apdu)
+        (size,) = struct.unpack(">I", self.receive(4))
+        response = self.receive(size + 2)
+        return response[:-2], struct.unpack(">H", response[-2:])[0]
+
+    def sign(self, message, ins=INS_SIGN_WITH_HASH):
+        response, sw = self.exchange(ins, 0, ED25519, path_bytes(PATH))
+        check(sw == SW_OK, "path accepted")
+        return self.exchange(ins, P1_LAST, ED25519, message)
+
+
+failures = 0
+
+
+def check(condition, what):
+    global failures
+    if not condition:
+        failures += 1
+        print("FAIL: %s" % what)
+
+
+def test_exchanges(server, app):
+    response, sw = server.exchange(INS_VERSION)
+    check(sw == SW_OK and response[0] == (1 if app == "tezos_baking" else 0), "version of the right app")
+
+    response, sw = server.exchange(INS_GET_PUBLIC_KEY, data=path_bytes(PATH))
+    check(sw == SW_OK and response == bytes([len(PUBLIC_KEY)]) + PUBLIC_KEY, "public key")
+
+    response, sw = server.exchange(0x7F)
+    check(sw != SW_OK and response == b"", "unknown instruction fails")
+
+    test_response_chaining(server)
+
+
+def compressed_public_key(server, path):
+    response, sw = server.exchange(INS_GET_PUBLIC_KEY, p2=SECP256K1, data=path_bytes(path))
+    check(sw == SW_OK and response[:2] == b"\x41\x04", "uncompressed secp256k1 key")
+    return bytes([0x02 + (response[-1] & 1)]) + response[2:34]
+
+
+def test_response_chaining(server):
+    """Long responses go through main_loop: parts end in 0x6100 until the last, and INS_GET_RESPONSE fetches the next."""
+    count = 20  # 33-byte keys, of which 7 fit in a part
+    request = path_bytes(PATH) + bytes([count])
+    response, sw = server.exchange(INS_GET_PUBLIC_KEYS, P1_RANGE, SECP256K1, request)
+    parts = [response]
+    while sw == SW_MORE_DATA:
+        response, sw = server.exchange(INS_GET_RESPONSE)
+        parts.append(response)
+    check(sw == SW_OK, "long response ends in 0x9000")
+    check([len(part) for part in parts] == [7 * 33, 7 * 33, 6 * 33], "parts of whole keys")
+    response, sw = server.exchange(INS_GET_RESPONSE)
+    check(sw == SW_REFERENCED_DATA_NOT_FOUND and response == b"", "nothing left to get")
+
+    expected = b"".join(compressed_public_key(server, PATH[:-1] + [PATH[-1] + i]) for i in range(count))
+    check(b"".join(parts) == expected, "keys of the range")
+
+    # Any other instruction abandons the rest of the response.
+    response, sw = server.exchange(INS_GET_PUBLIC_KEYS, P1_RANGE, SECP256K1, request)
+    check(sw == SW_MORE_DATA, "first part")
+    response, sw = server.exchange(INS_VERSION)
+    check(sw == SW_OK, "another instruction")
+    response, sw = server.exchange(INS_GET_RESPONSE)
+    check(sw == SW_REFERENCED_DATA_NOT_FOUND, "rest of the response dropped")
+
+
+def test_wallet_prompts(binary):
+    server = Server(binary, "-u", "ra")
+    try:
+        test_exchanges(server, "tezos_wallet")
+        message = self_delegation()
+        response, sw = server.sign(message)
+        check(sw == SW_REJECT and response == b"", "first prompt rejected")
+        response, sw = server.sign(message)
+        check(sw == SW_OK and response[:32] == hashlib.blake2b(message, digest_size=32).digest()
+              and len(response) == 32 + 64, "second prompt accepted")
+    finally:
+        server.close()
+
+
+def test_baking_nvram(binary, nvram):
+    server = Server(binary, "-n", nvram)
+    try:
+        test_exchanges(server, "tezos_baking")
+        response, sw = server.exchange(INS_AUTHORIZE_BAKING, data=path_bytes(PATH))
+        check(sw == SW_OK, "baking authorized")
+        response, sw = server.sign(block(5), INS_SIGN)
+        check(sw == SW_OK and len(response) == 64, "block signed")
+    finally:
+        server.close()
+
+    server = Server(binary, "-n", nvram, "-u", "r")
+    try:
+        response, sw = server.exchange(INS_QUERY_AUTH_KEY)
+        check(sw == SW_OK and response == path_bytes(PATH), "baking key kept across a restart")
+        response, sw = server.exchange(INS_QUERY_MAIN_HWM)
+        check(sw == SW_OK and response[:4] == struct.pack(">I", 5), "high water mark kept across a restart")
+        response, sw = server.sign(block(5), INS_SIGN)
+        check(sw == SW_WRONG_VALUES, "block at the high water mark refused")
+        response, sw = server.sign(self_delegation())
+        check(sw == SW_REJECT, "registration rejected")
+    finally:
+        server.close()
+
+
+def benchmark(binary, app, nvram, rounds):
+    """Signing round trips: self-delegations accepted at the prompt by the wallet, blocks by the baking app."""
+    args = ["-n", nvram] if app == "tezos_baking" else []
+    server = Server(binary, *args)
+    try:
+        if app == "tezos_baking":
+            server.exchange(INS_AUTHORIZE_BAKING, data=path_bytes(PATH))
+        message = self_delegation()
+        start = time.perf_counter()
+        for level in range(1, rounds + 1):
+            if app == "tezos_baking":
+                response, sw = server.sign(block(level), INS_SIGN)
+            else:
+                response, sw = server.sign(message)
+            if sw != SW_OK:
+                check(False, "round trip %d" % level)
+                break
+        elapsed = time.perf_counter() - start
+    finally:
+        server.close()
+    print("%d signing round trips in %.2f s: %.0f per second" % (rounds, elapsed, rounds / elapsed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("app", choices=["tezos_wallet", "tezos_baking"])
+    parser.add_argument("server")
+    parser.add_argument("--rounds", type=int, default=2000)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        if args.app == "tezos_baking":
+            test_baking_nvram(args.server, os.path.join(directory, "nvram"))
+        else:
+            test_wallet_prompts(args.server)
+        benchmark(args.server, args.app, os.path.join(directory, "benchmark-nvram"), args.rounds)
+
+    if failures:
+        print("%d server checks failed" % failures)
+        sys.exit(1)
+    print("Server checks passed")
+
+
+if __name__ == "__main__":
+    main()
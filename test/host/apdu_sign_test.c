@@ -0,0 +1,321 @@
+#include "test.h"
+
+#include "apdu.h"
+#include "apdu_sign.h"
+#include "globals.h"
+#include "host.h"
+#include "keys.h"
+
+#include <string.h>
+
+static bip32_path_t const signer_path = {
+    .length = 4,
+    .components = { 44 | BIP32_HARDENED_BIT, 1729 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT },
+};
+
+// The signer's delegation to itself, from the same key as keys_test.c, and its BLAKE2b-256 hash from Python's hashlib.
+static char const self_delegation[] =
+    "03b0b1b2b3b4b5b6b7b8b9babbbcbdbebfc0c1c2c3c4c5c6c7c8c9cacbcccdcecf6e004035f49a9d068f852084ddf642835bbfdd4ff6"
+    "81e90907e85200ff004035f49a9d068f852084ddf642835bbfdd4ff681";
+static char const self_delegation_hash[] = "ce7835b580db56b1a06878814999a88e6755569768b5bf7f5b6e9bf4b08901a7";
+
+#ifndef BAKING_APP
+// The signer calls %transfer on a KT1 with a string of 130 letters, which takes three screens.
+static char const long_contract_call[] =
+    "03b0b1b2b3b4b5b6b7b8b9babbbcbdbebfc0c1c2c3c4c5c6c7c8c9cacbcccdcecf6c004035f49a9d068f852084ddf642835bbfdd4ff6"
+    "81e90907e852000001000102030405060708090a0b0c0d0e0f1011121300ffff087472616e7366657200000087010000008261626364"
+    "65666768696a6b6c6d6e6f707172737475767778797a6162636465666768696a6b6c6d6e6f707172737475767778797a616263646566"
+    "6768696a6b6c6d6e6f707172737475767778797a6162636465666768696a6b6c6d6e6f707172737475767778797a6162636465666768"
+    "696a6b6c6d6e6f707172737475767778797a";
+#endif
+
+static struct {
+    uint8_t bytes[IO_APDU_BUFFER_SIZE];
+    size_t size;
+} response;
+
+static void save_response(uint8_t const *const data, size_t const size) {
+    memcpy(response.bytes, data, size);
+    response.size = size;
+}
+
+// Puts an APDU in the buffer as io_exchange would, and returns the size of the response to it.
+static size_t exchange_instruction(
+    uint8_t const instruction, uint8_t const p1, uint8_t const *const data, size_t const size
+) {
+    G_io_apdu_buffer[OFFSET_CLA] = 0x80;
+    G_io_apdu_buffer[OFFSET_INS] = instruction;
+    G_io_apdu_buffer[OFFSET_P1] = p1;
+    G_io_apdu_buffer[OFFSET_CURVE] = 0; // Ed25519
+    G_io_apdu_buffer[OFFSET_LC] = size;
+    memcpy(&G_io_apdu_buffer[OFFSET_CDATA], data, size);
+    switch (instruction) {
+        case INS_SIGN_WITH_HASH:
+            return handle_apdu_sign_with_hash(instruction);
+#       ifndef BAKING_APP
+        case INS_PREVIEW_OPERATION:
+            return handle_apdu_preview_operation(instruction);
+#       endif
+        default:
+            return handle_apdu_sign(instruction);
+    }
+}
+
+static size_t exchange(uint8_t const p1, uint8_t const *const data, size_t const size) {
+    return exchange_instruction(INS_SIGN_WITH_HASH, p1, data, size);
+}
+
+// Sends the signer's path in a first packet with `p1`.
+static void send_path(uint8_t const p1) {
+    uint8_t path[1 + MAX_BIP32_PATH * sizeof(uint32_t)];
+    size_t size = 0;
+    path[size++] = signer_path.length;
+    for (size_t i = 0; i < signer_path.length; i++) {
+        for (size_t b = 0; b < sizeof(uint32_t); b++) path[size++] = signer_path.components[i] >> (24 - 8 * b);
+    }
+    CHECK_EQ(2, exchange(p1, path, size));
+    CHECK_EQ(0x90, G_io_apdu_buffer[0]);
+}
+
+// Sends the path and then the message, which leaves the app prompting.
+static void start_signing(uint8_t const *const message, size_t const message_size) {
+    send_path(0x00);
+
+    CHECK_THROWS(ASYNC_EXCEPTION, exchange(0x81, message, message_size));
+    CHECK(host_prompt.waiting);
+}
+
+static void setup(uint8_t *const message, size_t *const message_size) {
+    *message_size = from_hex(message, *message_size, self_delegation);
+    response.size = 0;
+    host_io_send = save_response;
+    ui_initial_screen();
+
+#   ifdef BAKING_APP
+        // Only the authorized baking key signs its registration.
+        UPDATE_NVRAM(ram, {
+            ram->baking_key.derivation_type = DERIVATION_TYPE_ED25519;
+            copy_bip32_path(&ram->baking_key.bip32_path, &signer_path);
+        });
+#   endif
+}
+
+// Accepts the prompt and checks that the response is the hash of the self-delegation and its signature.
+static void check_signed_self_delegation(void) {
+    host_ui_respond(true);
+    CHECK(!host_prompt.waiting);
+
+    // Hash, signature of the hash and status
+    uint8_t hash[SIGN_HASH_SIZE];
+    from_hex(hash, sizeof(hash), self_delegation_hash);
+    CHECK_EQ(SIGN_HASH_SIZE + 64 + 2, response.size);
+    CHECK_MEM(hash, response.bytes, SIGN_HASH_SIZE);
+    CHECK_EQ(0x90, response.bytes[response.size - 2]);
+    CHECK_EQ(0x00, response.bytes[response.size - 1]);
+
+    cx_ecfp_public_key_t public_key;
+    generate_public_key(&public_key, DERIVATION_TYPE_ED25519, &signer_path);
+    CHECK(verify_signature(DERIVATION_TYPE_ED25519, &public_key, &response.bytes[SIGN_HASH_SIZE], 64, hash, sizeof(hash)));
+    host_io_send = NULL;
+}
+
+static void test_sign_with_hash(void) {
+    uint8_t message[128];
+    size_t message_size = sizeof(message);
+    setup(message, &message_size);
+    start_signing(message, message_size);
+
+#   ifdef BAKING_APP
+        CHECK_STR("Register", host_prompt.screens[0].prompt);
+#   else
+        CHECK_STR("Delegation", host_prompt.screens[0].value);
+#   endif
+
+    check_signed_self_delegation();
+}
+
+static void check_packet_refused(uint8_t const instruction, uint8_t const p1) {
+    uint8_t junk[200];
+    memset(junk, 0xA5, sizeof(junk));
+    CHECK_THROWS(EXC_WRONG_LENGTH_FOR_INS, exchange_instruction(instruction, p1, junk, sizeof(junk)));
+}
+
+// Packets of another instruction must not reach a session, whose state they would read differently: a message
+// for INS_SIGN_UNSAFE would be copied over the hash of the operation being shown.
+static void test_mixed_instructions(void) {
+#   ifdef BAKING_APP
+        uint8_t const other_instruction = INS_SIGN;
+#   else
+        uint8_t const other_instruction = INS_SIGN_UNSAFE;
+#   endif
+
+    uint8_t message[128];
+    size_t message_size = sizeof(message);
+    setup(message, &message_size);
+    start_signing(message, message_size);
+
+    check_packet_refused(other_instruction, 0x01);
+    check_packet_refused(other_instruction, 0x81);
+    CHECK(host_prompt.waiting);
+
+    check_signed_self_delegation();
+}
+
+static void test_reject(void) {
+    uint8_t message[128];
+    size_t message_size = sizeof(message);
+    setup(message, &message_size);
+    start_signing(message, message_size);
+
+    host_ui_respond(false);
+    CHECK_EQ(2, response.size);
+    CHECK_EQ(EXC_REJECT >> 8, response.bytes[0]);
+    CHECK_EQ(EXC_REJECT & 0xFF, response.bytes[1]);
+    CHECK_THROWS(EXC_MEMORY_ERROR, host_ui_respond(true));
+    host_io_send = NULL;
+}
+
+#ifndef BAKING_APP
+// Checks that the response is a fail-fast rejection at `step` and `offset`, and that the session is over.
+static void check_failed_fast(size_t const tx, uint16_t const step, uint32_t const offset) {
+    uint8_t const expected[] = {
+        step >> 8, step & 0xFF,
+        offset >> 24, (offset >> 16) & 0xFF, (offset >> 8) & 0xFF, offset & 0xFF,
+        EXC_PARSE_ERROR >> 8, EXC_PARSE_ERROR & 0xFF,
+    };
+    CHECK_EQ(sizeof(expected), tx);
+    CHECK_MEM(expected, G_io_apdu_buffer, sizeof(expected));
+    check_packet_refused(INS_SIGN_WITH_HASH, 0x81);
+    CHECK(!host_prompt.waiting);
+}
+
+// In fail-fast mode, the packet with the first byte that can't be parsed ends the session.
+static void test_fail_fast(void) {
+    uint8_t message[128];
+    size_t message_size = sizeof(message);
+    setup(message, &message_size);
+    message[33] = 0x01; // The tag, after the magic byte and the branch; no operation has it
+
+    send_path(0x04);
+    CHECK_EQ(2, exchange(0x01, message, 20));
+    CHECK_EQ(0x90, G_io_apdu_buffer[0]);
+    size_t const tx = exchange(0x01, message + 20, message_size - 20);
+    check_failed_fast(tx, 1 /* STEP_OPERATION_TAG */, 33);
+    host_io_send = NULL;
+}
+
+// A last packet that leaves the operation incomplete fails at the step it stopped in, one byte past the end.
+static void test_fail_fast_truncated(void) {
+    uint8_t message[128];
+    size_t message_size = sizeof(message);
+    setup(message, &message_size);
+    message_size -= 5; // Within the delegate's key hash
+
+    send_path(0x04);
+    size_t const tx = exchange(0x81, message, message_size);
+    check_failed_fast(tx, 10001 /* STEP_FIELD */, message_size);
+    host_io_send = NULL;
+}
+
+// Starts a preview with the signer's public key, as INS_GET_PUBLIC_KEY returns it.
+static void start_preview(void) {
+    cx_ecfp_public_key_t public_key;
+    generate_public_key(&public_key, DERIVATION_TYPE_ED25519, &signer_path);
+    uint8_t data[1 + sizeof(public_key.W)];
+    data[0] = public_key.W_len;
+    memcpy(data + 1, public_key.W, public_key.W_len);
+    CHECK_EQ(2, exchange_instruction(INS_PREVIEW_OPERATION, 0x00, data, 1 + public_key.W_len));
+    CHECK_EQ(0x90, G_io_apdu_buffer[0]);
+}
+
+// Previews `message` in packets of at most `packet_size` bytes and checks the summary, status word included.
+static void check_preview(char const *const message_hex, size_t const packet_size, char const *const summary_hex) {
+    uint8_t message[512];
+    size_t const message_size = from_hex(message, sizeof(message), message_hex);
+    uint8_t summary[128];
+    size_t const summary_size = from_hex(summary, sizeof(summary), summary_hex);
+
+    start_preview();
+    size_t tx = 0;
+    for (size_t sent = 0; sent < message_size; sent += packet_size) {
+        size_t const size = MIN(packet_size, message_size - sent);
+        bool const last = sent + size == message_size;
+        tx = exchange_instruction(INS_PREVIEW_OPERATION, last ? 0x81 : 0x01, message + sent, size);
+        if (tx != 2) break; // The summary
+    }
+    CHECK_EQ(summary_size, tx);
+    CHECK_MEM(summary, G_io_apdu_buffer, summary_size);
+    CHECK(!host_prompt.waiting);
+}
+
+// The summary of INS_PREVIEW_OPERATION is read by hosts, so its layout is checked byte by byte.
+static void test_preview(void) {
+    // Version, status, kind, tag, flags
+    // source and destination: originated, signature type, hash
+    // amount, total fee, total storage limit, all 8 bytes; status word
+    check_preview(self_delegation, 40,
+                  "0100066e00"
+                  "00034035f49a9d068f852084ddf642835bbfdd4ff681"
+                  "00034035f49a9d068f852084ddf642835bbfdd4ff681"
+                  "0000000000000000" "00000000000004e9" "0000000000000000" "9000");
+    check_preview(long_contract_call, 200,
+                  "0100046c00"
+                  "00034035f49a9d068f852084ddf642835bbfdd4ff681"
+                  "0100000102030405060708090a0b0c0d0e0f10111213"
+                  "0000000000000000" "00000000000004e9" "0000000000000000" "9000");
+
+    // An operation that can't be parsed is answered as soon as it fails: version, status, step, offset.
+    char broken[sizeof(self_delegation)];
+    memcpy(broken, self_delegation, sizeof(broken));
+    memcpy(broken + 2 * 33, "01", 2); // The tag, after the magic byte and the branch; no operation has it
+    check_preview(broken, 20, "0101" "0001" "00000021" "9000");
+}
+
+// The operation can only follow a preview's first packet, not a signing session's.
+static void test_preview_session(void) {
+    uint8_t message[128];
+    size_t message_size = sizeof(message);
+    setup(message, &message_size);
+    send_path(0x00);
+    check_packet_refused(INS_PREVIEW_OPERATION, 0x01);
+    host_io_send = NULL;
+}
+
+// Parameters longer than a screen are paged between the entrypoint and the storage limit.
+static void test_contract_call_pages(void) {
+    uint8_t message[256];
+    size_t message_size = sizeof(message);
+    setup(message, &message_size);
+    message_size = from_hex(message, sizeof(message), long_contract_call);
+    start_signing(message, message_size);
+
+    CHECK_EQ(10, host_prompt.screen_count);
+    CHECK_STR("Contract Call", host_prompt.screens[0].value);
+    CHECK_STR("transfer", host_prompt.screens[5].value);
+    CHECK_STR("Parameter (1/3)", host_prompt.screens[6].prompt);
+    CHECK_STR("\"abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxy", host_prompt.screens[6].value);
+    CHECK_STR("Parameter (2/3)", host_prompt.screens[7].prompt);
+    CHECK_STR("zabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxy", host_prompt.screens[7].value);
+    CHECK_STR("Parameter (3/3)", host_prompt.screens[8].prompt);
+    CHECK_STR("zabcdefghijklmnopqrstuvwxyz\"", host_prompt.screens[8].value);
+    CHECK_STR("Storage Limit", host_prompt.screens[9].prompt);
+    CHECK_STR("0", host_prompt.screens[9].value);
+
+    host_ui_respond(false);
+    CHECK_EQ(2, response.size);
+    host_io_send = NULL;
+}
+#endif
+
+void apdu_sign_tests(void) {
+    RUN(test_sign_with_hash);
+    RUN(test_mixed_instructions);
+#ifndef BAKING_APP
+    RUN(test_contract_call_pages);
+    RUN(test_fail_fast);
+    RUN(test_fail_fast_truncated);
+    RUN(test_preview);
+    RUN(test_preview_session);
+#endif
+    RUN(test_reject);
+}
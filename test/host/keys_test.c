@@ -0,0 +1,234 @@
+#include "test.h"
+
+#include "globals.h"
+#include "keys.h"
+#include "to_string.h"
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/obj_mac.h>
+#include <openssl/x509.h>
+
+#include <string.h>
+
+static bip32_path_t const tezos_path = {
+    .length = 4,
+    .components = { 44 | BIP32_HARDENED_BIT, 1729 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT },
+};
+
+static derivation_type_t const derivation_types[] = {
+    DERIVATION_TYPE_ED25519, DERIVATION_TYPE_SECP256K1, DERIVATION_TYPE_SECP256R1,
+};
+
+bool verify_signature(
+    derivation_type_t const derivation_type, cx_ecfp_public_key_t const *const public_key,
+    uint8_t const *const signature, size_t const signature_size, uint8_t const *const message, size_t const message_size
+) {
+    if (derivation_type == DERIVATION_TYPE_ED25519) {
+        EVP_PKEY *const key = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, NULL, public_key->W + 1, 32);
+        EVP_MD_CTX *const ctx = EVP_MD_CTX_new();
+        bool const valid = key != NULL && ctx != NULL
+            && EVP_DigestVerifyInit(ctx, NULL, NULL, NULL, key) == 1
+            && EVP_DigestVerify(ctx, signature, signature_size, message, message_size) == 1;
+        EVP_MD_CTX_free(ctx);
+        EVP_PKEY_free(key);
+        return valid;
+    }
+
+    // The app sets the lowest bit of the DER header to the parity of R.
+    uint8_t der[100];
+    memcpy(der, signature, signature_size);
+    der[0] &= ~0x01;
+
+    // SubjectPublicKeyInfo of the uncompressed key
+    static uint8_t const secp256k1_prefix[] = {
+        0x30, 0x56, 0x30, 0x10, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01,
+        0x06, 0x05, 0x2b, 0x81, 0x04, 0x00, 0x0a, 0x03, 0x42, 0x00,
+    };
+    static uint8_t const secp256r1_prefix[] = {
+        0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01,
+        0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00,
+    };
+    bool const k1 = derivation_type == DERIVATION_TYPE_SECP256K1;
+    size_t const prefix_size = k1 ? sizeof(secp256k1_prefix) : sizeof(secp256r1_prefix);
+    uint8_t spki[sizeof(secp256r1_prefix) + 65];
+    memcpy(spki, k1 ? secp256k1_prefix : secp256r1_prefix, prefix_size);
+    memcpy(spki + prefix_size, public_key->W, 65);
+
+    uint8_t const *p = spki;
+    EVP_PKEY *const key = public_key->W_len == 65 ? d2i_PUBKEY(NULL, &p, prefix_size + 65) : NULL;
+    EVP_PKEY_CTX *const ctx = key == NULL ? NULL : EVP_PKEY_CTX_new(key, NULL);
+    bool const valid = ctx != NULL
+        && EVP_PKEY_verify_init(ctx) == 1
+        && EVP_PKEY_verify(ctx, der, signature_size, message, message_size) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return valid;
+}
+
+static void test_derivation(void) {
+    // The address of the default mnemonic, worked out with Python and the openssl tool.
+    char buff[PKH_STRING_SIZE];
+    bip32_path_with_curve_t const key = { .bip32_path = tezos_path, .derivation_type = DERIVATION_TYPE_ED25519 };
+    bip32_path_with_curve_to_pkh_string(buff, sizeof(buff), &key);
+    CHECK_STR("tz1RVYaHiobUKXMfJ47F7Rjxx5tu3LC35WSA", buff);
+
+    for (size_t i = 0; i < NUM_ELEMENTS(derivation_types); i++) {
+        cx_ecfp_public_key_t first;
+        generate_public_key(&first, derivation_types[i], &tezos_path);
+        cx_ecfp_public_key_t second;
+        generate_public_key(&second, derivation_types[i], &tezos_path);
+        CHECK_EQ(first.W_len, second.W_len);
+        CHECK_MEM(first.W, second.W, first.W_len);
+
+        bip32_path_t other = tezos_path;
+        other.components[3] = 1;
+        generate_public_key(&second, derivation_types[i], &other);
+        CHECK(memcmp(first.W, second.W, first.W_len) != 0);
+    }
+}
+
+static void test_signatures(void) {
+    uint8_t const message[32] = { 1, 2, 3, 4 }; // ECDSA signs it as a hash
+    for (size_t i = 0; i < NUM_ELEMENTS(derivation_types); i++) {
+        key_pair_t pair;
+        generate_key_pair(&pair, derivation_types[i], &tezos_path);
+        uint8_t signature[100];
+        size_t const size = sign(signature, sizeof(signature), derivation_types[i], &pair, message, sizeof(message));
+        CHECK(verify_signature(derivation_types[i], &pair.public_key, signature, size, message, sizeof(message)));
+
+        signature[size - 1] ^= 1;
+        CHECK(!verify_signature(derivation_types[i], &pair.public_key, signature, size, message, sizeof(message)));
+        explicit_bzero(&pair, sizeof(pair));
+    }
+}
+
+// Derives the uncompressed public key and the chain code of the unhardened child `index` of a BIP32 secp256k1 or
+// P-256 node from its public key and chain code alone, as a watch-only host does.
+static void derive_public_child(
+    uint8_t key[65], uint8_t chain_code[CHAIN_CODE_SIZE], derivation_type_t const derivation_type, uint32_t const index
+) {
+    EC_GROUP *const group = EC_GROUP_new_by_curve_name(
+        derivation_type == DERIVATION_TYPE_SECP256K1 ? NID_secp256k1 : NID_X9_62_prime256v1);
+    BN_CTX *const bn = BN_CTX_new();
+    EC_POINT *const point = group == NULL ? NULL : EC_POINT_new(group);
+    BIGNUM *const tweak = BN_new();
+    BIGNUM *const one = BN_new();
+    CHECK(point != NULL && bn != NULL && tweak != NULL && one != NULL && BN_one(one) == 1);
+
+    uint8_t data[33 + 4];
+    data[0] = 0x02 + (key[64] & 1);
+    memcpy(data + 1, key + 1, 32);
+    for (size_t b = 0; b < 4; b++) data[33 + b] = index >> (24 - 8 * b);
+    uint8_t i[64];
+    unsigned int i_size = sizeof(i);
+    CHECK(HMAC(EVP_sha512(), chain_code, CHAIN_CODE_SIZE, data, sizeof(data), i, &i_size) != NULL);
+
+    // child = IL·G + parent
+    CHECK(BN_bin2bn(i, 32, tweak) != NULL);
+    CHECK(EC_POINT_oct2point(group, point, key, 65, bn) == 1);
+    CHECK(EC_POINT_mul(group, point, tweak, point, one, bn) == 1);
+    CHECK_EQ(65, EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, key, 65, bn));
+    memcpy(chain_code, i + 32, CHAIN_CODE_SIZE);
+
+    BN_free(one);
+    BN_free(tweak);
+    EC_POINT_free(point);
+    BN_CTX_free(bn);
+    EC_GROUP_free(group);
+}
+
+static void test_extended_public_key(void) {
+    static derivation_type_t const bip32_types[] = { DERIVATION_TYPE_SECP256K1, DERIVATION_TYPE_SECP256R1 };
+    static uint32_t const indices[] = { 0, 1, 1729, 0x7FFFFFFF };
+    for (size_t t = 0; t < NUM_ELEMENTS(bip32_types); t++) {
+        derivation_type_t const derivation_type = bip32_types[t];
+        uint8_t chain_code[CHAIN_CODE_SIZE];
+        cx_ecfp_public_key_t const *const extended =
+            generate_extended_public_key_return_global(chain_code, derivation_type, &tezos_path);
+        CHECK_EQ(65, extended->W_len);
+        uint8_t parent[65];
+        memcpy(parent, extended->W, sizeof(parent));
+
+        for (size_t n = 0; n < NUM_ELEMENTS(indices); n++) {
+            // The child and one of its own children
+            uint8_t key[65];
+            uint8_t child_chain_code[CHAIN_CODE_SIZE];
+            memcpy(key, parent, sizeof(key));
+            memcpy(child_chain_code, chain_code, sizeof(child_chain_code));
+            bip32_path_t path = tezos_path;
+            for (size_t depth = 0; depth < 2; depth++) {
+                uint32_t const index = indices[(n + depth) % NUM_ELEMENTS(indices)];
+                derive_public_child(key, child_chain_code, derivation_type, index);
+                path.components[path.length++] = index;
+
+                cx_ecfp_public_key_t public_key;
+                generate_public_key(&public_key, derivation_type, &path);
+                CHECK_EQ(65, public_key.W_len);
+                CHECK_MEM(public_key.W, key, sizeof(key));
+            }
+        }
+    }
+}
+
+static void test_key_cache(void) {
+    uint8_t expected[HASH_SIZE];
+    public_key_hash(expected, sizeof(expected), NULL, DERIVATION_TYPE_SECP256K1,
+                    generate_public_key_return_global(DERIVATION_TYPE_SECP256K1, &tezos_path));
+
+    struct key_cache_entry const *entry = public_key_hash_of_path_return_global(DERIVATION_TYPE_SECP256K1, &tezos_path);
+    CHECK_MEM(expected, entry->hash, HASH_SIZE);
+    CHECK_EQ(33, entry->public_key.length);
+    CHECK_EQ(0, global.key_cache.hits);
+    CHECK_EQ(1, global.key_cache.misses);
+
+    entry = public_key_hash_of_path_return_global(DERIVATION_TYPE_SECP256K1, &tezos_path);
+    CHECK_MEM(expected, entry->hash, HASH_SIZE);
+    CHECK_EQ(1, global.key_cache.hits);
+
+    // Same path on another curve
+    entry = public_key_hash_of_path_return_global(DERIVATION_TYPE_SECP256R1, &tezos_path);
+    CHECK(memcmp(expected, entry->hash, HASH_SIZE) != 0);
+    CHECK_EQ(2, global.key_cache.misses);
+
+    // Evicting the least recently used key
+    for (uint32_t i = 0; i < KEY_CACHE_SIZE; i++) {
+        bip32_path_t path = tezos_path;
+        path.components[3] = i;
+        public_key_hash_of_path_return_global(DERIVATION_TYPE_ED25519, &path);
+    }
+    uint32_t const misses = global.key_cache.misses;
+    entry = public_key_hash_of_path_return_global(DERIVATION_TYPE_SECP256K1, &tezos_path);
+    CHECK_MEM(expected, entry->hash, HASH_SIZE);
+    CHECK_EQ(misses + 1, global.key_cache.misses);
+
+    // A path too long to cache leaves the cached keys alone
+    struct key_cache const before = global.key_cache;
+    bip32_path_t long_path = tezos_path;
+    while (long_path.length <= KEY_CACHE_MAX_PATH) long_path.components[long_path.length++] = 1;
+    uint8_t long_expected[HASH_SIZE];
+    public_key_hash(long_expected, sizeof(long_expected), NULL, DERIVATION_TYPE_SECP256K1,
+                    generate_public_key_return_global(DERIVATION_TYPE_SECP256K1, &long_path));
+    for (size_t i = 0; i < 2; i++) {
+        entry = public_key_hash_of_path_return_global(DERIVATION_TYPE_SECP256K1, &long_path);
+        CHECK_MEM(long_expected, entry->hash, HASH_SIZE);
+        CHECK_EQ(33, entry->public_key.length);
+    }
+    CHECK_EQ(before.misses + 2, global.key_cache.misses);
+    CHECK_EQ(before.hits, global.key_cache.hits);
+    CHECK_EQ(before.count, global.key_cache.count);
+    CHECK_MEM(before.entries, global.key_cache.entries, before.count * sizeof(before.entries[0]));
+
+    entry = public_key_hash_of_path_return_global(DERIVATION_TYPE_SECP256K1, &tezos_path);
+    CHECK_MEM(expected, entry->hash, HASH_SIZE);
+    CHECK_EQ(before.hits + 1, global.key_cache.hits);
+}
+
+void keys_tests(void) {
+    RUN(test_derivation);
+    RUN(test_signatures);
+    RUN(test_extended_public_key);
+    RUN(test_key_cache);
+}
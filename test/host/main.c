@@ -0,0 +1,99 @@
+// Unit test runner for the host build. Exits with a failure if any check failed.
+
+#include "test.h"
+
+#include "globals.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char const *current_test;
+static unsigned tests_run;
+static unsigned tests_failed;
+static bool current_failed;
+
+static void fail(char const *const file, int const line) {
+    if (!current_failed) tests_failed++;
+    current_failed = true;
+    printf("FAIL %s (%s:%d): ", current_test, file, line);
+}
+
+void check_true(bool const condition, char const *const what, char const *const file, int const line) {
+    if (condition) return;
+    fail(file, line);
+    printf("%s\n", what);
+}
+
+void check_equal(uint64_t const expected, uint64_t const actual, char const *const what, char const *const file, int const line) {
+    if (expected == actual) return;
+    fail(file, line);
+    printf("%s is %" PRIu64 " (0x%" PRIx64 "), expected %" PRIu64 " (0x%" PRIx64 ")\n",
+           what, actual, actual, expected, expected);
+}
+
+void check_string(char const *const expected, char const *const actual, char const *const what, char const *const file, int const line) {
+    if (strcmp(expected, actual) == 0) return;
+    fail(file, line);
+    printf("%s is \"%s\", expected \"%s\"\n", what, actual, expected);
+}
+
+void check_memory(
+    void const *const expected, void const *const actual, size_t const size,
+    char const *const what, char const *const file, int const line
+) {
+    if (memcmp(expected, actual, size) == 0) return;
+    fail(file, line);
+    printf("%s is ", what);
+    for (size_t i = 0; i < size; i++) printf("%02x", ((uint8_t const *)actual)[i]);
+    printf(", expected ");
+    for (size_t i = 0; i < size; i++) printf("%02x", ((uint8_t const *)expected)[i]);
+    printf("\n");
+}
+
+size_t from_hex(uint8_t *const out, size_t const out_size, char const *const hex) {
+    size_t const size = strlen(hex) / 2;
+    if (size > out_size) {
+        fprintf(stderr, "Hex string too long for its buffer: %s\n", hex);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (sscanf(hex + 2 * i, "%2hhx", &out[i]) != 1) {
+            fprintf(stderr, "Not a hex string: %s\n", hex);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return size;
+}
+
+void run_test(char const *const name, test_t const test) {
+    current_test = name;
+    current_failed = false;
+    tests_run++;
+    init_globals();
+
+    BEGIN_TRY {
+        TRY {
+            test();
+        }
+        CATCH_OTHER(e) {
+            fail(__FILE__, __LINE__);
+            printf("threw 0x%04x\n", e);
+        }
+        FINALLY {
+        }
+    }
+    END_TRY;
+}
+
+int main(void) {
+    to_string_tests();
+    keys_tests();
+    operations_tests();
+    apdu_sign_tests();
+    apdu_batch_pubkey_tests();
+
+    printf("%u of %u tests passed\n", tests_run - tests_failed, tests_run);
+    return tests_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
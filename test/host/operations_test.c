@@ -0,0 +1,262 @@
+#include "test.h"
+
+#include "globals.h"
+#include "keys.h"
+#include "operations.h"
+
+#include <string.h>
+
+#define G global.apdu.u.sign
+
+static bip32_path_t const signer_path = {
+    .length = 4,
+    .components = { 44 | BIP32_HARDENED_BIT, 1729 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT, 0 | BIP32_HARDENED_BIT },
+};
+
+// Operations are written into this as they would come from a wallet.
+static struct {
+    uint8_t bytes[512];
+    size_t length;
+} message;
+
+static void put(uint8_t const *const bytes, size_t const length) {
+    if (length > sizeof(message.bytes) - message.length) THROW(EXC_MEMORY_ERROR);
+    memcpy(&message.bytes[message.length], bytes, length);
+    message.length += length;
+}
+
+static void put_byte(uint8_t const byte) {
+    put(&byte, 1);
+}
+
+static void put_zarith(uint64_t value) {
+    do {
+        put_byte((value & 0x7f) | (value > 0x7f ? 0x80 : 0));
+        value >>= 7;
+    } while (value != 0);
+}
+
+static uint8_t const other_hash[HASH_SIZE] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+
+// Magic byte and branch
+static void start_message(void) {
+    message.length = 0;
+    put_byte(0x03);
+    for (size_t i = 0; i < 32; i++) put_byte(0xb0 + i);
+}
+
+static uint8_t const *signer_hash(void) {
+    return public_key_hash_of_path_return_global(DERIVATION_TYPE_ED25519, &signer_path)->hash;
+}
+
+static void put_manager_header(enum operation_tag const tag, uint64_t const fee, uint64_t const storage_limit) {
+    put_byte(tag);
+    put_byte(0x00); // tz1
+    put(signer_hash(), HASH_SIZE);
+    put_zarith(fee);
+    put_zarith(7); // counter
+    put_zarith(10600); // gas limit
+    put_zarith(storage_limit);
+}
+
+static void put_transaction(uint64_t const amount, bool const to_kt1) {
+    put_manager_header(OPERATION_TAG_BABYLON_TRANSACTION, 1420, 300);
+    put_zarith(amount);
+    if (to_kt1) {
+        put_byte(0x01);
+        put(other_hash, HASH_SIZE);
+        put_byte(0x00); // padding
+    } else {
+        put_byte(0x00);
+        put_byte(0x01); // tz2
+        put(other_hash, HASH_SIZE);
+    }
+    put_byte(0x00); // No parameters
+}
+
+static void put_reveal(void) {
+    put_manager_header(OPERATION_TAG_BABYLON_REVEAL, 1000, 0);
+    cx_ecfp_public_key_t const *const public_key = generate_public_key_return_global(DERIVATION_TYPE_ED25519, &signer_path);
+    put_byte(0x00); // Ed25519
+    put(public_key->W + 1, 32);
+}
+
+static bool allow_all(__attribute__((unused)) enum operation_kind kind) {
+    return true;
+}
+
+// Parses `message` as if it arrived in packets of `packet_size` bytes, which only the wallet does.
+static bool parse_message(struct parsed_operation_group *const out, size_t const packet_size) {
+#ifdef BAKING_APP
+    (void)packet_size;
+    return parse_operations(out, message.bytes, message.length, DERIVATION_TYPE_ED25519, &signer_path, allow_all);
+#else
+    parse_operations_init(out, DERIVATION_TYPE_ED25519, &signer_path, &G.parse_state);
+    for (size_t offset = 0; offset < message.length; offset += packet_size) {
+        size_t const size = message.length - offset < packet_size ? message.length - offset : packet_size;
+        if (!parse_operations_packet(out, &message.bytes[offset], size, allow_all)) return false;
+    }
+    return parse_operations_final(&G.parse_state, out);
+#endif
+}
+
+static size_t const packet_sizes[] = { 1, 7, 64, 230, sizeof(message.bytes) };
+
+static void test_transaction(void) {
+    for (size_t to_kt1 = 0; to_kt1 < 2; to_kt1++) {
+        for (size_t i = 0; i < NUM_ELEMENTS(packet_sizes); i++) {
+            start_message();
+            put_transaction(123456789, to_kt1);
+
+            struct parsed_operation_group out;
+            CHECK(parse_message(&out, packet_sizes[i]));
+            CHECK_EQ(OPERATION_KIND_TRANSACTION, out.operation.kind);
+            CHECK_EQ(123456789, out.operation.amount);
+            CHECK_EQ(1420, out.total_fee);
+            CHECK_EQ(300, out.total_storage_limit);
+            CHECK(!out.has_reveal);
+            CHECK_EQ(0, out.operation.source.originated);
+            CHECK_EQ(SIGNATURE_TYPE_ED25519, out.operation.source.signature_type);
+            CHECK_MEM(signer_hash(), out.operation.source.hash, HASH_SIZE);
+            CHECK_EQ(to_kt1, out.operation.destination.originated);
+            CHECK_EQ(to_kt1 ? SIGNATURE_TYPE_UNSET : SIGNATURE_TYPE_SECP256K1, out.operation.destination.signature_type);
+            CHECK_MEM(other_hash, out.operation.destination.hash, HASH_SIZE);
+        }
+    }
+}
+
+static void test_reveal_and_transaction(void) {
+    for (size_t i = 0; i < NUM_ELEMENTS(packet_sizes); i++) {
+        start_message();
+        put_reveal();
+        put_transaction(1, false);
+
+        struct parsed_operation_group out;
+        CHECK(parse_message(&out, packet_sizes[i]));
+        CHECK(out.has_reveal);
+        CHECK_EQ(OPERATION_KIND_TRANSACTION, out.operation.kind);
+        CHECK_EQ(2420, out.total_fee);
+        CHECK_EQ(300, out.total_storage_limit);
+    }
+}
+
+// An Athens transaction from an originated account, then a reveal, whose source mustn't replace the one displayed
+static void put_athens_transaction_and_reveal(void) {
+    start_message();
+    put_byte(OPERATION_TAG_ATHENS_TRANSACTION);
+    put_byte(0x01); // KT1
+    put(other_hash, HASH_SIZE);
+    put_byte(0x00); // padding
+    put_zarith(1420);
+    put_zarith(7); // counter
+    put_zarith(10600); // gas limit
+    put_zarith(300);
+    put_zarith(5);
+    put_byte(0x00);
+    put_byte(0x00); // tz1
+    put(signer_hash(), HASH_SIZE);
+    put_byte(0x00); // No parameters
+
+    put_byte(OPERATION_TAG_ATHENS_REVEAL);
+    put_byte(0x00); // Implicit
+    put_byte(0x00); // tz1
+    put(signer_hash(), HASH_SIZE);
+    put_zarith(1000);
+    put_zarith(8); // counter
+    put_zarith(10600); // gas limit
+    put_zarith(0);
+    cx_ecfp_public_key_t const *const public_key = generate_public_key_return_global(DERIVATION_TYPE_ED25519, &signer_path);
+    put_byte(0x00); // Ed25519
+    put(public_key->W + 1, 32);
+}
+
+static void test_reveal_after_operation(void) {
+    for (size_t i = 0; i < NUM_ELEMENTS(packet_sizes); i++) {
+        put_athens_transaction_and_reveal();
+
+        struct parsed_operation_group out;
+        CHECK(parse_message(&out, packet_sizes[i]));
+        CHECK(out.has_reveal);
+        CHECK_EQ(OPERATION_KIND_TRANSACTION, out.operation.kind);
+        CHECK_EQ(2420, out.total_fee);
+        CHECK_EQ(1, out.operation.source.originated);
+        CHECK_MEM(other_hash, out.operation.source.hash, HASH_SIZE);
+    }
+}
+
+#ifndef BAKING_APP
+// Fields are previewed once they are marked ready, so they must not change in later packets.
+static void test_ready_fields_are_final(void) {
+    put_athens_transaction_and_reveal();
+
+    struct parsed_operation_group out;
+    struct parsed_operation_group previewed;
+    parse_operations_init(&out, DERIVATION_TYPE_ED25519, &signer_path, &G.parse_state);
+    memset(&previewed, 0, sizeof(previewed));
+    for (size_t offset = 0; offset < message.length; offset++) {
+        CHECK(parse_operations_packet(&out, &message.bytes[offset], 1, allow_all));
+        CHECK_EQ(previewed.operation.ready_fields, out.operation.ready_fields & previewed.operation.ready_fields);
+        if (previewed.operation.ready_fields & 1) { // Source
+            CHECK_MEM(&previewed.operation.source, &out.operation.source, sizeof(out.operation.source));
+        }
+        if (previewed.operation.ready_fields & (1 << 6)) { // Destination
+            CHECK_MEM(&previewed.operation.destination, &out.operation.destination, sizeof(out.operation.destination));
+        }
+        previewed = out;
+    }
+    CHECK(parse_operations_final(&G.parse_state, &out));
+    CHECK_EQ(1, out.operation.source.originated);
+}
+#endif
+
+static void test_delegation(void) {
+    start_message();
+    put_manager_header(OPERATION_TAG_BABYLON_DELEGATION, 1257, 0);
+    put_byte(0xff); // Delegate present
+    put_byte(0x00);
+    put(signer_hash(), HASH_SIZE);
+
+    struct parsed_operation_group out;
+    CHECK(parse_message(&out, 10));
+    CHECK_EQ(OPERATION_KIND_DELEGATION, out.operation.kind);
+    CHECK_EQ(SIGNATURE_TYPE_ED25519, out.operation.destination.signature_type);
+    CHECK_MEM(signer_hash(), out.operation.destination.hash, HASH_SIZE);
+}
+
+static void test_parse_errors(void) {
+    struct parsed_operation_group out;
+
+    // Someone else's operation
+    start_message();
+    put_transaction(1, false);
+    message.bytes[1 + 32 + 1 + 1] ^= 1;
+    CHECK(!parse_message(&out, 16));
+
+    // Unknown operation
+    start_message();
+    put_byte(0xfe);
+    CHECK(!parse_message(&out, 16));
+
+    // Cut short
+    start_message();
+    put_transaction(1, false);
+    message.length--;
+    CHECK(!parse_message(&out, 16));
+
+    // More than one operation that isn't a reveal
+    start_message();
+    put_transaction(1, false);
+    put_transaction(1, false);
+    CHECK(!parse_message(&out, 16));
+}
+
+void operations_tests(void) {
+    RUN(test_transaction);
+    RUN(test_reveal_and_transaction);
+    RUN(test_reveal_after_operation);
+#ifndef BAKING_APP
+    RUN(test_ready_fields_are_final);
+#endif
+    RUN(test_delegation);
+    RUN(test_parse_errors);
+}
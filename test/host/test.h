@@ -0,0 +1,64 @@
+#pragma once
+
+// Checks for the unit tests in test/host, which `make host` builds with the app and runs.
+// A failed CHECK is reported and the test carries on; an exception that escapes a test fails it.
+
+#include "exception.h"
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHECK(condition) check_true((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQ(expected, actual) \
+    check_equal((uint64_t)(expected), (uint64_t)(actual), #actual, __FILE__, __LINE__)
+
+#define CHECK_STR(expected, actual) check_string((expected), (actual), #actual, __FILE__, __LINE__)
+
+#define CHECK_MEM(expected, actual, size) \
+    check_memory((expected), (actual), (size), #actual, __FILE__, __LINE__)
+
+// Runs `statement` and checks that it throws `exception`.
+#define CHECK_THROWS(exception, statement) do { \
+        volatile exception_t thrown_ = 0; \
+        BEGIN_TRY_L(check) { \
+            TRY_L(check) { \
+                statement; \
+            } \
+            CATCH_OTHER_L(check, e) { \
+                thrown_ = e; \
+            } \
+            FINALLY_L(check) { \
+            } \
+        } \
+        END_TRY_L(check); \
+        check_equal((exception), thrown_, "exception thrown by " #statement, __FILE__, __LINE__); \
+    } while (0)
+
+void check_true(bool condition, char const *what, char const *file, int line);
+void check_equal(uint64_t expected, uint64_t actual, char const *what, char const *file, int line);
+void check_string(char const *expected, char const *actual, char const *what, char const *file, int line);
+void check_memory(void const *expected, void const *actual, size_t size, char const *what, char const *file, int line);
+
+// Hex strings, for test data
+size_t from_hex(uint8_t *out, size_t out_size, char const *hex);
+
+// Checks a signature from `sign` with OpenSSL, which has nothing to do with how the host build makes them.
+bool verify_signature(
+    derivation_type_t derivation_type, cx_ecfp_public_key_t const *public_key,
+    uint8_t const *signature, size_t signature_size, uint8_t const *message, size_t message_size);
+
+typedef void (*test_t)(void);
+
+// Runs a test with freshly initialized globals.
+#define RUN(test) run_test(#test, (test))
+void run_test(char const *name, test_t test);
+
+// Each *_test.c runs its tests with RUN from one of these.
+void to_string_tests(void);
+void keys_tests(void);
+void operations_tests(void);
+void apdu_sign_tests(void);
+void apdu_batch_pubkey_tests(void);
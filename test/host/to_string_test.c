@@ -0,0 +1,135 @@
+#include "test.h"
+
+#include "base58.h"
+#include "to_string.h"
+
+#include <string.h>
+
+// Key hashes in these tests are the bytes 0 to 19.
+static void set_contract(parsed_contract_t *const out, uint8_t const originated, signature_type_t const signature_type) {
+    memset(out, 0, sizeof(*out));
+    out->originated = originated;
+    out->signature_type = signature_type;
+    for (size_t i = 0; i < HASH_SIZE; i++) out->hash[i] = i;
+}
+
+static void test_contract_to_string(void) {
+    static struct {
+        uint8_t originated;
+        signature_type_t signature_type;
+        char const *expected;
+    } const cases[] = {
+        { 0, SIGNATURE_TYPE_ED25519, "tz1Ke3u9SqxvnkdNkgaCmydXg3zh3iaKNDxw" },
+        { 0, SIGNATURE_TYPE_SECP256K1, "tz28KFsN3RPHiWGF2rd3ScbnDdFhZc4eQm3K" },
+        { 0, SIGNATURE_TYPE_SECP256R1, "tz3LL4pgwHWq78iYT7hJSa4A2z9DLSBZKozx" },
+        { 1, SIGNATURE_TYPE_UNSET, "KT18anmnvhqTsgqTwasxpLKYWcLJnGRX3m2D" },
+        { 0, SIGNATURE_TYPE_UNSET, "None" },
+    };
+    for (size_t i = 0; i < NUM_ELEMENTS(cases); i++) {
+        parsed_contract_t contract;
+        set_contract(&contract, cases[i].originated, cases[i].signature_type);
+        char buff[PKH_STRING_SIZE];
+        parsed_contract_to_string(buff, sizeof(buff), &contract);
+        CHECK_STR(cases[i].expected, buff);
+    }
+
+    parsed_contract_t contract;
+    set_contract(&contract, 0, SIGNATURE_TYPE_ED25519);
+    char too_short[PKH_STRING_SIZE - 1];
+    CHECK_THROWS(EXC_WRONG_LENGTH, parsed_contract_to_string(too_short, sizeof(too_short), &contract));
+}
+
+static void decode(uint8_t data[PKH_BASE58_DATA_SIZE], char const *const text) {
+    memset(data, 0, PKH_BASE58_DATA_SIZE);
+    CHECK(b58dec(data, PKH_BASE58_DATA_SIZE, text, strlen(text)));
+}
+
+static void test_pkh_from_base58_data(void) {
+    static struct {
+        char const *text;
+        signature_type_t signature_type;
+    } const cases[] = {
+        { "tz1Ke3u9SqxvnkdNkgaCmydXg3zh3iaKNDxw", SIGNATURE_TYPE_ED25519 },
+        { "tz28KFsN3RPHiWGF2rd3ScbnDdFhZc4eQm3K", SIGNATURE_TYPE_SECP256K1 },
+        { "tz3LL4pgwHWq78iYT7hJSa4A2z9DLSBZKozx", SIGNATURE_TYPE_SECP256R1 },
+        { "KT18anmnvhqTsgqTwasxpLKYWcLJnGRX3m2D", SIGNATURE_TYPE_UNSET },
+    };
+    parsed_contract_t expected;
+    set_contract(&expected, 0, SIGNATURE_TYPE_UNSET);
+
+    for (size_t i = 0; i < NUM_ELEMENTS(cases); i++) {
+        uint8_t data[PKH_BASE58_DATA_SIZE];
+        decode(data, cases[i].text);
+        signature_type_t signature_type = SIGNATURE_TYPE_ED25519 + 1;
+        uint8_t hash[HASH_SIZE];
+        CHECK(pkh_from_base58_data(&signature_type, hash, data));
+        CHECK_EQ(cases[i].signature_type, signature_type);
+        CHECK_MEM(expected.hash, hash, sizeof(hash));
+
+        data[PKH_BASE58_DATA_SIZE - 1] ^= 1; // Checksum
+        CHECK(!pkh_from_base58_data(&signature_type, hash, data));
+    }
+
+    // A checksummed block hash has a prefix that isn't a key hash's.
+    uint8_t data[PKH_BASE58_DATA_SIZE];
+    decode(data, "tz1Ke3u9SqxvnkdNkgaCmydXg3zh3iaKNDxw");
+    data[2] ^= 1;
+    signature_type_t signature_type;
+    uint8_t hash[HASH_SIZE];
+    CHECK(!pkh_from_base58_data(&signature_type, hash, data));
+}
+
+static void test_numbers(void) {
+    static struct {
+        uint64_t number;
+        char const *integer;
+        char const *microtez;
+    } const cases[] = {
+        { 0, "0", "0" },
+        { 1, "1", "0.000001" },
+        { 1000000, "1000000", "1" },
+        { 1234567, "1234567", "1.234567" },
+        { 1500000, "1500000", "1.5" },
+        { UINT64_MAX, "18446744073709551615", "18446744073709.551615" },
+    };
+    for (size_t i = 0; i < NUM_ELEMENTS(cases); i++) {
+        char buff[MAX_INT_DIGITS + 2];
+        CHECK_EQ(strlen(cases[i].integer), number_to_string(buff, cases[i].number));
+        CHECK_STR(cases[i].integer, buff);
+        microtez_to_string_indirect(buff, sizeof(buff), &cases[i].number);
+        CHECK_STR(cases[i].microtez, buff);
+    }
+}
+
+static void test_bip32_path_to_string(void) {
+    bip32_path_t const path = {
+        .length = 4,
+        .components = { 44 | BIP32_HARDENED_BIT, 1729 | BIP32_HARDENED_BIT, 0, 12 },
+    };
+    char buff[80];
+    bip32_path_to_string(buff, sizeof(buff), &path);
+    CHECK_STR("44'/1729'/0/12", buff);
+}
+
+static void test_named_delegates(void) {
+    uint8_t data[PKH_BASE58_DATA_SIZE];
+    decode(data, "tz1eY5Aqa1kXDFoiebL28emyXFoneAoVg1zh");
+    parsed_contract_t contract = { .originated = 0 };
+    CHECK(pkh_from_base58_data(&contract.signature_type, contract.hash, data));
+
+    char buff[VALUE_WIDTH + 1];
+    lookup_parsed_contract_name(buff, sizeof(buff), &contract);
+    CHECK_STR("Obsidian", buff);
+
+    set_contract(&contract, 0, SIGNATURE_TYPE_ED25519);
+    lookup_parsed_contract_name(buff, sizeof(buff), &contract);
+    CHECK_STR("Custom Delegate: please verify the address", buff);
+}
+
+void to_string_tests(void) {
+    RUN(test_contract_to_string);
+    RUN(test_pkh_from_base58_data);
+    RUN(test_numbers);
+    RUN(test_bip32_path_to_string);
+    RUN(test_named_delegates);
+}
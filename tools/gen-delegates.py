@@ -0,0 +1,224 @@
+#!/usr/bin/env python3
+"""Generates src/delegates.h from the baker registry.
+
+The table is made to take little flash, so that many bakers can be named:
+
+- Keys are 21 bytes, a `signature_type_t` followed by the 20-byte key hash, sorted for binary search.
+- Names are compressed with a dictionary of substrings shared between them. In a compressed name, bytes below
+  0x80 are themselves, 0x80 + i stands for dictionary word i, and 0xff is followed by a byte that is itself.
+- Names and dictionary words are found through offset tables, so they need no terminator or pointer.
+
+Usage: gen-delegates.py <registry json> <output header>
+"""
+
+import hashlib
+import json
+import sys
+
+B58_ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"
+
+# Base58 prefixes of implicit accounts and the matching `signature_type_t` values in types.h.
+PREFIXES = {
+    bytes([6, 161, 159]): 3,  # tz1, SIGNATURE_TYPE_ED25519
+    bytes([6, 161, 161]): 1,  # tz2, SIGNATURE_TYPE_SECP256K1
+    bytes([6, 161, 164]): 2,  # tz3, SIGNATURE_TYPE_SECP256R1
+}
+
+WORD_CODE = 0x80
+LITERAL_CODE = 0xFF
+MAX_WORDS = LITERAL_CODE - WORD_CODE
+MAX_WORD_LENGTH = 16
+
+
+def fail(message):
+    sys.exit(message)
+
+
+def decode_address(address):
+    number = 0
+    for char in address:
+        digit = B58_ALPHABET.find(char)
+        if digit < 0:
+            fail("Invalid character in " + address)
+        number = number * 58 + digit
+    if number >= 1 << (27 * 8):
+        fail(address + " is too long")
+    data = number.to_bytes(27, "big")
+
+    checksum = hashlib.sha256(hashlib.sha256(data[:23]).digest()).digest()[:4]
+    if checksum != data[23:]:
+        fail("Bad checksum in " + address)
+    if data[:3] not in PREFIXES:
+        fail(address + " is not an implicit account")
+    return bytes([PREFIXES[data[:3]]]) + data[3:23]
+
+
+def word_gain(count, length):
+    # Each use saves all but one byte, and the word itself costs its bytes and a 2-byte offset.
+    return count * (length - 1) - length - 2
+
+
+def count_words(names):
+    """Counts the non-overlapping uses of every substring of the uncompressed runs of the names."""
+    counts = {}
+    for tokens in names:
+        run = []
+        for token in tokens + [None]:
+            if isinstance(token, str):
+                run.append(token)
+                continue
+            text = "".join(run)
+            run = []
+            for length in range(2, min(MAX_WORD_LENGTH, len(text)) + 1):
+                last = {}
+                for start in range(len(text) - length + 1):
+                    word = text[start:start + length]
+                    if any(ord(char) >= 0x80 for char in word):
+                        continue  # Dictionary words are stored as they are, so they can't have escapes
+                    if last.get(word, -length) + length <= start:
+                        last[word] = start
+                        counts[word] = counts.get(word, 0) + 1
+    return counts
+
+
+def substitute(tokens, word, index):
+    """Replaces the uses of `word` in the uncompressed runs of a name with dictionary word `index`."""
+    out = []
+    i = 0
+    while i < len(tokens):
+        if all(isinstance(t, str) for t in tokens[i:i + len(word)]) and "".join(tokens[i:i + len(word)]) == word:
+            out.append(index)
+            i += len(word)
+        else:
+            out.append(tokens[i])
+            i += 1
+    return out
+
+
+def build_dictionary(names):
+    """Greedily picks the words that save the most bytes, up to MAX_WORDS of them."""
+    tokenized = [list(name) for name in names]
+    words = []
+    while len(words) < MAX_WORDS:
+        counts = count_words(tokenized)
+        best = max(counts.items(), key=lambda item: (word_gain(item[1], len(item[0])), item[0]), default=None)
+        if best is None or word_gain(best[1], len(best[0])) <= 0:
+            break
+        tokenized = [substitute(tokens, best[0], len(words)) for tokens in tokenized]
+        words.append(best[0])
+    return words, tokenized
+
+
+def encode_text(text):
+    out = bytearray()
+    for byte in text.encode("utf-8"):
+        if byte >= WORD_CODE:
+            out.append(LITERAL_CODE)
+        out.append(byte)
+    return bytes(out)
+
+
+def encode_name(tokens):
+    out = bytearray()
+    for token in tokens:
+        out += bytes([WORD_CODE + token]) if isinstance(token, int) else encode_text(token)
+    return bytes(out)
+
+
+def c_string(data):
+    """A C string literal of `data`, split so that no hex escape runs into the character after it."""
+    out = '"'
+    hex_escape = False
+    for byte in data:
+        char = chr(byte)
+        if 0x20 <= byte < 0x7F and char not in '"\\?':
+            if hex_escape and char in "0123456789abcdefABCDEF":
+                out += '" "'
+            out += char
+            hex_escape = False
+        else:
+            out += "\\x%02x" % byte
+            hex_escape = True
+    return out + '"'
+
+
+def c_words(values):
+    lines = []
+    for start in range(0, len(values), 12):
+        lines.append("  " + " ".join("%d," % v for v in values[start:start + 12]))
+    return "\n".join(lines)
+
+
+def main():
+    if len(sys.argv) != 3:
+        fail("Usage: gen-delegates.py <registry json> <output header>")
+    with open(sys.argv[1], encoding="utf-8") as registry_file:
+        registry = json.load(registry_file)
+
+    delegates = {}
+    for baker in registry:
+        key = decode_address(baker["bakerAccount"])
+        if key in delegates:
+            # The first name is the one that was always shown.
+            print("Ignoring duplicate baker %s (%s)" % (baker["bakerAccount"], baker["bakerName"]), file=sys.stderr)
+            continue
+        delegates[key] = baker["bakerName"]
+    keys = sorted(delegates)
+    if not keys:
+        fail("No bakers in " + sys.argv[1])
+
+    words, tokenized = build_dictionary([delegates[key] for key in keys])
+    names = [encode_name(tokens) for tokens in tokenized]
+    encoded_words = [word.encode("ascii") for word in words]
+
+    name_offsets = [0]
+    for name in names:
+        name_offsets.append(name_offsets[-1] + len(name))
+    word_offsets = [0]
+    for word in encoded_words:
+        word_offsets.append(word_offsets[-1] + len(word))
+    if name_offsets[-1] > 0xFFFF:
+        fail("Too many names for 16-bit offsets")
+
+    flash = len(keys) * 21 + 2 * len(name_offsets) + name_offsets[-1] + 2 * len(word_offsets) + word_offsets[-1]
+    plain = sum(len(delegates[key].encode("utf-8")) for key in keys)
+
+    out = []
+    out.append("#pragma once\n")
+    out.append('#include "types.h"\n#include "os.h"\n')
+    out.append("// This file is generated by the ./tools/gen-delegates.sh script.")
+    out.append("// %d bakers in %d bytes; the names take %d bytes, %d uncompressed.\n"
+               % (len(keys), flash, name_offsets[-1] + 2 * len(word_offsets) + word_offsets[-1], plain))
+    out.append("#define NAMED_DELEGATE_COUNT %d" % len(keys))
+    out.append("#define NAMED_DELEGATE_KEY_SIZE (1 + HASH_SIZE) // signature_type_t, then the key hash")
+    out.append("#define DELEGATE_NAME_WORD_CODE 0x%02x // 0x80 + i is dictionary word i" % WORD_CODE)
+    out.append("#define DELEGATE_NAME_LITERAL_CODE 0x%02x // The next byte is itself\n" % LITERAL_CODE)
+    out.append("// Sorted")
+    out.append("static const uint8_t named_delegate_keys[NAMED_DELEGATE_COUNT][NAMED_DELEGATE_KEY_SIZE] = {")
+    for key in keys:
+        out.append("  { %s }," % " ".join("0x%02x," % b for b in key))
+    out.append("};\n")
+    out.append("// Name i is named_delegate_names[named_delegate_name_offsets[i]] up to the next offset")
+    out.append("static const uint16_t named_delegate_name_offsets[NAMED_DELEGATE_COUNT + 1] = {")
+    out.append(c_words(name_offsets))
+    out.append("};\n")
+    out.append("static const uint8_t named_delegate_names[] =")
+    for key, name in zip(keys, names):
+        out.append("  %s // %s" % (c_string(name), c_string(delegates[key].encode("utf-8"))))
+    out.append(";\n")
+    out.append("static const uint16_t delegate_name_word_offsets[] = {")
+    out.append(c_words(word_offsets))
+    out.append("};\n")
+    out.append("static const uint8_t delegate_name_words[] =")
+    for word in encoded_words:
+        out.append("  %s" % c_string(word))
+    if not encoded_words:
+        out.append('  ""')
+    out.append(";")
+
+    with open(sys.argv[2], "w", encoding="utf-8") as header:
+        header.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
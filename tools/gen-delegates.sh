@@ -1,4 +1,3 @@
-
 # root="$(cd "$(dirname "${BASH_SOURCE[0]}")" && git rev-parse --show-toplevel)"
 root="."
 
@@ -13,25 +12,4 @@ if [ $# -gt 0 ]; then
     exit 1
 fi
 
-delegates="$(jq -r '.[] | .bakerName, .bakerAccount' < $registry_json | \
-  while read -r name; read -r account; do \
-    echo "  { .bakerAccount = \"$account\", .bakerName = \"$name\" },"; \
-  done)"
-
-cat > "$root"/src/delegates.h <<EOF
-#pragma once
-
-#include "types.h"
-#include "os.h"
-
-// This file is generated by the ./tools/gen-delegates.sh script.
-
-typedef struct {
-  uint8_t bakerAccount[HASH_SIZE_B58];
-  char* bakerName;
-} named_delegate_t;
-
-static const named_delegate_t named_delegates[] = {
-$delegates
-};
-EOF
+exec python3 "$root"/tools/gen-delegates.py "$registry_json" "$root"/src/delegates.h
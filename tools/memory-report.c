@@ -0,0 +1,35 @@
+// Built by `make memory-report` with the same flags as the app. Each symbol defined here is exactly as
+// large as the part of `global` it is named after, so the sizes for the current target can be read back
+// with nm without running anything on the device. `__` in a symbol name stands for a `.` in the path.
+
+#include "globals.h"
+
+#define REPORT(name, member) \
+    __attribute__((used)) char const memory_report__##name[sizeof(((globals_t *)0)->member)] = {0}
+
+__attribute__((used)) char const memory_report__global[sizeof(globals_t)] = {0};
+
+REPORT(stack_root, stack_root);
+REPORT(handlers, handlers);
+REPORT(ui, ui);
+REPORT(ui__prompt, ui.prompt);
+REPORT(key_cache, key_cache);
+REPORT(apdu, apdu);
+REPORT(apdu__u, apdu.u);
+REPORT(apdu__u__pubkey, apdu.u.pubkey);
+REPORT(apdu__u__sign, apdu.u.sign);
+REPORT(apdu__u__batch_pubkey, apdu.u.batch_pubkey);
+REPORT(apdu__u__sign__hash_state, apdu.u.sign.hash_state);
+REPORT(apdu__u__sign__message_data, apdu.u.sign.message_data);
+REPORT(apdu__u__sign__maybe_ops, apdu.u.sign.maybe_ops);
+REPORT(apdu__u__sign__parse_state, apdu.u.sign.parse_state);
+#ifdef BAKING_APP
+REPORT(apdu__u__sign__parsed_baking_data, apdu.u.sign.parsed_baking_data);
+REPORT(apdu__u__baking, apdu.u.baking);
+REPORT(apdu__u__setup, apdu.u.setup);
+REPORT(apdu__u__hmac, apdu.u.hmac);
+REPORT(apdu__baking_auth, apdu.baking_auth);
+#else
+REPORT(apdu__u__sign__packed_data, apdu.u.sign.packed_data);
+#endif
+REPORT(apdu__priv, apdu.priv);
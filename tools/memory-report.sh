@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+# Prints the sizes recorded in an object built from tools/memory-report.c and fails if `global` is
+# larger than the budget.
+#
+# Usage: memory-report.sh <nm> <object> <budget in bytes>
+set -Eeuo pipefail
+
+nm="$1"
+object="$2"
+budget="$3"
+
+total=
+while read -r _ size _ symbol; do
+    member="$(echo "${symbol#memory_report__}" | sed 's/__/./g')"
+    bytes=$((16#$size))
+    printf '%-40s %6d\n' "$member" "$bytes"
+    if [ "$member" = global ]; then total=$bytes; fi
+done < <("$nm" -S --defined-only "$object" | grep ' memory_report__' | sort -k4)
+
+if [ -z "$total" ]; then
+    echo "No size recorded for global in $object" >&2
+    exit 1
+fi
+if [ "$total" -gt "$budget" ]; then
+    echo "global takes $total bytes, over the budget of $budget bytes" >&2
+    exit 1
+fi
+echo "global takes $total of $budget bytes"